@@ -44,7 +44,10 @@
 #include "LLVMSPIRVOpts.h"
 
 #include <iostream>
+#include <map>
+#include <memory>
 #include <string>
+#include <vector>
 
 namespace llvm {
 // Pass initialization functions need to be declared before inclusion of
@@ -67,31 +70,31 @@ void initializePreprocessMetadataLegacyPass(PassRegistry &);
 class ModulePass;
 } // namespace llvm
 
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Module.h"
 
 namespace SPIRV {
 
 class SPIRVModule;
+struct TranslationStats;
 
 /// \brief Check if a string contains SPIR-V binary.
 bool isSpirvBinary(const std::string &Img);
 
 #ifdef _SPIRV_SUPPORT_TEXT_FMT
 /// \brief Convert SPIR-V between binary and internal textual formats.
-/// This function is not thread safe and should not be used in multi-thread
-/// applications unless guarded by a critical section.
 /// \returns true if succeeds.
 bool convertSpirv(std::istream &IS, std::ostream &OS, std::string &ErrMsg,
                   bool FromText, bool ToText);
 
 /// \brief Convert SPIR-V between binary and internal text formats.
-/// This function is not thread safe and should not be used in multi-thread
-/// applications unless guarded by a critical section.
 bool convertSpirv(std::string &Input, std::string &Out, std::string &ErrMsg,
                   bool ToText);
 
 /// \brief Check if a string contains SPIR-V in internal text format.
-bool isSpirvText(std::string &Img);
+bool isSpirvText(const std::string &Img);
 #endif
 
 /// \brief Load SPIR-V from istream as a SPIRVModule.
@@ -105,6 +108,21 @@ std::unique_ptr<SPIRVModule> readSpirvModule(std::istream &IS,
                                              const SPIRV::TranslatorOpts &Opts,
                                              std::string &ErrMsg);
 
+/// \brief Link SPIR-V modules into a new SPIRVModule, as linkSpirv does for
+/// their binaries.
+/// \returns null on failure.
+std::unique_ptr<SPIRVModule>
+linkSpirvModules(llvm::ArrayRef<SPIRVModule *> Modules, std::string &ErrMsg);
+
+/// \brief Check if the library was built with LLVM_SPIRV_ENABLE_TRACE, i.e.
+/// SPIR-V modules record a trace event per decoded and encoded instruction.
+bool isSpirvTraceEnabled();
+
+/// \brief Make every SPIR-V module destroyed on the current thread write its
+/// trace events to \p OS as a JSON object on a line of its own. Pass null to
+/// stop. Has no effect unless isSpirvTraceEnabled() returns true.
+void setSpirvTraceStream(std::ostream *OS);
+
 } // End namespace SPIRV
 
 namespace llvm {
@@ -119,15 +137,96 @@ bool readSpirv(LLVMContext &C, std::istream &IS, Module *&M,
                std::string &ErrMsg);
 
 /// \brief Translate LLVM module to SPIR-V and write to ostream.
+/// If Opts.getTranslationCacheDir() is set, the result is looked up in and
+/// stored to that cache, keyed by the bitcode of \p M and the options. On a
+/// cache hit \p M is not modified by the translation passes.
 /// \returns true if succeeds.
 bool writeSpirv(Module *M, const SPIRV::TranslatorOpts &Opts, std::ostream &OS,
                 std::string &ErrMsg);
 
 /// \brief Load SPIR-V from istream and translate to LLVM module.
+/// If Opts.getTranslationCacheDir() is set, the resulting bitcode is looked
+/// up in and stored to that cache, keyed by the input and the options.
 /// \returns true if succeeds.
 bool readSpirv(LLVMContext &C, const SPIRV::TranslatorOpts &Opts,
                std::istream &IS, Module *&M, std::string &ErrMsg);
 
+/// \brief Translate LLVM module to SPIR-V and write to ostream, adding the
+/// time spent in each phase and the module counters to \p Stats.
+/// \returns true if succeeds.
+bool writeSpirv(Module *M, const SPIRV::TranslatorOpts &Opts, std::ostream &OS,
+                std::string &ErrMsg, SPIRV::TranslationStats &Stats);
+
+/// \brief Load SPIR-V from istream and translate to LLVM module, adding the
+/// time spent in each phase and the module counters to \p Stats.
+/// \returns true if succeeds.
+bool readSpirv(LLVMContext &C, const SPIRV::TranslatorOpts &Opts,
+               std::istream &IS, Module *&M, std::string &ErrMsg,
+               SPIRV::TranslationStats &Stats);
+
+/// \brief Translate LLVM module to SPIR-V and split debug info into a
+/// sidecar module. The complete SPIR-V module is written to \p DebugOS.
+/// The same module without debug instructions is written to \p OS. It
+/// references the sidecar by an OpModuleProcessed instruction with the
+/// string "debug-sidecar:xxh64:<hash>", where <hash> is the xxHash64 of
+/// the sidecar module in 16 hexadecimal digits. Only binary output is
+/// supported.
+/// \returns true if succeeds.
+bool writeSpirv(Module *M, const SPIRV::TranslatorOpts &Opts, std::ostream &OS,
+                std::ostream &DebugOS, std::string &ErrMsg);
+
+/// \brief How writeSpirvSplit distributes kernels over SPIR-V modules.
+enum class SpirvSplitMode {
+  /// One module per kernel.
+  PerKernel,
+  /// One module per value of a function attribute. Kernels without the
+  /// attribute share the module of the empty value.
+  ByAttribute
+};
+
+/// \brief A SPIR-V module produced by writeSpirvSplit.
+struct SpirvSplit {
+  /// Name of the kernel, or the attribute value shared by the kernels.
+  std::string Name;
+  /// Names of the kernels defined by the module.
+  std::vector<std::string> Kernels;
+  /// The SPIR-V module, in the format selected by Opts.
+  std::string Binary;
+};
+
+/// \brief Translate LLVM module to several SPIR-V modules, splitting its
+/// kernels according to \p Mode. The regularization passes run once on the
+/// whole module. Each SPIR-V module then holds the kernels of its split, the
+/// functions they call, and the global variables, annotations, execution
+/// modes and debug info of global variables these reference. \p Attribute
+/// names the function attribute used by SpirvSplitMode::ByAttribute. Splits
+/// are ordered by their first kernel in \p M.
+/// \returns true if succeeds.
+bool writeSpirvSplit(Module *M, const SPIRV::TranslatorOpts &Opts,
+                     SpirvSplitMode Mode, const std::string &Attribute,
+                     std::vector<SpirvSplit> &Splits, std::string &ErrMsg);
+
+/// \brief An LLVM module translated from a part of a SPIR-V module by
+/// readSpirvShards.
+struct SpirvShard {
+  /// The context owning the module.
+  std::unique_ptr<LLVMContext> Context;
+  std::unique_ptr<Module> M;
+};
+
+/// \brief Load SPIR-V from istream and translate it to at most \p NumShards
+/// LLVM modules, each in its own context, on as many threads. Every function
+/// definition is translated into one shard, and the other shards declare
+/// the function if they reference it. Functions which are neither exported
+/// nor entry points, and global variables with internal or LinkOnceODR
+/// linkage, are defined in the shard of the functions referencing them.
+/// The shards can be linked together; module-level metadata is repeated in
+/// each of them. Modules with debug info are only translated to one shard.
+/// \returns true if succeeds.
+bool readSpirvShards(const SPIRV::TranslatorOpts &Opts, std::istream &IS,
+                     unsigned NumShards, std::vector<SpirvShard> &Shards,
+                     std::string &ErrMsg);
+
 /// \brief Partially load SPIR-V from the stream and decode only instructions
 /// needed to get information about specialization constants.
 /// \returns true if succeeds.
@@ -135,6 +234,75 @@ using SpecConstInfoTy = std::pair<uint32_t, uint32_t>;
 bool getSpecConstInfo(std::istream &IS,
                       std::vector<SpecConstInfoTy> &SpecConstInfo);
 
+/// \brief Interface of a kernel parameter, as described by the SPIR-V module.
+struct SpirvKernelArgInfo {
+  /// Name of the parameter, empty if the module doesn't name it.
+  std::string Name;
+  /// OpenCL C type name recorded in the kernel_arg_type OpString, empty if
+  /// the module has no such string.
+  std::string TypeName;
+  /// Opcode of the parameter type (spv::Op), e.g. OpTypePointer.
+  uint32_t TypeOpCode = 0;
+  /// Storage class (spv::StorageClass) for pointer parameters, ~0U otherwise.
+  uint32_t StorageClass = ~0U;
+  /// Access qualifier (spv::AccessQualifier) for image and pipe parameters,
+  /// ~0U if there is none.
+  uint32_t AccessQualifier = ~0U;
+  /// FuncParamAttr decorations (spv::FunctionParameterAttribute).
+  std::vector<uint32_t> Attributes;
+};
+
+/// \brief Interface of a kernel entry point.
+struct SpirvKernelInfo {
+  std::string Name;
+  std::vector<SpirvKernelArgInfo> Args;
+  /// Literal operands of OpExecutionMode, keyed by spv::ExecutionMode.
+  std::map<uint32_t, std::vector<uint32_t>> ExecutionModes;
+  /// LocalSize execution mode, all zeros if absent.
+  uint32_t ReqdWorkGroupSize[3] = {0, 0, 0};
+  /// SubgroupSize execution mode, zero if absent.
+  uint32_t SubgroupSize = 0;
+};
+
+/// \brief Kernel interface and requirements of a SPIR-V module.
+struct SpirvModuleInfo {
+  /// Declared capabilities (spv::Capability).
+  std::vector<uint32_t> Capabilities;
+  std::vector<std::string> Extensions;
+  std::vector<SpirvKernelInfo> Kernels;
+};
+
+/// \brief Partially load SPIR-V from the stream and decode only the
+/// instructions needed to describe its kernels: the global sections and the
+/// OpFunction/OpFunctionParameter headers of kernel entry points. Function
+/// bodies are skipped and nothing is translated to LLVM.
+/// \returns true if succeeds.
+bool getSpirvModuleInfo(std::istream &IS, SpirvModuleInfo &Info);
+
+/// \brief Apply specialization constant values to a SPIR-V binary without
+/// translating it. OpSpecConstant, OpSpecConstantTrue and OpSpecConstantFalse
+/// are rewritten to OpConstant, OpConstantTrue and OpConstantFalse, using the
+/// value given in \p SpecConsts for their SpecId or the default value
+/// otherwise, and SpecId decorations are dropped. OpSpecConstantOp over
+/// integer and boolean scalars is folded to a constant, and
+/// OpSpecConstantComposite whose constituents are all constants becomes
+/// OpConstantComposite. Anything else is kept as is. The words of \p In are
+/// processed in a single pass and the result is written to \p Out.
+/// \returns true if succeeds.
+bool specializeSpirv(ArrayRef<uint32_t> In,
+                     const std::map<uint32_t, uint64_t> &SpecConsts,
+                     SmallVectorImpl<uint32_t> &Out);
+
+/// \brief Link SPIR-V binaries without translating them. Ids of all modules
+/// are renumbered into one id space, identical types and constants are
+/// unified, and functions and variables imported by one module are resolved
+/// to the definitions exported by another, which must have the same type.
+/// Capabilities, extensions and extended instruction set imports are merged.
+/// Imports without a definition are kept, so the result can be linked again.
+/// \returns true if succeeds.
+bool linkSpirv(ArrayRef<ArrayRef<uint32_t>> Inputs,
+               SmallVectorImpl<uint32_t> &Out, std::string &ErrMsg);
+
 /// \brief Convert a SPIRVModule into LLVM IR.
 /// \returns null on failure.
 std::unique_ptr<Module>
@@ -217,4 +385,93 @@ ModulePass *createSPIRVWriterPass(std::ostream &Str,
 
 } // namespace llvm
 
+namespace SPIRV {
+
+/// \brief Hit/miss counters of the on-disk translation cache, accumulated
+/// over all translations in the process.
+struct TranslationCacheStats {
+  uint64_t Hits = 0;
+  uint64_t Misses = 0;
+};
+
+TranslationCacheStats getTranslationCacheStats();
+void resetTranslationCacheStats();
+
+/// \brief Time spent in the phases of translations and counters of the
+/// translated modules. Values are added up over all translations the stats
+/// were passed to.
+struct TranslationStats {
+  /// Wall clock seconds per phase, in the order phases first completed.
+  /// Phases may nest: "encode" includes "topological-sort".
+  std::vector<std::pair<std::string, double>> PhaseSeconds;
+  /// Instructions decoded from or encoded to SPIR-V.
+  uint64_t Instructions = 0;
+  /// Id bound of the SPIR-V modules.
+  uint64_t Ids = 0;
+  uint64_t Types = 0;
+  uint64_t Constants = 0;
+  /// Lookups of builtin function name information served from a cache and
+  /// computed by demangling.
+  uint64_t BuiltinNameHits = 0;
+  uint64_t BuiltinNameMisses = 0;
+  /// Size of the input and output. Only the SPIR-V side is known to
+  /// readSpirv/writeSpirv; the bitcode side is left for the caller to fill.
+  uint64_t BytesIn = 0;
+  uint64_t BytesOut = 0;
+
+  /// Add \p Seconds to phase \p Name.
+  void addPhase(const std::string &Name, double Seconds);
+  /// \returns seconds spent in phase \p Name, 0 if it never ran.
+  double getPhaseSeconds(const std::string &Name) const;
+  /// Write the stats as a JSON object.
+  void dumpJSON(std::ostream &OS) const;
+};
+
+class TranslatorSessionImpl;
+
+/// \brief Hit/miss counters of the caches owned by a TranslatorSession.
+struct TranslatorSessionStats {
+  /// Number of translations run through the session.
+  uint64_t Translations = 0;
+  /// Lookups of builtin function name information.
+  uint64_t BuiltinNameHits = 0;
+  uint64_t BuiltinNameMisses = 0;
+  /// Number of function names currently cached.
+  uint64_t BuiltinNamesCached = 0;
+};
+
+/// \brief Translates many modules with the same options. Information which
+/// only depends on function names (demangled builtin names, SPIR-V opcodes
+/// and extended instructions they map to) is cached for the whole lifetime of
+/// the session instead of one translation, and is shared by writeSpirv and
+/// readSpirv. Methods can be called concurrently
+/// from several threads as long as each thread uses its own LLVMContext.
+class TranslatorSession {
+public:
+  explicit TranslatorSession(const TranslatorOpts &Opts);
+  ~TranslatorSession();
+  TranslatorSession(const TranslatorSession &) = delete;
+  TranslatorSession &operator=(const TranslatorSession &) = delete;
+
+  const TranslatorOpts &getOpts() const { return Opts; }
+
+  /// \brief Translate LLVM module to SPIR-V and write to ostream.
+  /// \returns true if succeeds.
+  bool writeSpirv(llvm::Module *M, std::ostream &OS, std::string &ErrMsg);
+
+  /// \brief Load SPIR-V from istream and translate to LLVM module.
+  /// \returns true if succeeds.
+  bool readSpirv(llvm::LLVMContext &C, std::istream &IS, llvm::Module *&M,
+                 std::string &ErrMsg);
+
+  TranslatorSessionStats getStats() const;
+  void resetStats();
+
+private:
+  const TranslatorOpts Opts;
+  std::unique_ptr<TranslatorSessionImpl> Impl;
+};
+
+} // namespace SPIRV
+
 #endif // SPIRV_H
@@ -46,7 +46,9 @@
 #include <cassert>
 #include <cstdint>
 #include <map>
+#include <string>
 #include <unordered_map>
+#include <vector>
 
 namespace llvm {
 class IntrinsicInst;
@@ -81,6 +83,12 @@ enum class FPContractMode : uint32_t { On, Off, Fast };
 
 enum class DebugInfoEIS : uint32_t { SPIRV_Debug, OpenCL_DebugInfo_100 };
 
+// Enable assert or exit on error
+enum class SPIRVDbgErrorHandlingKinds { Abort, Exit, Ignore };
+
+// Controls when the LLVM module is verified during translation
+enum class VerificationLevel : uint32_t { None, Final, PerPass };
+
 /// \brief Helper class to manage SPIR-V translation
 class TranslatorOpts {
 public:
@@ -136,6 +144,11 @@ public:
     return true;
   }
 
+  const std::unordered_map<uint32_t, uint64_t> &
+  getExternalSpecialization() const {
+    return ExternalSpecialization;
+  }
+
   void setDesiredBIsRepresentation(BIsRepresentation Value) {
     DesiredRepresentationOfBIs = Value;
   }
@@ -150,6 +163,7 @@ public:
 
   bool isUnknownIntrinsicAllowed(llvm::IntrinsicInst *II) const noexcept;
   bool isSPIRVAllowUnknownIntrinsicsEnabled() const noexcept;
+  ArgList getSPIRVAllowUnknownIntrinsics() const noexcept;
   void setSPIRVAllowUnknownIntrinsics(ArgList IntrinsicPrefixList) noexcept;
 
   bool allowExtraDIExpressions() const noexcept {
@@ -172,6 +186,69 @@ public:
     ReplaceLLVMFmulAddWithOpenCLMad = Value;
   }
 
+  bool shouldSkipDebugInfo() const noexcept { return SkipDebugInfo; }
+
+  void setSkipDebugInfo(bool Skip) noexcept { SkipDebugInfo = Skip; }
+
+  bool isSPIRVTextFormat() const noexcept { return SPIRVTextFormat; }
+
+  void setSPIRVTextFormat(bool Text) noexcept { SPIRVTextFormat = Text; }
+
+  SPIRVDbgErrorHandlingKinds getErrorHandling() const noexcept {
+    return ErrorHandling;
+  }
+
+  void setErrorHandling(SPIRVDbgErrorHandlingKinds Kind) noexcept {
+    ErrorHandling = Kind;
+  }
+
+  bool isErrorMsgSourceInfoEnabled() const noexcept {
+    return ErrorMsgIncludesSourceInfo;
+  }
+
+  void setErrorMsgSourceInfoEnabled(bool Enable) noexcept {
+    ErrorMsgIncludesSourceInfo = Enable;
+  }
+
+  VerificationLevel getVerificationLevel() const noexcept {
+    return Verification;
+  }
+
+  void setVerificationLevel(VerificationLevel Level) noexcept {
+    Verification = Level;
+  }
+
+  bool shouldStreamFunctionBodies() const noexcept {
+    return StreamFunctionBodies;
+  }
+
+  void setStreamFunctionBodies(bool Stream) noexcept {
+    StreamFunctionBodies = Stream;
+  }
+
+  const std::string &getTranslationCacheDir() const noexcept {
+    return TranslationCacheDir;
+  }
+
+  void setTranslationCacheDir(const std::string &Dir) {
+    TranslationCacheDir = Dir;
+  }
+
+  uint64_t getTranslationCacheMaxSize() const noexcept {
+    return TranslationCacheMaxSize;
+  }
+
+  void setTranslationCacheMaxSize(uint64_t Bytes) noexcept {
+    TranslationCacheMaxSize = Bytes;
+  }
+
+  // Stable hash of the options that affect the result of a translation, of
+  // the version and build of the translator and of the command line options
+  // returned by getNonDefaultTranslationFlags. Options that only change how
+  // errors are reported or verified, and the translation cache settings, are
+  // not included.
+  uint64_t getFingerprint() const;
+
 private:
   // Common translation options
   VersionNumber MaxVersion = VersionNumber::MaximumVersion;
@@ -208,8 +285,55 @@ private:
   // Controls whether llvm.fmuladd.* should be replaced with mad from OpenCL
   // extended instruction set or with a simple fmul + fadd
   bool ReplaceLLVMFmulAddWithOpenCLMad = true;
+
+  // Don't decode OpLine, OpNoLine, OpSourceContinued and instructions of the
+  // debug info extended instruction sets when reading SPIR-V
+  bool SkipDebugInfo = false;
+
+  // Read and write SPIR-V in the internal textual format instead of binary
+  bool SPIRVTextFormat = false;
+
+  // Controls what happens when the translator detects an error
+  SPIRVDbgErrorHandlingKinds ErrorHandling = SPIRVDbgErrorHandlingKinds::Exit;
+
+  // Include source file and line number of the failed check in error messages
+  bool ErrorMsgIncludesSourceInfo = true;
+
+  // Controls when the LLVM module is verified:
+  //
+  // - VerificationLevel::None disables verification
+  //
+  // - VerificationLevel::Final verifies the result of SPIR-V to LLVM
+  //   translation only
+  //
+  // - VerificationLevel::PerPass also verifies the module after each LLVM
+  //   pass of the translation and fails at the first pass producing an
+  //   invalid module
+  VerificationLevel Verification = VerificationLevel::Final;
+
+  // Encode each function body as soon as it is translated to SPIR-V and free
+  // its instructions, so that the memory used by a translation to SPIR-V
+  // does not grow with the size of the function bodies. Modules with debug
+  // info are written as usual. The result does not depend on this option.
+  bool StreamFunctionBodies = false;
+
+  // Directory of the on-disk cache of translation results. The cache is
+  // disabled if it is empty. Cached LLVM modules are verified like fresh
+  // ones. Cached SPIR-V modules are not reused with
+  // VerificationLevel::PerPass, which verifies the passes of the
+  // translation; new results are stored at every level.
+  std::string TranslationCacheDir;
+
+  // Size limit of the translation cache directory in bytes. Least recently
+  // used entries are removed once it is exceeded.
+  uint64_t TranslationCacheMaxSize = 512 * 1024 * 1024;
 };
 
+/// \brief Command line options of the library which change the translation
+/// result but are not part of TranslatorOpts, as "name=value" strings, for
+/// those set to a value other than their default.
+std::vector<std::string> getNonDefaultTranslationFlags();
+
 } // namespace SPIRV
 
 #endif // SPIRV_LLVMSPIRVOPTS_H
@@ -43,11 +43,42 @@
 #include <llvm/ADT/Optional.h>
 #include <llvm/ADT/SmallVector.h>
 #include <llvm/ADT/StringRef.h>
+#include <llvm/Config/llvm-config.h>
 #include <llvm/IR/IntrinsicInst.h>
+#include <llvm/Support/CommandLine.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Support/xxhash.h>
+
+#include <algorithm>
+#include <vector>
 
 using namespace llvm;
 using namespace SPIRV;
 
+#ifndef LLVM_SPIRV_VERSION_STRING
+#define LLVM_SPIRV_VERSION_STRING "unknown"
+#endif
+#ifndef LLVM_SPIRV_BUILD_ID
+#define LLVM_SPIRV_BUILD_ID ""
+#endif
+
+namespace SPIRV {
+extern cl::opt<bool> SPIRVLowerConst;
+extern cl::opt<bool> EraseOCLMD;
+extern cl::opt<bool> SPIRVEnableStepExpansion;
+} // namespace SPIRV
+
+std::vector<std::string> SPIRV::getNonDefaultTranslationFlags() {
+  const cl::opt<bool> *Flags[] = {&SPIRVLowerConst, &EraseOCLMD,
+                                  &SPIRVEnableStepExpansion};
+  std::vector<std::string> Result;
+  for (const cl::opt<bool> *Flag : Flags)
+    if (Flag->getValue() != Flag->getDefault().getValue())
+      Result.push_back(Flag->ArgStr.str() +
+                       (Flag->getValue() ? "=true" : "=false"));
+  return Result;
+}
+
 bool TranslatorOpts::isUnknownIntrinsicAllowed(IntrinsicInst *II) const
     noexcept {
   if (!SPIRVAllowUnknownIntrinsics.hasValue())
@@ -65,7 +96,47 @@ bool TranslatorOpts::isSPIRVAllowUnknownIntrinsicsEnabled() const noexcept {
   return SPIRVAllowUnknownIntrinsics.hasValue();
 }
 
+TranslatorOpts::ArgList
+TranslatorOpts::getSPIRVAllowUnknownIntrinsics() const noexcept {
+  return SPIRVAllowUnknownIntrinsics.getValueOr(ArgList());
+}
+
 void TranslatorOpts::setSPIRVAllowUnknownIntrinsics(
     TranslatorOpts::ArgList IntrinsicPrefixList) noexcept {
   SPIRVAllowUnknownIntrinsics = IntrinsicPrefixList;
 }
+
+uint64_t TranslatorOpts::getFingerprint() const {
+  // Bump this whenever the translation result changes for the same input and
+  // options, so that stale cache entries are not reused.
+  const unsigned FingerprintVersion = 2;
+  std::string Buf;
+  raw_string_ostream OS(Buf);
+  OS << "v" << FingerprintVersion << ";translator=" << LLVM_SPIRV_VERSION_STRING
+     << ";build=" << LLVM_SPIRV_BUILD_ID << ";llvm=" << LLVM_VERSION_STRING
+     << ";max=" << static_cast<uint32_t>(MaxVersion) << ";ext=";
+  for (const auto &Ext : ExtStatusMap)
+    OS << static_cast<uint32_t>(Ext.first) << ":" << Ext.second << ",";
+  OS << ";mem2reg=" << SPIRVMemToReg << ";argname=" << GenKernelArgNameMD
+     << ";spec=";
+  std::vector<std::pair<uint32_t, uint64_t>> SpecConsts(
+      ExternalSpecialization.begin(), ExternalSpecialization.end());
+  std::sort(SpecConsts.begin(), SpecConsts.end());
+  for (const auto &SC : SpecConsts)
+    OS << SC.first << ":" << SC.second << ",";
+  OS << ";bis=" << static_cast<uint32_t>(DesiredRepresentationOfBIs)
+     << ";fpc=" << static_cast<uint32_t>(FPCMode) << ";intrinsics=";
+  if (SPIRVAllowUnknownIntrinsics.hasValue())
+    for (const auto &Prefix : SPIRVAllowUnknownIntrinsics.getValue())
+      OS << Prefix.size() << ":" << Prefix << ",";
+  else
+    OS << "none";
+  OS << ";extradi=" << AllowExtraDIExpressions
+     << ";eis=" << static_cast<uint32_t>(DebugInfoVersion)
+     << ";mad=" << ReplaceLLVMFmulAddWithOpenCLMad
+     << ";skipdbg=" << SkipDebugInfo << ";text=" << SPIRVTextFormat
+     << ";flags=";
+  for (const auto &Flag : getNonDefaultTranslationFlags())
+    OS << Flag << ",";
+  return xxHash64(OS.str());
+}
@@ -52,6 +52,15 @@ void LLVMToSPIRVDbgTran::transDebugMetadata() {
   if (DIF.compile_unit_count() == 0)
     return;
 
+  // Index global variables by their debug info once, so that translation of
+  // each DIGlobalVariable doesn't need to scan all globals of the module.
+  for (GlobalVariable &V : M->globals()) {
+    SmallVector<DIGlobalVariableExpression *, 4> GVs;
+    V.getDebugInfo(GVs);
+    for (DIGlobalVariableExpression *GVE : GVs)
+      DIGlobalVariableMap.insert({GVE->getVariable(), &V});
+  }
+
   DICompileUnit *CU = *DIF.compile_units().begin();
   transDbgEntry(CU);
 
@@ -213,7 +222,7 @@ void LLVMToSPIRVDbgTran::transLocationInfo() {
           transDebugLoc(DL, SBB, static_cast<SPIRVInstruction *>(V));
         }
         // If any component of OpLine has changed emit another OpLine
-        SPIRVString *DirAndFile = BM->getString(getFullPath(DL.get()));
+        SPIRVString *DirAndFile = getFilePathString(DL->getFile());
         if (File != DirAndFile || LineNo != DL.getLine() ||
             Col != DL.getCol()) {
           File = DirAndFile;
@@ -377,14 +386,9 @@ SPIRVEntry *LLVMToSPIRVDbgTran::getScope(DIScope *S) {
 }
 
 SPIRVEntry *LLVMToSPIRVDbgTran::getGlobalVariable(const DIGlobalVariable *GV) {
-  for (GlobalVariable &V : M->globals()) {
-    SmallVector<DIGlobalVariableExpression *, 4> GVs;
-    V.getDebugInfo(GVs);
-    for (DIGlobalVariableExpression *GVE : GVs) {
-      if (GVE->getVariable() == GV)
-        return SPIRVWriter->transValue(&V, nullptr);
-    }
-  }
+  auto Loc = DIGlobalVariableMap.find(GV);
+  if (Loc != DIGlobalVariableMap.end())
+    return SPIRVWriter->transValue(Loc->second, nullptr);
   return getDebugInfoNone();
 }
 
@@ -972,7 +976,16 @@ SPIRVExtInst *LLVMToSPIRVDbgTran::getSource(const T *DIEntry) {
 }
 
 SPIRVEntry *LLVMToSPIRVDbgTran::transDbgFileType(const DIFile *F) {
-  return BM->getString(getFullPath(F));
+  return getFilePathString(F);
+}
+
+SPIRVString *LLVMToSPIRVDbgTran::getFilePathString(const DIFile *F) {
+  auto Loc = FilePathMap.find(F);
+  if (Loc != FilePathMap.end())
+    return Loc->second;
+  SPIRVString *Path = BM->getString(getFullPath(F));
+  FilePathMap[F] = Path;
+  return Path;
 }
 
 // Local variables
@@ -133,6 +133,10 @@ private:
 
   template <class T> SPIRVExtInst *getSource(const T *DIEntry);
   SPIRVEntry *transDbgFileType(const DIFile *F);
+  // Get OpString with the full path of the file. The string is memoized per
+  // file, so that OpLines don't rebuild and rehash the path for every
+  // instruction.
+  SPIRVString *getFilePathString(const DIFile *F);
 
   // Local Variables
   SPIRVEntry *transDbgLocalVariable(const DILocalVariable *Var);
@@ -148,6 +152,10 @@ private:
   LLVMToSPIRVBase *SPIRVWriter;
   std::unordered_map<const MDNode *, SPIRVEntry *> MDMap;
   std::unordered_map<std::string, SPIRVExtInst *> FileMap;
+  std::unordered_map<const DIFile *, SPIRVString *> FilePathMap;
+  // Global variables of the module by their debug info.
+  std::unordered_map<const DIGlobalVariable *, GlobalVariable *>
+      DIGlobalVariableMap;
   DebugInfoFinder DIF;
   SPIRVType *VoidT;
   SPIRVEntry *DebugInfoNone;
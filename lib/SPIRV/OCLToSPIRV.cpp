@@ -396,9 +396,10 @@ void OCLToSPIRVBase::visitCallInst(CallInst &CI) {
     return;
 
   auto MangledName = F->getName();
-  StringRef DemangledName;
-  if (!oclIsBuiltin(MangledName, DemangledName))
+  const BuiltinFuncInfo &Info = getBuiltinFuncInfo(F);
+  if (!Info.IsOCLBuiltin)
     return;
+  StringRef DemangledName = Info.getDemangledName(F);
 
   LLVM_DEBUG(dbgs() << "DemangledName: " << DemangledName << '\n');
   if (DemangledName.find(kOCLBuiltinName::NDRangePrefix) == 0) {
@@ -919,7 +920,8 @@ void OCLToSPIRVBase::visitCallConvert(CallInst *CI, StringRef MangledName,
   std::string Sat = DemangledName.find("_sat") != StringRef::npos ? "_sat" : "";
   auto TargetSigned = DemangledName[8] != 'u';
   if (isa<IntegerType>(SrcTy)) {
-    bool Signed = isLastFuncParamSigned(MangledName);
+    bool Signed = getBuiltinFuncInfo(CI->getCalledFunction()).LastParamType ==
+                  ParamType::SIGNED;
     if (IsTargetInt) {
       if (!Sat.empty() && TargetSigned != Signed) {
         OC = Signed ? OpSatConvertSToU : OpSatConvertUToS;
@@ -1079,7 +1081,8 @@ void OCLToSPIRVBase::transBuiltin(CallInst *CI, OCLBuiltinTransInfo &Info) {
     } else {
       Info.UniqName = getSPIRVFuncName(OC);
     }
-  } else if ((ExtOp = getExtOp(Info.MangledName, Info.UniqName)) != ~0U)
+  } else if ((ExtOp = getExtOp(CI->getCalledFunction(), Info.UniqName)) !=
+             ~0U)
     Info.UniqName = getSPIRVExtFuncName(SPIRVEIS_OpenCL, ExtOp);
   else
     return;
@@ -1252,7 +1255,8 @@ bool OCLToSPIRVBase::eraseUselessConvert(CallInst *CI, StringRef MangledName,
   if (TargetTy == SrcTy) {
     if (isa<IntegerType>(TargetTy) &&
         DemangledName.find("_sat") != StringRef::npos &&
-        isLastFuncParamSigned(MangledName) != (DemangledName[8] != 'u'))
+        (getBuiltinFuncInfo(CI->getCalledFunction()).LastParamType ==
+         ParamType::SIGNED) != (DemangledName[8] != 'u'))
       return false;
     CI->getArgOperand(0)->takeName(CI);
     SPIRVDBG(dbgs() << "[regularizeOCLConvert] " << *CI << " <- "
@@ -1280,9 +1284,10 @@ void OCLToSPIRVBase::transWorkItemBuiltinsToVariables() {
   LLVM_DEBUG(dbgs() << "Enter transWorkItemBuiltinsToVariables\n");
   std::vector<Function *> WorkList;
   for (auto &I : *M) {
-    StringRef DemangledName;
-    if (!oclIsBuiltin(I.getName(), DemangledName))
+    const BuiltinFuncInfo &Info = getBuiltinFuncInfo(&I);
+    if (!Info.IsOCLBuiltin)
       continue;
+    StringRef DemangledName = Info.getDemangledName(&I);
     LLVM_DEBUG(dbgs() << "Function demangled name: " << DemangledName << '\n');
     std::string BuiltinVarName;
     SPIRVBuiltinVariableKind BVKind;
@@ -1511,6 +1516,7 @@ void OCLToSPIRVBase::visitCallScalToVec(CallInst *CI, StringRef MangledName,
     ScalarPos.push_back(1);
   }
 
+  unsigned ExtOp = getExtOp(CI->getCalledFunction(), DemangledName);
   AttributeList Attrs = CI->getCalledFunction()->getAttributes();
   mutateCallInstSPIRV(
       M, CI,
@@ -1532,8 +1538,7 @@ void OCLToSPIRVBase::visitCallScalToVec(CallInst *CI, StringRef MangledName,
 
           Args[I] = NewVec;
         }
-        return getSPIRVExtFuncName(SPIRVEIS_OpenCL,
-                                   getExtOp(MangledName, DemangledName));
+        return getSPIRVExtFuncName(SPIRVEIS_OpenCL, ExtOp);
       },
       &Attrs);
 }
@@ -217,10 +217,10 @@ void OCLTypeToSPIRVBase::adaptArgumentsBySamplerUse(Module &M) {
   for (auto &F : M) {
     if (!F.empty()) // not decl
       continue;
-    auto MangledName = F.getName();
-    StringRef DemangledName;
-    if (!oclIsBuiltin(MangledName, DemangledName, false))
+    const BuiltinFuncInfo &Info = getBuiltinFuncInfo(&F);
+    if (!Info.IsOCLBuiltin)
       continue;
+    StringRef DemangledName = Info.getDemangledName(&F);
     if (DemangledName.find(kSPIRVName::SampledImage) == std::string::npos)
       continue;
 
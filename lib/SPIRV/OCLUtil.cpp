@@ -703,16 +703,13 @@ BarrierLiterals getBarrierLiterals(CallInst *CI) {
                          Scope);
 }
 
-unsigned getExtOp(StringRef OrigName, StringRef GivenDemangledName) {
-  std::string DemangledName{GivenDemangledName};
-  if (DemangledName.empty() || !oclIsBuiltin(OrigName, GivenDemangledName))
-    return ~0U;
+static unsigned getExtOp(StringRef DemangledName, ParamType LastParamType) {
   LLVM_DEBUG(dbgs() << "getExtOp: demangled name: " << DemangledName << '\n');
   OCLExtOpKind EOC;
-  bool Found = OCLExtOpMap::rfind(DemangledName, &EOC);
+  bool Found = OCLExtOpMap::rfind(DemangledName.str(), &EOC);
   if (!Found) {
     std::string Prefix;
-    switch (lastFuncParamType(OrigName)) {
+    switch (LastParamType) {
     case ParamType::UNSIGNED:
       Prefix = "u_";
       break;
@@ -725,7 +722,7 @@ unsigned getExtOp(StringRef OrigName, StringRef GivenDemangledName) {
     case ParamType::UNKNOWN:
       break;
     }
-    Found = OCLExtOpMap::rfind(Prefix + DemangledName, &EOC);
+    Found = OCLExtOpMap::rfind(Prefix + DemangledName.str(), &EOC);
   }
   if (Found)
     return EOC;
@@ -733,6 +730,22 @@ unsigned getExtOp(StringRef OrigName, StringRef GivenDemangledName) {
     return ~0U;
 }
 
+unsigned getExtOp(StringRef OrigName, StringRef GivenDemangledName) {
+  std::string DemangledName{GivenDemangledName};
+  if (DemangledName.empty() || !oclIsBuiltin(OrigName, GivenDemangledName))
+    return ~0U;
+  return getExtOp(DemangledName, lastFuncParamType(OrigName));
+}
+
+unsigned getExtOp(const Function *F, StringRef DemangledName) {
+  if (DemangledName.empty())
+    return ~0U;
+  const BuiltinFuncInfo &Info = getBuiltinFuncInfo(F);
+  if (!Info.IsOCLBuiltin)
+    return ~0U;
+  return getExtOp(DemangledName, Info.LastParamType);
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 // Functions for getting module info
@@ -380,6 +380,10 @@ const static char TypePrefix[] = "opencl.intel_sub_group_avc_";
 ///   function is translated to an extended instruction, otherwise ~0U.
 unsigned getExtOp(StringRef MangledName, StringRef DemangledName = "");
 
+/// Same as above, but takes the signedness of the last parameter from the
+/// cached builtin information of \p F instead of parsing its mangled name.
+unsigned getExtOp(const Function *F, StringRef DemangledName);
+
 /// Get literal arguments of call of atomic_work_item_fence.
 AtomicWorkItemFenceLiterals getAtomicWorkItemFenceLiterals(CallInst *CI);
 
@@ -0,0 +1,151 @@
+//===- SPIRVCache.cpp - On-disk translation cache ---------------*- C++ -*-===//
+//
+//                     The LLVM/SPIR-V Translator
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+// Copyright (c) 2021 Intel Corporation. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal with the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimers.
+// Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimers in the documentation
+// and/or other materials provided with the distribution.
+// Neither the names of Advanced Micro Devices, Inc., nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// Software without specific prior written permission.
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH
+// THE SOFTWARE.
+//
+/// \file
+///
+/// This file implements the on-disk translation cache used by readSpirv and
+/// writeSpirv when TranslatorOpts::getTranslationCacheDir() is set.
+///
+//===----------------------------------------------------------------------===//
+
+#include "SPIRVCache.h"
+#include "LLVMSPIRVLib.h"
+
+#include "llvm/Support/CachePruning.h"
+#include "llvm/Support/Errc.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/xxhash.h"
+
+#include <atomic>
+#include <chrono>
+
+using namespace llvm;
+using namespace SPIRV;
+
+static std::atomic<uint64_t> CacheHits{0};
+static std::atomic<uint64_t> CacheMisses{0};
+
+TranslationCacheStats SPIRV::getTranslationCacheStats() {
+  TranslationCacheStats Stats;
+  Stats.Hits = CacheHits.load(std::memory_order_relaxed);
+  Stats.Misses = CacheMisses.load(std::memory_order_relaxed);
+  return Stats;
+}
+
+void SPIRV::resetTranslationCacheStats() {
+  CacheHits = 0;
+  CacheMisses = 0;
+}
+
+TranslationCache::TranslationCache(const TranslatorOpts &Opts, bool Reverse)
+    : Dir(Opts.getTranslationCacheDir()),
+      MaxSize(Opts.getTranslationCacheMaxSize()),
+      OptsFingerprint(Opts.getFingerprint()), Reverse(Reverse) {}
+
+uint64_t TranslationCache::getKey(StringRef Input) const {
+  uint64_t Seeds[] = {xxHash64(Input), OptsFingerprint, Reverse};
+  return xxHash64(StringRef(reinterpret_cast<const char *>(Seeds),
+                            sizeof(Seeds)));
+}
+
+std::string TranslationCache::getPath(uint64_t Key) const {
+  // The "llvmcache-" prefix makes the entry visible to pruneCache.
+  SmallString<128> Path(Dir);
+  sys::path::append(Path, (Reverse ? "llvmcache-spirv-bc-"
+                                   : "llvmcache-spirv-spv-") +
+                              utohexstr(Key, /*LowerCase=*/true));
+  return std::string(Path.str());
+}
+
+bool TranslationCache::lookup(uint64_t Key, std::string &Result) {
+  std::string Path = getPath(Key);
+  Expected<sys::fs::file_t> FD = sys::fs::openNativeFileForRead(Path);
+  if (!FD) {
+    consumeError(FD.takeError());
+    ++CacheMisses;
+    return false;
+  }
+  ErrorOr<std::unique_ptr<MemoryBuffer>> MB =
+      MemoryBuffer::getOpenFile(*FD, Path, /*FileSize=*/-1);
+  if (MB) {
+    // Mark the entry as recently used for pruning. Access times may not be
+    // updated by the file system itself.
+    sys::fs::setLastAccessAndModificationTime(*FD,
+                                              std::chrono::system_clock::now());
+    Result = (*MB)->getBuffer().str();
+  }
+  sys::fs::closeFile(*FD);
+  if (!MB) {
+    ++CacheMisses;
+    return false;
+  }
+  ++CacheHits;
+  return true;
+}
+
+void TranslationCache::store(uint64_t Key, StringRef Result) {
+  if (sys::fs::create_directories(Dir))
+    return;
+  // The temporary file must not look like an entry, or pruning running in
+  // another process could remove it before it is renamed.
+  SmallString<128> TempPattern(Dir);
+  sys::path::append(TempPattern, "spirvcache-tmp-%%%%%%%%%%%%");
+  Expected<sys::fs::TempFile> Temp = sys::fs::TempFile::create(TempPattern);
+  if (!Temp) {
+    consumeError(Temp.takeError());
+    return;
+  }
+  {
+    raw_fd_ostream OS(Temp->FD, /*shouldClose=*/false);
+    OS << Result;
+    OS.flush();
+    if (OS.has_error()) {
+      OS.clear_error();
+      consumeError(Temp->discard());
+      return;
+    }
+  }
+  if (Error E = Temp->keep(getPath(Key))) {
+    consumeError(std::move(E));
+    consumeError(Temp->discard());
+    return;
+  }
+
+  CachePruningPolicy Policy;
+  Policy.Interval = std::chrono::seconds(0);
+  Policy.MaxSizeBytes = MaxSize;
+  pruneCache(Dir, Policy);
+}
@@ -0,0 +1,81 @@
+//===- SPIRVCache.h - On-disk translation cache -----------------*- C++ -*-===//
+//
+//                     The LLVM/SPIR-V Translator
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+// Copyright (c) 2021 Intel Corporation. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal with the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimers.
+// Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimers in the documentation
+// and/or other materials provided with the distribution.
+// Neither the names of Advanced Micro Devices, Inc., nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// Software without specific prior written permission.
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH
+// THE SOFTWARE.
+//
+//===----------------------------------------------------------------------===//
+/// \file
+///
+/// This file declares TranslationCache, which keeps results of readSpirv and
+/// writeSpirv in a directory keyed by a hash of their input and options.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef SPIRV_SPIRVCACHE_H
+#define SPIRV_SPIRVCACHE_H
+
+#include "LLVMSPIRVOpts.h"
+#include "llvm/ADT/StringRef.h"
+
+#include <string>
+
+namespace SPIRV {
+
+/// \brief On-disk cache of translation results.
+///
+/// Entries are named after the xxHash64 of the input combined with the
+/// fingerprint of the translation options and the direction of the
+/// translation. They are written to a temporary file first and renamed into
+/// place, so concurrent translators never observe partial entries. After each
+/// store the directory is pruned in least-recently-used order down to
+/// TranslatorOpts::getTranslationCacheMaxSize().
+class TranslationCache {
+public:
+  TranslationCache(const TranslatorOpts &Opts, bool Reverse);
+
+  /// Compute the key of the translation of \p Input.
+  uint64_t getKey(llvm::StringRef Input) const;
+  /// Load the entry for \p Key into \p Result. \returns false on a miss.
+  bool lookup(uint64_t Key, std::string &Result);
+  /// Store \p Result as the entry for \p Key. Failures are ignored.
+  void store(uint64_t Key, llvm::StringRef Result);
+
+private:
+  std::string getPath(uint64_t Key) const;
+
+  std::string Dir;
+  uint64_t MaxSize;
+  uint64_t OptsFingerprint;
+  bool Reverse;
+};
+
+} // namespace SPIRV
+
+#endif // SPIRV_SPIRVCACHE_H
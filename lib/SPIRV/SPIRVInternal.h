@@ -47,11 +47,14 @@
 #include "libSPIRV/SPIRVUtil.h"
 
 #include "LLVMSPIRVLib.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/IR/Attributes.h"
 #include "llvm/IR/Constants.h"
 #include "llvm/IR/Instructions.h"
 
+#include <atomic>
 #include <functional>
+#include <mutex>
 #include <utility>
 
 using namespace SPIRV;
@@ -919,7 +922,7 @@ bool isMangledTypeSigned(char Mangled);
 bool isMangledTypeFP(char Mangled);
 
 // Check if a mangled type name is half
-bool isMangledTypeHalf(std::string Mangled);
+bool isMangledTypeHalf(StringRef Mangled);
 
 // Check if \param I is valid vector size: 2, 3, 4, 8, 16.
 bool isValidVectorSize(unsigned I);
@@ -934,6 +937,78 @@ bool isLastFuncParamSigned(StringRef MangledName);
 // Check if a mangled function name contains unsigned atomic type
 bool containsUnsignedAtomicType(StringRef Name);
 
+/// Builtin classification of a function derived from its name: the demangled
+/// name, the SPIR-V op code or extended instruction it maps to and the
+/// signedness of its last parameter. All fields depend on the name only.
+struct BuiltinFuncInfo {
+  /// Function name the entry was computed for.
+  std::string Name;
+  /// oclIsBuiltin returns true for the name.
+  bool IsOCLBuiltin = false;
+  /// The name takes the __spirv_{Name} format.
+  bool IsDecoratedSPIRV = false;
+  /// Position of the demangled name in the function name. It is the whole
+  /// name for decorated SPIR-V functions which are not mangled.
+  size_t DemangledStart = 0;
+  size_t DemangledLen = 0;
+  ParamType LastParamType = ParamType::UNKNOWN;
+  /// Result of getSPIRVFuncOC for the demangled name.
+  Op OC = OpNop;
+  SmallVector<std::string, 2> OCDec;
+  /// Extended instruction encoded by a __spirv_{Set}_{ExtOp} demangled name.
+  SPIRVExtInstSetKind ExtSet = SPIRVEIS_Count;
+  SPIRVWord ExtOp = SPIRVWORD_MAX;
+  SmallVector<std::string, 2> ExtDec;
+
+  bool isBuiltin() const { return IsOCLBuiltin || IsDecoratedSPIRV; }
+  bool isExtInst() const { return ExtSet != SPIRVEIS_Count; }
+
+  /// \returns demangled name as a substring of the name of \p F.
+  StringRef getDemangledName(const Function *F) const {
+    return F->getName().substr(DemangledStart, DemangledLen);
+  }
+};
+
+/// Get builtin information for function \p F from a per-thread cache keyed
+/// by function. The cache is shared by all translator passes running on the
+/// same thread. An entry is recomputed if the function name has changed since
+/// it was cached, so the cache never needs to be invalidated explicitly.
+/// \returns reference valid until the next call of this function.
+const BuiltinFuncInfo &getBuiltinFuncInfo(const Function *F);
+
+/// Cache of builtin information keyed by function name. Unlike the per-thread
+/// cache behind getBuiltinFuncInfo it does not refer to any LLVMContext, so it
+/// can be kept warm across translations and shared between threads.
+class BuiltinNameCache {
+public:
+  /// Fill \p Info for \p Name, computing it only if the name is not cached.
+  void lookup(StringRef Name, BuiltinFuncInfo &Info);
+  uint64_t getNumHits() const { return Hits; }
+  uint64_t getNumMisses() const { return Misses; }
+  size_t size() const;
+  void resetStats() {
+    Hits = 0;
+    Misses = 0;
+  }
+
+private:
+  mutable std::mutex Lock;
+  StringMap<BuiltinFuncInfo> Map;
+  std::atomic<uint64_t> Hits{0};
+  std::atomic<uint64_t> Misses{0};
+};
+
+/// While alive, makes getBuiltinFuncInfo on the current thread consult
+/// \p Cache before computing information for a name it has not seen.
+class BuiltinNameCacheScope {
+public:
+  explicit BuiltinNameCacheScope(BuiltinNameCache *Cache);
+  ~BuiltinNameCacheScope();
+
+private:
+  BuiltinNameCache *Saved;
+};
+
 /// Mangle builtin function name.
 /// \return \param UniqName if \param BtnInfo is null pointer, otherwise
 ///    return IA64 mangled name.
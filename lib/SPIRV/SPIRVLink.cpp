@@ -0,0 +1,1163 @@
+//===- SPIRVLink.cpp - Link SPIR-V modules ----------------------*- C++ -*-===//
+//
+//                     The LLVM/SPIR-V Translator
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+// Copyright (c) 2021 Intel Corporation. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal with the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimers.
+// Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimers in the documentation
+// and/or other materials provided with the distribution.
+// Neither the names of Advanced Micro Devices, Inc., nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// Software without specific prior written permission.
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH
+// THE SOFTWARE.
+//
+/// \file
+///
+/// This file implements linkSpirv, which links SPIR-V modules by merging
+/// their word streams: ids are renumbered, identical types and constants are
+/// unified, imported functions and variables are resolved to the exported
+/// definitions of other modules, and capabilities and extensions are merged.
+/// No LLVM module is built for the inputs.
+///
+//===----------------------------------------------------------------------===//
+
+#include "LLVMSPIRVLib.h"
+#include "SPIRV.debug.h"
+#include "SPIRVAsm.h"
+#include "SPIRVBasicBlock.h"
+#include "SPIRVDebug.h"
+#include "SPIRVDecorate.h"
+#include "SPIRVFunction.h"
+#include "SPIRVInstruction.h"
+#include "SPIRVInternal.h"
+#include "SPIRVMemAliasingINTEL.h"
+#include "SPIRVModule.h"
+#include "SPIRVType.h"
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringSet.h"
+
+#include <cstring>
+#include <sstream>
+#include <type_traits>
+
+using namespace SPIRV;
+using namespace llvm;
+
+namespace {
+
+const size_t HeaderSize = 5;
+
+// Sections of the logical layout of a module (p2.4 of the spec), in order.
+enum LayoutSection {
+  LS_Capability,
+  LS_Extension,
+  LS_ExtInstImport,
+  LS_MemoryModel,
+  LS_EntryPoint,
+  LS_ExecutionMode,
+  LS_DebugSource,
+  LS_Name,
+  LS_ModuleProcessed,
+  LS_Annotation,
+  LS_Global,
+  LS_Count
+};
+
+LayoutSection getLayoutSection(Op OC) {
+  switch (OC) {
+  case OpCapability:
+    return LS_Capability;
+  case OpExtension:
+    return LS_Extension;
+  case OpExtInstImport:
+    return LS_ExtInstImport;
+  case OpMemoryModel:
+    return LS_MemoryModel;
+  case OpEntryPoint:
+    return LS_EntryPoint;
+  case OpExecutionMode:
+  case OpExecutionModeId:
+    return LS_ExecutionMode;
+  case OpString:
+  case OpSourceExtension:
+  case OpSource:
+  case OpSourceContinued:
+    return LS_DebugSource;
+  case OpName:
+  case OpMemberName:
+    return LS_Name;
+  case OpModuleProcessed:
+    return LS_ModuleProcessed;
+  case OpDecorate:
+  case OpMemberDecorate:
+  case OpDecorationGroup:
+  case OpGroupDecorate:
+  case OpGroupMemberDecorate:
+  case OpDecorateId:
+  case OpDecorateString:
+  case OpMemberDecorateString:
+    return LS_Annotation;
+  default:
+    return LS_Global;
+  }
+}
+
+// Decorations that apply to their target only and can be compared as part of
+// the definition of a type or a constant.
+bool isTargetDecoration(Op OC) {
+  return OC == OpDecorate || OC == OpMemberDecorate || OC == OpDecorateId ||
+         OC == OpDecorateString || OC == OpMemberDecorateString;
+}
+
+// Types and constants which are unified with an identical definition in an
+// earlier module.
+bool isUnifiable(Op OC) {
+  switch (OC) {
+  case OpConstantTrue:
+  case OpConstantFalse:
+  case OpConstant:
+  case OpConstantComposite:
+  case OpConstantSampler:
+  case OpConstantNull:
+  case OpConstantPipeStorage:
+  case OpUndef:
+    return true;
+  default:
+    return isTypeOpCode(OC);
+  }
+}
+
+// Number of words of the literal string starting at word \p Pos.
+unsigned getStringWordCount(ArrayRef<uint32_t> Inst, unsigned Pos) {
+  for (unsigned I = Pos; I < Inst.size(); ++I)
+    for (unsigned Byte = 0; Byte < 4; ++Byte)
+      if (((Inst[I] >> (Byte * 8)) & 0xFF) == 0)
+        return I - Pos + 1;
+  return Inst.size() - Pos;
+}
+
+std::string getString(ArrayRef<uint32_t> Inst, unsigned Pos) {
+  std::string Str;
+  for (unsigned I = Pos; I < Inst.size(); ++I)
+    for (unsigned Byte = 0; Byte < 4; ++Byte) {
+      char C = (Inst[I] >> (Byte * 8)) & 0xFF;
+      if (!C)
+        return Str;
+      Str += C;
+    }
+  return Str;
+}
+
+// Literal arguments of extended instructions, as a mask of argument indices.
+bool getExtInstLiterals(SPIRVExtInstSetKind Kind, SPIRVWord ExtOp,
+                        uint64_t &Mask) {
+  Mask = 0;
+  if (Kind == SPIRVEIS_OpenCL) {
+    switch (ExtOp) {
+    case OpenCLLIB::Vloadn:
+    case OpenCLLIB::Vload_halfn:
+    case OpenCLLIB::Vloada_halfn:
+      Mask = 1 << 2;
+      break;
+    case OpenCLLIB::Vstore_half_r:
+    case OpenCLLIB::Vstore_halfn_r:
+    case OpenCLLIB::Vstorea_halfn_r:
+      Mask = 1 << 3;
+      break;
+    default:
+      break;
+    }
+    return true;
+  }
+  if (Kind != SPIRVEIS_Debug && Kind != SPIRVEIS_OpenCL_DebugInfo_100)
+    return false;
+  auto Bits = [&](std::initializer_list<unsigned> Args) {
+    for (unsigned Arg : Args)
+      Mask |= uint64_t(1) << Arg;
+  };
+  namespace DbgOp = SPIRVDebug::Operand;
+  switch (ExtOp) {
+  case SPIRVDebug::DebugInfoNone:
+  case SPIRVDebug::Source:
+  case SPIRVDebug::TypeArray:
+  case SPIRVDebug::TypePtrToMember:
+  case SPIRVDebug::TypeTemplate:
+  case SPIRVDebug::Scope:
+  case SPIRVDebug::NoScope:
+  case SPIRVDebug::InlinedVariable:
+  case SPIRVDebug::Declare:
+  case SPIRVDebug::Value:
+  case SPIRVDebug::Expression:
+    break;
+  case SPIRVDebug::CompilationUnit:
+    Bits({DbgOp::CompilationUnit::SPIRVDebugInfoVersionIdx,
+          DbgOp::CompilationUnit::DWARFVersionIdx,
+          DbgOp::CompilationUnit::LanguageIdx});
+    break;
+  case SPIRVDebug::TypeBasic:
+    Bits({DbgOp::TypeBasic::EncodingIdx});
+    break;
+  case SPIRVDebug::TypePointer:
+    Bits({DbgOp::TypePointer::StorageClassIdx, DbgOp::TypePointer::FlagsIdx});
+    break;
+  case SPIRVDebug::TypeQualifier:
+    Bits({DbgOp::TypeQualifier::QualifierIdx});
+    break;
+  case SPIRVDebug::TypeVector:
+    Bits({DbgOp::TypeVector::ComponentCountIdx});
+    break;
+  case SPIRVDebug::Typedef:
+    Bits({DbgOp::Typedef::LineIdx, DbgOp::Typedef::ColumnIdx});
+    break;
+  case SPIRVDebug::TypeFunction:
+    Bits({DbgOp::TypeFunction::FlagsIdx});
+    break;
+  case SPIRVDebug::TypeEnum:
+    Bits({DbgOp::TypeEnum::LineIdx, DbgOp::TypeEnum::ColumnIdx,
+          DbgOp::TypeEnum::FlagsIdx});
+    break;
+  case SPIRVDebug::TypeComposite:
+    Bits({DbgOp::TypeComposite::TagIdx, DbgOp::TypeComposite::LineIdx,
+          DbgOp::TypeComposite::ColumnIdx, DbgOp::TypeComposite::FlagsIdx});
+    break;
+  case SPIRVDebug::TypeMember:
+    Bits({DbgOp::TypeMember::LineIdx, DbgOp::TypeMember::ColumnIdx,
+          DbgOp::TypeMember::FlagsIdx});
+    break;
+  case SPIRVDebug::Inheritance:
+    Bits({DbgOp::TypeInheritance::FlagsIdx});
+    break;
+  case SPIRVDebug::TypeTemplateParameter:
+    Bits({DbgOp::TemplateParameter::LineIdx,
+          DbgOp::TemplateParameter::ColumnIdx});
+    break;
+  case SPIRVDebug::TypeTemplateTemplateParameter:
+    Bits({DbgOp::TemplateTemplateParameter::LineIdx,
+          DbgOp::TemplateTemplateParameter::ColumnIdx});
+    break;
+  case SPIRVDebug::TypeTemplateParameterPack:
+    Bits({DbgOp::TemplateParameterPack::LineIdx,
+          DbgOp::TemplateParameterPack::ColumnIdx});
+    break;
+  case SPIRVDebug::GlobalVariable:
+    Bits({DbgOp::GlobalVariable::LineIdx, DbgOp::GlobalVariable::ColumnIdx,
+          DbgOp::GlobalVariable::FlagsIdx});
+    break;
+  case SPIRVDebug::FunctionDecl:
+    Bits({DbgOp::FunctionDeclaration::LineIdx,
+          DbgOp::FunctionDeclaration::ColumnIdx,
+          DbgOp::FunctionDeclaration::FlagsIdx});
+    break;
+  case SPIRVDebug::Function:
+    Bits({DbgOp::Function::LineIdx, DbgOp::Function::ColumnIdx,
+          DbgOp::Function::FlagsIdx, DbgOp::Function::ScopeLineIdx});
+    break;
+  case SPIRVDebug::LexicalBlock:
+    Bits({DbgOp::LexicalBlock::LineIdx, DbgOp::LexicalBlock::ColumnIdx});
+    break;
+  case SPIRVDebug::LexicalBlockDiscriminator:
+    Bits({DbgOp::LexicalBlockDiscriminator::DiscriminatorIdx});
+    break;
+  case SPIRVDebug::InlinedAt:
+    Bits({DbgOp::InlinedAt::LineIdx});
+    break;
+  case SPIRVDebug::LocalVariable:
+    Bits({DbgOp::LocalVariable::LineIdx, DbgOp::LocalVariable::ColumnIdx,
+          DbgOp::LocalVariable::FlagsIdx, DbgOp::LocalVariable::ArgNumberIdx});
+    break;
+  case SPIRVDebug::Operation:
+    Mask = ~uint64_t(0);
+    break;
+  case SPIRVDebug::MacroDef:
+  case SPIRVDebug::MacroUndef:
+    // Line is the only literal operand.
+    Bits({1});
+    break;
+  case SPIRVDebug::ImportedEntity:
+    // The operand between Tag and Source is not used.
+    Bits({DbgOp::ImportedEntity::TagIdx, DbgOp::ImportedEntity::TagIdx + 1,
+          DbgOp::ImportedEntity::LineIdx, DbgOp::ImportedEntity::ColumnIdx});
+    break;
+  default:
+    return false;
+  }
+  return true;
+}
+
+// An instruction of an input module with the positions of its id operands,
+// counted in words from the start of the instruction.
+struct LinkInst {
+  ArrayRef<uint32_t> Words;
+  unsigned IdBegin = 0;
+  unsigned IdEnd = 0;
+  // Position of the result id, or 0 if there is none.
+  unsigned Result = 0;
+};
+
+struct InputModule {
+  ArrayRef<uint32_t> Words;
+  // Added to every id of the module to make it unique among all inputs.
+  SPIRVId Offset = 0;
+  SPIRVWord Bound = 0;
+  std::vector<LinkInst> Insts;
+  std::vector<uint16_t> IdPositions;
+  // Instructions before the first function, by layout section.
+  std::vector<unsigned> Sections[LS_Count];
+  // Instruction ranges of functions, and whether each is a declaration.
+  std::vector<std::pair<unsigned, unsigned>> Functions;
+  std::vector<bool> IsDeclaration;
+};
+
+struct LinkageDecl {
+  std::string Name;
+  SPIRVId Id;
+  SPIRVWord Type;
+};
+
+template <typename T>
+typename std::enable_if<std::is_base_of<SPIRVInstTemplateBase, T>::value,
+                        SPIRVInstTemplateBase *>::type
+createInstTemplate() {
+  return new T();
+}
+
+template <typename T>
+typename std::enable_if<!std::is_base_of<SPIRVInstTemplateBase, T>::value,
+                        SPIRVInstTemplateBase *>::type
+createInstTemplate() {
+  return nullptr;
+}
+
+// Create an instance of the SPIRVInstTemplate defining \p OC, which knows the
+// operand layout of the instruction. Returns null for other instructions.
+SPIRVInstTemplateBase *createInstTemplate(Op OC) {
+  // Internal opcodes are not enumerators of Op.
+  switch (static_cast<unsigned>(OC)) {
+#define _SPIRV_OP(x, ...)                                                      \
+  case Op##x:                                                                  \
+    return createInstTemplate<SPIRV##x>();
+#define _SPIRV_OP_INTERNAL(x, ...)                                             \
+  case internal::Op##x:                                                        \
+    return createInstTemplate<SPIRV##x>();
+#include "SPIRVOpCodeEnum.h"
+#include "SPIRVOpCodeEnumInternal.h"
+#undef _SPIRV_OP_INTERNAL
+#undef _SPIRV_OP
+  default:
+    return nullptr;
+  }
+}
+
+class ModuleLinker {
+public:
+  explicit ModuleLinker(std::string &ErrMsg) : ErrMsg(ErrMsg) {}
+
+  bool link(ArrayRef<ArrayRef<uint32_t>> Inputs,
+            SmallVectorImpl<uint32_t> &Out);
+
+private:
+  std::string &ErrMsg;
+  std::vector<InputModule> Modules;
+  // Id which replaces a unified or resolved id. Ids are numbered across all
+  // input modules and indexed by that number.
+  std::vector<SPIRVId> Replace;
+  // Ids whose definitions are not emitted.
+  std::vector<bool> Dropped;
+  // Output ids, assigned in order of first use.
+  std::vector<SPIRVId> FinalIds;
+  SPIRVId NextId = 1;
+
+  StringMap<SPIRVId> ExtInstImports;
+  StringMap<SPIRVId> Strings;
+  StringMap<SPIRVId> TypesAndConstants;
+  DenseMap<SPIRVId, SPIRVExtInstSetKind> ExtInstSets;
+  DenseMap<SPIRVId, unsigned> IntWidths;
+  DenseMap<SPIRVId, SPIRVId> ValueTypes;
+  // Result type and function type (0 for variables) of global symbols.
+  DenseMap<SPIRVId, std::pair<SPIRVId, SPIRVId>> SymbolTypes;
+  DenseMap<unsigned, std::unique_ptr<SPIRVInstTemplateBase>> InstTemplates;
+  std::vector<LinkageDecl> Linkage;
+
+  bool fail(const Twine &Msg) {
+    ErrMsg = Msg.str();
+    return false;
+  }
+  SPIRVId resolve(SPIRVId Id) const {
+    while (Replace[Id])
+      Id = Replace[Id];
+    return Id;
+  }
+  SPIRVId getFinalId(SPIRVId Id) {
+    SPIRVId &Final = FinalIds[resolve(Id)];
+    if (!Final)
+      Final = NextId++;
+    return Final;
+  }
+
+  const SPIRVInstTemplateBase *getInstTemplate(Op OC);
+  bool classify(InputModule &M, LinkInst &I);
+  bool scan(InputModule &M);
+  void unify(InputModule &M, const LinkInst &I,
+             const DenseMap<SPIRVId, SmallVector<uint32_t, 4>> &Decorations,
+             const DenseMap<SPIRVId, SmallVector<uint32_t, 4>> &Names,
+             const DenseSet<SPIRVId> &NoUnify);
+  bool resolveLinkage();
+  void emit(const InputModule &M, const LinkInst &I,
+            SmallVectorImpl<uint32_t> &Out);
+  void emitUnique(const InputModule &M, const LinkInst &I,
+                  SmallVectorImpl<uint32_t> &Out, StringSet<> &Emitted);
+};
+
+const SPIRVInstTemplateBase *ModuleLinker::getInstTemplate(Op OC) {
+  auto It = InstTemplates.find(OC);
+  if (It == InstTemplates.end())
+    It = InstTemplates
+             .try_emplace(OC,
+                          std::unique_ptr<SPIRVInstTemplateBase>(
+                              createInstTemplate(OC)))
+             .first;
+  return It->second.get();
+}
+
+// Find the id operands of \p I. Returns false for malformed instructions and
+// for instructions whose operands are not known here.
+bool ModuleLinker::classify(InputModule &M, LinkInst &I) {
+  ArrayRef<uint32_t> W = I.Words;
+  const unsigned WC = W.size();
+  auto &Ids = M.IdPositions;
+  auto AddRange = [&](unsigned Begin, unsigned End) {
+    for (unsigned P = Begin; P < End && P < WC; ++P)
+      Ids.push_back(P);
+  };
+  auto AddFrom = [&](unsigned Begin) { AddRange(Begin, WC); };
+  auto Result = [&](unsigned Pos) {
+    if (WC <= Pos)
+      return false;
+    I.Result = Pos;
+    AddRange(1, Pos + 1);
+    return true;
+  };
+  // Memory operands: a mask, the alignment literal and the ids of the
+  // remaining mask bits, in bit order.
+  auto MemoryAccess = [&](unsigned Pos) {
+    while (Pos < WC) {
+      SPIRVWord Mask = W[Pos++];
+      if (Mask & MemoryAccessAlignedMask)
+        ++Pos;
+      for (SPIRVWord IdMask :
+           {static_cast<SPIRVWord>(MemoryAccessMakePointerAvailableMask),
+            static_cast<SPIRVWord>(MemoryAccessMakePointerVisibleMask),
+            static_cast<SPIRVWord>(internal::MemoryAccessAliasScopeINTELMask),
+            static_cast<SPIRVWord>(internal::MemoryAccessNoAliasINTELMask)})
+        if (Mask & IdMask)
+          Ids.push_back(Pos++);
+    }
+    return Pos == WC;
+  };
+
+  Op OC = static_cast<Op>(W[0] & OpCodeMask);
+  // Internal opcodes are not enumerators of Op.
+  switch (static_cast<unsigned>(OC)) {
+  case OpNop:
+  case OpCapability:
+  case OpExtension:
+  case OpMemoryModel:
+  case OpSourceExtension:
+  case OpSourceContinued:
+  case OpModuleProcessed:
+  case OpNoLine:
+  case OpFunctionEnd:
+  case OpReturn:
+  case OpUnreachable:
+  case OpKill:
+  case OpLoopControlINTEL:
+    return true;
+  case OpSource:
+    AddRange(3, 4);
+    return true;
+  case OpExtInstImport:
+  case OpString:
+  case OpDecorationGroup:
+  case OpLabel:
+    return Result(1);
+  case OpDecorate:
+    if (WC < 3)
+      return false;
+    Ids.push_back(1);
+    if (W[2] == internal::DecorationAliasScopeINTEL ||
+        W[2] == internal::DecorationNoAliasINTEL)
+      AddRange(3, 4);
+    return true;
+  case OpName:
+  case OpMemberName:
+  case OpMemberDecorate:
+  case OpDecorateString:
+  case OpMemberDecorateString:
+  case OpExecutionMode:
+  case OpLine:
+  case OpTypeForwardPointer:
+  case OpBranch:
+  case OpSelectionMerge:
+  case OpReturnValue:
+  case OpLifetimeStart:
+  case OpLifetimeStop:
+  case OpAssumeTrueKHR:
+    AddRange(1, 2);
+    return WC >= 2;
+  case OpDecorateId:
+  case OpExecutionModeId:
+    AddRange(1, 2);
+    AddFrom(3);
+    return WC >= 3;
+  case OpGroupDecorate:
+  case OpTypeStructContinuedINTEL:
+  case OpConstantCompositeContinuedINTEL:
+  case OpSpecConstantCompositeContinuedINTEL:
+  case OpControlBarrier:
+  case OpMemoryBarrier:
+    AddFrom(1);
+    return true;
+  case OpGroupMemberDecorate:
+    AddRange(1, 2);
+    for (unsigned P = 2; P < WC; P += 2)
+      Ids.push_back(P);
+    return true;
+  case OpEntryPoint:
+    if (WC < 4)
+      return false;
+    Ids.push_back(2);
+    AddFrom(3 + getStringWordCount(W, 3));
+    return true;
+  case OpTypeVector:
+  case OpTypeMatrix:
+  case OpTypeImage:
+  case OpTypeSampledImage:
+  case OpTypeRuntimeArray:
+  case OpTypeVmeImageINTEL:
+    if (!Result(1))
+      return false;
+    AddRange(2, 3);
+    return WC >= 3;
+  case OpTypeArray:
+    if (!Result(1))
+      return false;
+    AddRange(2, 4);
+    return WC >= 4;
+  case OpTypeStruct:
+  case OpTypeFunction:
+  case internal::OpAliasDomainDeclINTEL:
+  case internal::OpAliasScopeDeclINTEL:
+  case internal::OpAliasScopeListDeclINTEL:
+    if (!Result(1))
+      return false;
+    AddFrom(2);
+    return true;
+  case OpTypePointer:
+    if (!Result(1))
+      return false;
+    AddRange(3, 4);
+    return WC >= 4;
+  case OpConstant:
+  case OpSpecConstant:
+  case OpConstantSampler:
+  case OpConstantTrue:
+  case OpConstantFalse:
+  case OpSpecConstantTrue:
+  case OpSpecConstantFalse:
+  case OpConstantNull:
+  case OpUndef:
+  case OpConstantPipeStorage:
+  case OpFunctionParameter:
+    return Result(2);
+  case OpConstantComposite:
+  case OpSpecConstantComposite:
+  case OpConstFunctionPointerINTEL:
+  case OpFunctionCall:
+  case OpPhi:
+  case OpSelect:
+  case OpCompositeConstruct:
+  case OpCopyObject:
+  case OpVectorExtractDynamic:
+  case OpVectorInsertDynamic:
+  case OpFMod:
+  case OpFRem:
+  case OpVectorTimesScalar:
+  case OpVectorTimesMatrix:
+  case OpMatrixTimesScalar:
+  case OpMatrixTimesVector:
+  case OpMatrixTimesMatrix:
+  case OpTranspose:
+  case OpGroupAsyncCopy:
+    if (!Result(2))
+      return false;
+    AddFrom(3);
+    return true;
+  case OpSpecConstantOp:
+    if (!Result(2) || WC < 4)
+      return false;
+    switch (W[3]) {
+    case OpCompositeExtract:
+      AddRange(4, 5);
+      break;
+    case OpCompositeInsert:
+    case OpVectorShuffle:
+      AddRange(4, 6);
+      break;
+    default:
+      AddFrom(4);
+    }
+    return true;
+  case OpVariable:
+    if (!Result(2))
+      return false;
+    AddRange(4, 5);
+    return true;
+  case OpFunction:
+    if (!Result(2))
+      return false;
+    AddRange(4, 5);
+    return WC >= 5;
+  case OpLoad:
+    if (!Result(2) || WC < 4)
+      return false;
+    Ids.push_back(3);
+    return MemoryAccess(4);
+  case OpStore:
+  case OpCopyMemory:
+    if (WC < 3)
+      return false;
+    AddRange(1, 3);
+    return MemoryAccess(3);
+  case OpCopyMemorySized:
+    if (WC < 4)
+      return false;
+    AddRange(1, 4);
+    return MemoryAccess(4);
+  case OpBranchConditional:
+    AddRange(1, 4);
+    return WC >= 4;
+  case OpLoopMerge:
+    AddRange(1, 3);
+    return WC >= 4;
+  case OpSwitch: {
+    if (WC < 3)
+      return false;
+    AddRange(1, 3);
+    if (WC == 3)
+      return true;
+    auto Type = ValueTypes.find(M.Offset + W[1]);
+    if (Type == ValueTypes.end())
+      return false;
+    unsigned LiteralWords = IntWidths.lookup(Type->second) > 32 ? 2 : 1;
+    unsigned P = 3;
+    for (; P + LiteralWords < WC; P += LiteralWords + 1)
+      Ids.push_back(P + LiteralWords);
+    return P == WC;
+  }
+  case OpCompositeExtract:
+    if (!Result(2))
+      return false;
+    AddRange(3, 4);
+    return WC >= 4;
+  case OpCompositeInsert:
+  case OpVectorShuffle:
+    if (!Result(2))
+      return false;
+    AddRange(3, 5);
+    return WC >= 5;
+  case OpExtInst: {
+    if (!Result(2) || WC < 5 || !W[3] || W[3] >= M.Bound)
+      return false;
+    auto Set = ExtInstSets.find(resolve(M.Offset + W[3]));
+    uint64_t Literals;
+    if (Set == ExtInstSets.end() ||
+        !getExtInstLiterals(Set->second, W[4], Literals))
+      return false;
+    Ids.push_back(3);
+    for (unsigned P = 5; P < WC; ++P)
+      if (P - 5 >= 64 || !(Literals & (uint64_t(1) << (P - 5))))
+        Ids.push_back(P);
+    return true;
+  }
+  default:
+    break;
+  }
+
+  if (isTypeOpCode(OC))
+    return Result(1);
+
+  const SPIRVInstTemplateBase *Template = getInstTemplate(OC);
+  if (!Template)
+    return false;
+  unsigned P = 1;
+  if (Template->hasType()) {
+    if (WC <= P)
+      return false;
+    Ids.push_back(P++);
+  }
+  if (Template->hasId()) {
+    if (WC <= P)
+      return false;
+    I.Result = P;
+    Ids.push_back(P++);
+  }
+  for (unsigned Operand = 0; P < WC; ++P, ++Operand)
+    if (!Template->isOperandLiteral(Operand))
+      Ids.push_back(P);
+  return true;
+}
+
+// Replace the definition of a type or a constant by an identical one seen
+// before. Definitions are compared by their operands, with ids resolved, and
+// by their decorations.
+void ModuleLinker::unify(
+    InputModule &M, const LinkInst &I,
+    const DenseMap<SPIRVId, SmallVector<uint32_t, 4>> &Decorations,
+    const DenseMap<SPIRVId, SmallVector<uint32_t, 4>> &Names,
+    const DenseSet<SPIRVId> &NoUnify) {
+  const SPIRVId Id = M.Offset + I.Words[I.Result];
+  if (NoUnify.count(Id))
+    return;
+  SmallVector<uint32_t, 16> Key;
+  auto IdPos = M.IdPositions.begin() + I.IdBegin;
+  auto IdEnd = M.IdPositions.begin() + I.IdEnd;
+  for (unsigned P = 0; P < I.Words.size(); ++P) {
+    bool IsId = IdPos != IdEnd && *IdPos == P;
+    if (IsId)
+      ++IdPos;
+    if (P == I.Result)
+      continue;
+    Key.push_back(IsId ? resolve(M.Offset + I.Words[P]) : I.Words[P]);
+  }
+  auto Decos = Decorations.find(Id);
+  if (Decos != Decorations.end()) {
+    Key.push_back(~0U);
+    Key.append(Decos->second.begin(), Decos->second.end());
+  }
+  // Definitions with different names, e.g. structs with the same members,
+  // are kept apart.
+  auto Name = Names.find(Id);
+  if (Name != Names.end()) {
+    Key.push_back(~0U - 1);
+    Key.push_back(Name->second.size());
+    Key.append(Name->second.begin(), Name->second.end());
+  }
+  auto Ins = TypesAndConstants.try_emplace(
+      StringRef(reinterpret_cast<const char *>(Key.data()),
+                Key.size() * sizeof(uint32_t)),
+      Id);
+  if (!Ins.second)
+    Replace[Id] = Ins.first->second;
+}
+
+bool ModuleLinker::scan(InputModule &M) {
+  ArrayRef<uint32_t> Words = M.Words;
+  DenseMap<SPIRVId, SmallVector<uint32_t, 4>> Decorations;
+  // OpName and OpMemberName operands of each id.
+  DenseMap<SPIRVId, SmallVector<uint32_t, 4>> Names;
+  DenseSet<SPIRVId> NoUnify;
+  size_t Pos = HeaderSize;
+  bool InFunction = false;
+  while (Pos < Words.size()) {
+    SPIRVWord WordCount = Words[Pos] >> WordCountShift;
+    Op OC = static_cast<Op>(Words[Pos] & OpCodeMask);
+    if (WordCount == 0 || Pos + WordCount > Words.size())
+      return fail("Invalid SPIR-V binary");
+    LinkInst I;
+    I.Words = Words.slice(Pos, WordCount);
+    I.IdBegin = M.IdPositions.size();
+    if (!classify(M, I)) {
+      std::string Name;
+      if (!OpCodeNameMap::find(OC, &Name))
+        Name = std::to_string(OC);
+      return fail("Cannot link instruction " + Name);
+    }
+    I.IdEnd = M.IdPositions.size();
+    for (unsigned P = I.IdBegin; P != I.IdEnd; ++P) {
+      SPIRVWord Id = I.Words[M.IdPositions[P]];
+      if (Id == 0 || Id >= M.Bound)
+        return fail("Invalid id in SPIR-V binary");
+    }
+    const unsigned Index = M.Insts.size();
+    M.Insts.push_back(I);
+    Pos += WordCount;
+    const SPIRVId Result = I.Result ? M.Offset + I.Words[I.Result] : 0;
+
+    if (I.Result == 2 && IntWidths.count(M.Offset + I.Words[1]))
+      ValueTypes[Result] = M.Offset + I.Words[1];
+
+    if (OC == OpFunction) {
+      InFunction = true;
+      M.Functions.emplace_back(Index, Index);
+      M.IsDeclaration.push_back(true);
+      SymbolTypes[Result] = {M.Offset + I.Words[1], M.Offset + I.Words[4]};
+    }
+    if (InFunction) {
+      if (OC == OpLabel)
+        M.IsDeclaration.back() = false;
+      if (OC == OpFunctionEnd) {
+        M.Functions.back().second = Index + 1;
+        InFunction = false;
+      }
+      continue;
+    }
+    if (!M.Functions.empty())
+      return fail("Invalid SPIR-V binary");
+
+    LayoutSection Section = getLayoutSection(OC);
+    M.Sections[Section].push_back(Index);
+    switch (OC) {
+    case OpExtInstImport: {
+      std::string Name = getString(I.Words, 2);
+      auto Ins = ExtInstImports.try_emplace(Name, Result);
+      if (!Ins.second) {
+        Replace[Result] = Ins.first->second;
+        break;
+      }
+      SPIRVExtInstSetKind Kind = SPIRVEIS_Count;
+      SPIRVBuiltinSetNameMap::rfind(Name, &Kind);
+      ExtInstSets[Result] = Kind;
+      break;
+    }
+    case OpString: {
+      ArrayRef<uint32_t> Str = I.Words.drop_front(2);
+      auto Ins = Strings.try_emplace(
+          StringRef(reinterpret_cast<const char *>(Str.data()),
+                    Str.size() * sizeof(uint32_t)),
+          Result);
+      if (!Ins.second)
+        Replace[Result] = Ins.first->second;
+      break;
+    }
+    case OpName:
+    case OpMemberName: {
+      auto &Name = Names[M.Offset + I.Words[1]];
+      Name.push_back(I.Words[0]);
+      Name.append(I.Words.begin() + 2, I.Words.end());
+      break;
+    }
+    case OpGroupDecorate:
+      for (unsigned P = 2; P < I.Words.size(); ++P)
+        NoUnify.insert(M.Offset + I.Words[P]);
+      break;
+    case OpGroupMemberDecorate:
+      for (unsigned P = 2; P < I.Words.size(); P += 2)
+        NoUnify.insert(M.Offset + I.Words[P]);
+      break;
+    case OpTypeForwardPointer:
+      NoUnify.insert(M.Offset + I.Words[1]);
+      break;
+    case OpTypeInt:
+      if (I.Words.size() >= 3)
+        IntWidths[Result] = I.Words[2];
+      break;
+    case OpVariable:
+      SymbolTypes[Result] = {M.Offset + I.Words[1], 0};
+      break;
+    default:
+      break;
+    }
+
+    if (isTargetDecoration(OC)) {
+      if (OC == OpDecorate && I.Words[2] == DecorationLinkageAttributes &&
+          I.Words.size() >= 5)
+        Linkage.push_back({getString(I.Words, 3), M.Offset + I.Words[1],
+                           I.Words.back()});
+      auto &Decos = Decorations[M.Offset + I.Words[1]];
+      Decos.push_back(I.Words[0]);
+      for (unsigned P = 2; P < I.Words.size(); ++P)
+        Decos.push_back(OC == OpDecorateId ? resolve(M.Offset + I.Words[P])
+                                           : I.Words[P]);
+    }
+
+    if (I.Result && isUnifiable(OC)) {
+      // Definitions continued by the following instructions are kept.
+      bool IsContinued =
+          Pos < Words.size() &&
+          ((Words[Pos] & OpCodeMask) == OpTypeStructContinuedINTEL ||
+           (Words[Pos] & OpCodeMask) == OpConstantCompositeContinuedINTEL);
+      if (!IsContinued)
+        unify(M, I, Decorations, Names, NoUnify);
+    }
+  }
+  if (InFunction)
+    return fail("Invalid SPIR-V binary");
+  return true;
+}
+
+// Resolve imported symbols to the definitions exported by other modules.
+// Duplicate LinkOnceODR definitions are replaced by the first one, or by a
+// strong definition of the same symbol.
+bool ModuleLinker::resolveLinkage() {
+  StringMap<std::pair<SPIRVId, bool>> Symbols;
+  std::vector<std::pair<const LinkageDecl *, SPIRVId>> Resolved;
+  for (const LinkageDecl &Decl : Linkage) {
+    if (Decl.Type != LinkageTypeExport && Decl.Type != LinkageTypeLinkOnceODR)
+      continue;
+    bool IsLinkOnce = Decl.Type == LinkageTypeLinkOnceODR;
+    auto Ins = Symbols.try_emplace(Decl.Name, Decl.Id, IsLinkOnce);
+    if (Ins.second)
+      continue;
+    auto &Def = Ins.first->second;
+    if (IsLinkOnce) {
+      Replace[Decl.Id] = Def.first;
+      Dropped[Decl.Id] = true;
+      Resolved.emplace_back(&Decl, Def.first);
+    } else if (Def.second) {
+      Replace[Def.first] = Decl.Id;
+      Dropped[Def.first] = true;
+      Resolved.emplace_back(&Decl, Def.first);
+      Def = {Decl.Id, false};
+    } else {
+      return fail("Symbol " + Decl.Name +
+                  " is defined in more than one module");
+    }
+  }
+  for (const LinkageDecl &Decl : Linkage) {
+    if (Decl.Type != LinkageTypeImport)
+      continue;
+    auto Def = Symbols.find(Decl.Name);
+    if (Def == Symbols.end())
+      continue;
+    Replace[Decl.Id] = Def->second.first;
+    Dropped[Decl.Id] = true;
+    Resolved.emplace_back(&Decl, Def->second.first);
+  }
+  for (auto &R : Resolved) {
+    auto A = SymbolTypes.find(R.first->Id);
+    auto B = SymbolTypes.find(R.second);
+    if (A == SymbolTypes.end() || B == SymbolTypes.end())
+      return fail("Symbol " + R.first->Name +
+                  " is not a function or a global variable");
+    if (resolve(A->second.first) != resolve(B->second.first) ||
+        resolve(A->second.second) != resolve(B->second.second))
+      return fail("Type mismatch for symbol " + R.first->Name);
+  }
+  return true;
+}
+
+void ModuleLinker::emit(const InputModule &M, const LinkInst &I,
+                        SmallVectorImpl<uint32_t> &Out) {
+  auto IdPos = M.IdPositions.begin() + I.IdBegin;
+  auto IdEnd = M.IdPositions.begin() + I.IdEnd;
+  for (unsigned P = 0; P < I.Words.size(); ++P) {
+    if (IdPos != IdEnd && *IdPos == P) {
+      Out.push_back(getFinalId(M.Offset + I.Words[P]));
+      ++IdPos;
+    } else {
+      Out.push_back(I.Words[P]);
+    }
+  }
+}
+
+// Emit \p I unless an identical instruction has already been emitted.
+void ModuleLinker::emitUnique(const InputModule &M, const LinkInst &I,
+                              SmallVectorImpl<uint32_t> &Out,
+                              StringSet<> &Emitted) {
+  SmallVector<uint32_t, 16> Inst;
+  emit(M, I, Inst);
+  if (Emitted
+          .insert(StringRef(reinterpret_cast<const char *>(Inst.data()),
+                            Inst.size() * sizeof(uint32_t)))
+          .second)
+    Out.append(Inst.begin(), Inst.end());
+}
+
+bool ModuleLinker::link(ArrayRef<ArrayRef<uint32_t>> Inputs,
+                        SmallVectorImpl<uint32_t> &Out) {
+  if (Inputs.empty())
+    return fail("No modules to link");
+  SPIRVId NumIds = 0;
+  SPIRVWord Version = 0;
+  for (ArrayRef<uint32_t> Words : Inputs) {
+    if (Words.size() < HeaderSize || Words[0] != MagicNumber)
+      return fail("Invalid SPIR-V binary");
+    Modules.emplace_back();
+    InputModule &M = Modules.back();
+    M.Words = Words;
+    M.Offset = NumIds;
+    M.Bound = Words[3];
+    if (!M.Bound)
+      return fail("Invalid SPIR-V binary");
+    NumIds += M.Bound - 1;
+    Version = std::max(Version, Words[1]);
+  }
+  Replace.assign(NumIds + 1, 0);
+  Dropped.assign(NumIds + 1, false);
+  FinalIds.assign(NumIds + 1, 0);
+
+  for (InputModule &M : Modules)
+    if (!scan(M))
+      return false;
+  if (!resolveLinkage())
+    return false;
+  for (InputModule &M : Modules)
+    for (auto &F : M.Functions) {
+      if (!Dropped[M.Offset + M.Insts[F.first].Words[2]])
+        continue;
+      for (unsigned I = F.first; I != F.second; ++I)
+        if (M.Insts[I].Result)
+          Dropped[M.Offset + M.Insts[I].Words[M.Insts[I].Result]] = true;
+    }
+
+  Out.clear();
+  Out.append({MagicNumber, Version, Inputs[0][2], 0, 0});
+  auto IsDropped = [&](const InputModule &M, const LinkInst &I) {
+    if (!I.Result)
+      return false;
+    SPIRVId Id = M.Offset + I.Words[I.Result];
+    return Dropped[Id] || Replace[Id] != 0;
+  };
+  auto IsTargetDropped = [&](const InputModule &M, const LinkInst &I) {
+    return Dropped[M.Offset + I.Words[1]];
+  };
+
+  std::vector<uint32_t> MemoryModel;
+  StringSet<> EntryPoints;
+  DenseSet<SPIRVId> Named;
+  DenseSet<std::pair<SPIRVId, SPIRVWord>> MemberNamed;
+  for (unsigned S = 0; S != LS_Count; ++S) {
+    StringSet<> Emitted;
+    for (InputModule &M : Modules)
+      for (unsigned Index : M.Sections[S]) {
+        const LinkInst &I = M.Insts[Index];
+        Op OC = static_cast<Op>(I.Words[0] & OpCodeMask);
+        switch (S) {
+        case LS_Capability:
+        case LS_Extension:
+        case LS_ModuleProcessed:
+        case LS_ExecutionMode:
+          emitUnique(M, I, Out, Emitted);
+          break;
+        case LS_MemoryModel:
+          if (MemoryModel.empty()) {
+            MemoryModel.assign(I.Words.begin(), I.Words.end());
+            Out.append(I.Words.begin(), I.Words.end());
+          } else if (!std::equal(MemoryModel.begin(), MemoryModel.end(),
+                                 I.Words.begin(), I.Words.end())) {
+            return fail("Memory models of linked modules differ");
+          }
+          break;
+        case LS_EntryPoint:
+          if (!EntryPoints
+                   .insert(std::to_string(I.Words[1]) + " " +
+                           getString(I.Words, 3))
+                   .second)
+            return fail("Entry point " + getString(I.Words, 3) +
+                        " is defined in more than one module");
+          emit(M, I, Out);
+          break;
+        case LS_Name:
+          if (IsTargetDropped(M, I))
+            break;
+          if (OC == OpName ? Named.insert(resolve(M.Offset + I.Words[1])).second
+                           : MemberNamed
+                                 .insert({resolve(M.Offset + I.Words[1]),
+                                          I.Words[2]})
+                                 .second)
+            emit(M, I, Out);
+          break;
+        case LS_Annotation:
+          if (OC == OpGroupDecorate || OC == OpGroupMemberDecorate) {
+            unsigned Stride = OC == OpGroupDecorate ? 1 : 2;
+            SmallVector<uint32_t, 16> Inst{
+                0, getFinalId(M.Offset + I.Words[1])};
+            for (unsigned P = 2; P < I.Words.size(); P += Stride) {
+              if (Dropped[M.Offset + I.Words[P]])
+                continue;
+              Inst.push_back(getFinalId(M.Offset + I.Words[P]));
+              if (Stride == 2 && P + 1 < I.Words.size())
+                Inst.push_back(I.Words[P + 1]);
+            }
+            if (Inst.size() == 2)
+              break;
+            Inst[0] = (Inst.size() << WordCountShift) | OC;
+            Out.append(Inst.begin(), Inst.end());
+            break;
+          }
+          if (OC == OpDecorationGroup ? IsDropped(M, I)
+                                      : IsTargetDropped(M, I))
+            break;
+          emitUnique(M, I, Out, Emitted);
+          break;
+        default:
+          // Extended instruction set imports, strings, types, constants and
+          // global variables. Unified definitions are dropped.
+          if (IsDropped(M, I))
+            break;
+          if (OC == OpSource || OC == OpSourceExtension ||
+              OC == OpSourceContinued) {
+            emitUnique(M, I, Out, Emitted);
+            break;
+          }
+          emit(M, I, Out);
+          break;
+        }
+      }
+  }
+
+  // All function declarations precede all function definitions.
+  for (bool Declarations : {true, false})
+    for (InputModule &M : Modules)
+      for (unsigned F = 0; F != M.Functions.size(); ++F) {
+        if (M.IsDeclaration[F] != Declarations)
+          continue;
+        auto Range = M.Functions[F];
+        if (Dropped[M.Offset + M.Insts[Range.first].Words[2]])
+          continue;
+        for (unsigned I = Range.first; I != Range.second; ++I)
+          emit(M, M.Insts[I], Out);
+      }
+
+  Out[3] = NextId;
+  return true;
+}
+
+} // namespace
+
+bool llvm::linkSpirv(ArrayRef<ArrayRef<uint32_t>> Inputs,
+                     SmallVectorImpl<uint32_t> &Out, std::string &ErrMsg) {
+  return ModuleLinker(ErrMsg).link(Inputs, Out);
+}
+
+std::unique_ptr<SPIRVModule>
+SPIRV::linkSpirvModules(ArrayRef<SPIRVModule *> Modules, std::string &ErrMsg) {
+  std::vector<std::vector<uint32_t>> Binaries;
+  for (SPIRVModule *BM : Modules) {
+    std::ostringstream OS;
+    OS << *BM;
+    const std::string &Img = OS.str();
+    Binaries.emplace_back(Img.size() / sizeof(uint32_t));
+    std::memcpy(Binaries.back().data(), Img.data(),
+                Binaries.back().size() * sizeof(uint32_t));
+  }
+  SmallVector<ArrayRef<uint32_t>, 8> Inputs(Binaries.begin(), Binaries.end());
+  SmallVector<uint32_t, 0> Out;
+  if (!linkSpirv(Inputs, Out, ErrMsg))
+    return nullptr;
+  std::istringstream IS(std::string(reinterpret_cast<const char *>(Out.data()),
+                                    Out.size() * sizeof(uint32_t)));
+  return readSpirvModule(IS, ErrMsg);
+}
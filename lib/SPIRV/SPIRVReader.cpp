@@ -40,6 +40,8 @@
 #include "OCLUtil.h"
 #include "SPIRVAsm.h"
 #include "SPIRVBasicBlock.h"
+#include "SPIRVCache.h"
+#include "SPIRVDebug.h"
 #include "SPIRVExtInst.h"
 #include "SPIRVFunction.h"
 #include "SPIRVInstruction.h"
@@ -47,7 +49,9 @@
 #include "SPIRVMDBuilder.h"
 #include "SPIRVMemAliasingINTEL.h"
 #include "SPIRVModule.h"
+#include "SPIRVStats.h"
 #include "SPIRVToLLVMDbgTran.h"
+#include "SPIRVToOCL.h"
 #include "SPIRVType.h"
 #include "SPIRVUtil.h"
 #include "SPIRVValue.h"
@@ -57,6 +61,8 @@
 #include "llvm/ADT/SmallSet.h"
 #include "llvm/Analysis/LoopInfo.h"
 #include "llvm/BinaryFormat/Dwarf.h"
+#include "llvm/Bitcode/BitcodeReader.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
 #include "llvm/IR/Constants.h"
 #include "llvm/IR/DerivedTypes.h"
 #include "llvm/IR/Dominators.h"
@@ -64,7 +70,6 @@
 #include "llvm/IR/InlineAsm.h"
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/IntrinsicInst.h"
-#include "llvm/IR/LegacyPassManager.h"
 #include "llvm/IR/MDBuilder.h"
 #include "llvm/IR/Metadata.h"
 #include "llvm/IR/Module.h"
@@ -73,9 +78,11 @@
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/ThreadPool.h"
 
 #include <algorithm>
 #include <cstdlib>
+#include <cstring>
 #include <fstream>
 #include <functional>
 #include <iostream>
@@ -101,10 +108,6 @@ cl::opt<bool> SPIRVEnableStepExpansion(
 // Prefix for placeholder global variable name.
 const char *KPlaceholderPrefix = "placeholder.";
 
-// Save the translated LLVM before validation for debugging purpose.
-static bool DbgSaveTmpLLVM = false;
-static const char *DbgTmpLLVMFileName = "_tmp_llvmbil.ll";
-
 namespace kOCLTypeQualifierName {
 const static char *Volatile = "volatile";
 const static char *Restrict = "restrict";
@@ -115,15 +118,6 @@ static bool isKernel(SPIRVFunction *BF) {
   return BF->getModule()->isEntryPoint(ExecutionModelKernel, BF->getId());
 }
 
-static void dumpLLVM(Module *M, const std::string &FName) {
-  std::error_code EC;
-  raw_fd_ostream FS(FName, EC, sys::fs::F_None);
-  if (!EC) {
-    FS << *M;
-    FS.close();
-  }
-}
-
 static MDNode *getMDNodeStringIntVec(LLVMContext *Context,
                                      const std::vector<SPIRVWord> &IntVals) {
   std::vector<Metadata *> ValueVec;
@@ -1446,6 +1440,81 @@ Value *SPIRVToLLVM::oclTransConstantPipeStorage(
                             GlobalValue::NotThreadLocal, SPIRAS_Global);
 }
 
+// Gather the literal bits of every constituent of a composite constant,
+// including the constituents of its SPV_INTEL_long_constant_composite
+// continuations. Fails as soon as a constituent is not a plain OpConstant.
+template <typename T>
+static bool collectCompositeLiterals(SPIRVConstantComposite *BCC,
+                                     SmallVectorImpl<T> &Literals) {
+  auto Collect = [&](const std::vector<SPIRVValue *> &Elements) {
+    for (auto *E : Elements) {
+      if (E->getOpCode() != OpConstant)
+        return false;
+      Literals.push_back(
+          static_cast<T>(static_cast<SPIRVConstant *>(E)->getZExtIntValue()));
+    }
+    return true;
+  };
+  if (!Collect(BCC->getElements()))
+    return false;
+  for (auto &CI : BCC->getContinuedInstructions())
+    if (!Collect(CI->getElements()))
+      return false;
+  return true;
+}
+
+template <typename T, typename BuildFn>
+static Constant *buildFromCompositeLiterals(SPIRVConstantComposite *BCC,
+                                            BuildFn Build) {
+  SmallVector<T, 16> Literals;
+  if (!collectCompositeLiterals(BCC, Literals))
+    return nullptr;
+  return Build(makeArrayRef(Literals));
+}
+
+// Translate an array or vector of scalar integer/floating-point OpConstant
+// directly into a ConstantDataArray/ConstantDataVector, without materializing
+// a ConstantInt/ConstantFP per element. Large lookup tables are dominated by
+// that per-element cost. Returns nullptr if the composite doesn't qualify.
+static Constant *transConstantDataSequential(SPIRVConstantComposite *BCC,
+                                             Type *LT) {
+  bool IsVector = LT->isVectorTy();
+  if (!IsVector && !LT->isArrayTy())
+    return nullptr;
+  Type *ElemTy = IsVector ? cast<VectorType>(LT)->getElementType()
+                          : LT->getArrayElementType();
+  LLVMContext &C = LT->getContext();
+  auto GetInt = [&](auto Literals) -> Constant * {
+    return IsVector ? ConstantDataVector::get(C, Literals)
+                    : ConstantDataArray::get(C, Literals);
+  };
+  auto GetFP = [&](auto Literals) -> Constant * {
+    return IsVector ? ConstantDataVector::getFP(ElemTy, Literals)
+                    : ConstantDataArray::getFP(ElemTy, Literals);
+  };
+  if (ElemTy->isIntegerTy()) {
+    switch (ElemTy->getIntegerBitWidth()) {
+    case 8:
+      return buildFromCompositeLiterals<uint8_t>(BCC, GetInt);
+    case 16:
+      return buildFromCompositeLiterals<uint16_t>(BCC, GetInt);
+    case 32:
+      return buildFromCompositeLiterals<uint32_t>(BCC, GetInt);
+    case 64:
+      return buildFromCompositeLiterals<uint64_t>(BCC, GetInt);
+    default:
+      return nullptr;
+    }
+  }
+  if (ElemTy->isHalfTy())
+    return buildFromCompositeLiterals<uint16_t>(BCC, GetFP);
+  if (ElemTy->isFloatTy())
+    return buildFromCompositeLiterals<uint32_t>(BCC, GetFP);
+  if (ElemTy->isDoubleTy())
+    return buildFromCompositeLiterals<uint64_t>(BCC, GetFP);
+  return nullptr;
+}
+
 // A pointer annotation may have been generated for the operand. If the operand
 // is used further in IR, it should be replaced with the intrinsic call result.
 // Otherwise, the generated pointer annotation call is left unused.
@@ -1625,6 +1694,10 @@ Value *SPIRVToLLVM::transValueWithoutDecoration(SPIRVValue *BV, Function *F,
   case OpConstantComposite:
   case OpSpecConstantComposite: {
     auto BCC = static_cast<SPIRVConstantComposite *>(BV);
+    if (OC == OpConstantComposite)
+      if (Constant *CDS =
+              transConstantDataSequential(BCC, transType(BCC->getType())))
+        return mapValue(BV, CDS);
     std::vector<Constant *> CV;
     for (auto &I : BCC->getElements())
       CV.push_back(dyn_cast<Constant>(transValue(I, F, BB)));
@@ -1703,7 +1776,10 @@ Value *SPIRVToLLVM::transValueWithoutDecoration(SPIRVValue *BV, Function *F,
     SPIRVStorageClassKind BS = BVar->getStorageClass();
     Constant *Initializer = nullptr;
     SPIRVValue *Init = BVar->getInitializer();
-    if (Init)
+    if (isDefinedElsewhere(BVar) &&
+        BVar->getLinkageType() == LinkageTypeExport)
+      LinkageTy = GlobalValue::ExternalLinkage;
+    else if (Init)
       Initializer = dyn_cast<Constant>(transValue(Init, F, BB, false));
     else if (LinkageTy == GlobalValue::CommonLinkage)
       // In LLVM, variables with common linkage type must be initialized to 0.
@@ -2878,6 +2954,10 @@ Function *SPIRVToLLVM::transFunction(SPIRVFunction *BF) {
 
   auto IsKernel = isKernel(BF);
   auto Linkage = IsKernel ? GlobalValue::ExternalLinkage : transLinkageType(BF);
+  // Functions that can't be referenced across shards are translated in full
+  // wherever they are used.
+  bool IsDeclaration = isDefinedElsewhere(BF) &&
+                       (IsKernel || BF->getLinkageType() == LinkageTypeExport);
   FunctionType *FT = dyn_cast<FunctionType>(transType(BF->getFunctionType()));
   std::string FuncName = BF->getName();
   StringRef FuncNameRef(FuncName);
@@ -2895,6 +2975,7 @@ Function *SPIRVToLLVM::transFunction(SPIRVFunction *BF) {
     F = Function::Create(FT, Linkage, FuncName, M);
   F = cast<Function>(mapValue(BF, F));
   mapFunction(BF, F);
+  addBuiltinToLower(F);
 
   if (F->isIntrinsic())
     return F;
@@ -2946,6 +3027,9 @@ Function *SPIRVToLLVM::transFunction(SPIRVFunction *BF) {
                     SPIRSPIRVFuncParamAttrMap::rmap(Kind));
   });
 
+  if (IsDeclaration)
+    return F;
+
   // Creating all basic blocks before creating instructions.
   for (size_t I = 0, E = BF->getNumBasicBlock(); I != E; ++I) {
     transValue(BF->getBasicBlock(I), F, nullptr);
@@ -2962,6 +3046,9 @@ Function *SPIRVToLLVM::transFunction(SPIRVFunction *BF) {
 
   transLLVMLoopMetadata(F);
 
+  if (BuiltinLowering)
+    BuiltinLowering->lowerFunction(*F);
+
   return F;
 }
 
@@ -3268,9 +3355,16 @@ Instruction *SPIRVToLLVM::transBuiltinFromInst(const std::string &FuncName,
     }
   }
   if (!HasFuncPtrArg) {
-    if (BM->getDesiredBIsRepresentation() != BIsRepresentation::SPIRVFriendlyIR)
-      mangleOpenClBuiltin(FuncName, ArgTys, MangledName);
-    else
+    if (BM->getDesiredBIsRepresentation() !=
+        BIsRepresentation::SPIRVFriendlyIR) {
+      // Instructions translated directly to OpenCL have no SPIR-V name.
+      if (StringRef(FuncName).startswith(kSPIRVName::Prefix) &&
+          isRenamedByBuiltinLowering(BI->getOpCode()))
+        mangleOpenClBuiltin(OCLSPIRVBuiltinMap::rmap(BI->getOpCode()), ArgTys,
+                            MangledName);
+      else
+        mangleOpenClBuiltin(FuncName, ArgTys, MangledName);
+    } else
       MangledName =
           getSPIRVFriendlyIRFunctionName(FuncName, BI->getOpCode(), ArgTys);
 
@@ -3300,6 +3394,7 @@ Instruction *SPIRVToLLVM::transBuiltinFromInst(const std::string &FuncName,
     if (isGroupOpCode(OC) || isIntelSubgroupOpCode(OC))
       Func->addFnAttr(Attribute::Convergent);
   }
+  addBuiltinToLower(Func);
   auto Call =
       CallInst::Create(Func, transValue(Ops, BB->getParent(), BB), "", BB);
   setName(Call, BI);
@@ -3315,6 +3410,12 @@ SPIRVToLLVM::SPIRVToLLVM(Module *LLVMModule, SPIRVModule *TheSPIRVModule)
   assert(M && "Initialization without an LLVM module is not allowed");
   Context = &M->getContext();
   DbgTran.reset(new SPIRVToLLVMDbgTran(TheSPIRVModule, LLVMModule, this));
+  BuiltinLowering =
+      createSPIRVBIsLowering(TheSPIRVModule->getDesiredBIsRepresentation());
+}
+
+bool SPIRVToLLVM::isDefinedElsewhere(const SPIRVValue *V) const {
+  return DefinedElsewhere && DefinedElsewhere->count(V->getId());
 }
 
 std::string SPIRVToLLVM::getOCLBuiltinName(SPIRVInstruction *BI) {
@@ -3465,50 +3566,70 @@ bool SPIRVToLLVM::translate() {
   if (!transAddressingModel())
     return false;
 
-  for (unsigned I = 0, E = BM->getNumVariables(); I != E; ++I) {
-    auto BV = BM->getVariable(I);
-    if (BV->getStorageClass() != StorageClassFunction)
-      transValue(BV, nullptr, nullptr);
-    else
-      transGlobalCtorDtors(BV);
+  {
+    TranslationPhaseTimer Timer("variables");
+    for (unsigned I = 0, E = BM->getNumVariables(); I != E; ++I) {
+      auto BV = BM->getVariable(I);
+      if (isDefinedElsewhere(BV))
+        continue;
+      if (BV->getStorageClass() != StorageClassFunction)
+        transValue(BV, nullptr, nullptr);
+      else
+        transGlobalCtorDtors(BV);
+    }
   }
 
-  // Compile unit might be needed during translation of debug intrinsics.
-  for (SPIRVExtInst *EI : BM->getDebugInstVec()) {
-    // Translate Compile Unit first.
-    // It shuldn't be far from the beginig of the vector
-    if (EI->getExtOp() == SPIRVDebug::CompilationUnit) {
+  {
+    TranslationPhaseTimer Timer("debug-info");
+    // Compile unit might be needed during translation of debug intrinsics.
+    for (SPIRVExtInst *EI : BM->getDebugInstVec()) {
+      // Translate Compile Unit first.
+      // It shuldn't be far from the beginig of the vector
+      if (EI->getExtOp() == SPIRVDebug::CompilationUnit) {
+        DbgTran->transDebugInst(EI);
+        // Fixme: there might be more then one Compile Unit.
+        break;
+      }
+    }
+    // Then translate all debug instructions.
+    for (SPIRVExtInst *EI : BM->getDebugInstVec()) {
       DbgTran->transDebugInst(EI);
-      // Fixme: there might be more then one Compile Unit.
-      break;
     }
   }
-  // Then translate all debug instructions.
-  for (SPIRVExtInst *EI : BM->getDebugInstVec()) {
-    DbgTran->transDebugInst(EI);
-  }
 
-  for (unsigned I = 0, E = BM->getNumFunctions(); I != E; ++I) {
-    transFunction(BM->getFunction(I));
-    transUserSemantic(BM->getFunction(I));
+  {
+    TranslationPhaseTimer Timer("functions");
+    for (unsigned I = 0, E = BM->getNumFunctions(); I != E; ++I) {
+      if (isDefinedElsewhere(BM->getFunction(I)))
+        continue;
+      transFunction(BM->getFunction(I));
+      transUserSemantic(BM->getFunction(I));
+    }
   }
 
-  transGlobalAnnotations();
+  {
+    TranslationPhaseTimer Timer("metadata");
+    transGlobalAnnotations();
 
-  if (!transMetadata())
-    return false;
-  if (!transFPContractMetadata())
-    return false;
-  transSourceLanguage();
-  if (!transSourceExtension())
-    return false;
-  transGeneratorMD();
-  if (!transOCLBuiltinsFromVariables())
-    return false;
-  if (!postProcessOCL())
-    return false;
-  eraseUselessFunctions(M);
+    if (!transMetadata())
+      return false;
+    if (!transFPContractMetadata())
+      return false;
+    transSourceLanguage();
+    if (!transSourceExtension())
+      return false;
+    transGeneratorMD();
+    if (!transOCLBuiltinsFromVariables())
+      return false;
+  }
+  {
+    TranslationPhaseTimer Timer("post-process-ocl");
+    if (!postProcessOCL())
+      return false;
+    eraseUselessFunctions(M);
+  }
 
+  TranslationPhaseTimer Timer("debug-info-finalize");
   DbgTran->addDbgInfoVersion();
   DbgTran->finalize();
   return true;
@@ -3976,6 +4097,8 @@ bool SPIRVToLLVM::transMetadata() {
   SmallVector<Function *, 2> CtorKernels;
   for (unsigned I = 0, E = BM->getNumFunctions(); I != E; ++I) {
     SPIRVFunction *BF = BM->getFunction(I);
+    if (isDefinedElsewhere(BF))
+      continue;
     Function *F = static_cast<Function *>(getTranslatedValue(BF));
     assert(F && "Invalid translated function");
 
@@ -4411,6 +4534,7 @@ Instruction *SPIRVToLLVM::transOCLBuiltinFromExtInst(SPIRVExtInst *BC,
     if (isFuncReadNone(UnmangledName))
       F->addFnAttr(Attribute::ReadNone);
   }
+  addBuiltinToLower(F);
   auto Args = transValue(BC->getValues(BArgs), F, BB);
   SPIRVDBG(dbgs() << "[transOCLBuiltinFromExtInst] Function: " << *F
                   << ", Args: ";
@@ -4540,67 +4664,82 @@ SPIRVToLLVM::transLinkageType(const SPIRVValue *V) {
 }
 
 Instruction *SPIRVToLLVM::transOCLAllAny(SPIRVInstruction *I, BasicBlock *BB) {
-  CallInst *CI = cast<CallInst>(transSPIRVBuiltinFromInst(I, BB));
-  assert(CI->getCalledFunction() && "Unexpected indirect call");
-  AttributeList Attrs = CI->getCalledFunction()->getAttributes();
-  return cast<Instruction>(mapValue(
-      I, mutateCallInstOCL(
-             M, CI,
-             [=](CallInst *, std::vector<Value *> &Args, llvm::Type *&RetTy) {
-               Type *Int32Ty = Type::getInt32Ty(*Context);
-               auto OldArg = CI->getOperand(0);
-               auto NewArgTy = FixedVectorType::get(
-                   Int32Ty,
-                   cast<FixedVectorType>(OldArg->getType())->getNumElements());
-               auto NewArg =
-                   CastInst::CreateSExtOrBitCast(OldArg, NewArgTy, "", CI);
-               Args[0] = NewArg;
-               RetTy = Int32Ty;
-               return getSPIRVFuncName(I->getOpCode(), getSPIRVFuncSuffix(I));
-             },
-             [=](CallInst *NewCI) -> Instruction * {
-               return CastInst::CreateTruncOrBitCast(
-                   NewCI, Type::getInt1Ty(*Context), "", NewCI->getNextNode());
-             },
-             &Attrs, /*TakeFuncName=*/true)));
+  // all() and any() take a vector of int rather than of bool.
+  Value *Arg = transValue(I->getOperands(), BB->getParent(), BB)[0];
+  Type *Int32Ty = Type::getInt32Ty(*Context);
+  auto *ArgTy = FixedVectorType::get(
+      Int32Ty, cast<FixedVectorType>(Arg->getType())->getNumElements());
+  Value *IntArg = CastInst::CreateSExtOrBitCast(Arg, ArgTy, "", BB);
+  return transOCLRelationalCall(I, IntArg, Int32Ty, BB);
 }
 
 Instruction *SPIRVToLLVM::transOCLRelational(SPIRVInstruction *I,
                                              BasicBlock *BB) {
-  CallInst *CI = cast<CallInst>(transSPIRVBuiltinFromInst(I, BB));
-  assert(CI->getCalledFunction() && "Unexpected indirect call");
-  AttributeList Attrs = CI->getCalledFunction()->getAttributes();
-  return cast<Instruction>(mapValue(
-      I, mutateCallInstOCL(
-             M, CI,
-             [=](CallInst *, std::vector<Value *> &Args, llvm::Type *&RetTy) {
-               Type *IntTy = Type::getInt32Ty(*Context);
-               RetTy = IntTy;
-               if (CI->getType()->isVectorTy()) {
-                 if (cast<FixedVectorType>(CI->getOperand(0)->getType())
-                         ->getElementType()
-                         ->isDoubleTy())
-                   IntTy = Type::getInt64Ty(*Context);
-                 if (cast<FixedVectorType>(CI->getOperand(0)->getType())
-                         ->getElementType()
-                         ->isHalfTy())
-                   IntTy = Type::getInt16Ty(*Context);
-                 RetTy = FixedVectorType::get(
-                     IntTy,
-                     cast<FixedVectorType>(CI->getType())->getNumElements());
-               }
-               return getSPIRVFuncName(I->getOpCode(), getSPIRVFuncSuffix(I));
-             },
-             [=](CallInst *NewCI) -> Instruction * {
-               Type *RetTy = Type::getInt1Ty(*Context);
-               if (NewCI->getType()->isVectorTy())
-                 RetTy = FixedVectorType::get(
-                     Type::getInt1Ty(*Context),
-                     cast<FixedVectorType>(NewCI->getType())->getNumElements());
-               return CastInst::CreateTruncOrBitCast(NewCI, RetTy, "",
-                                                     NewCI->getNextNode());
-             },
-             &Attrs, /*TakeFuncName=*/true)));
+  std::vector<Value *> Args =
+      transValue(I->getOperands(), BB->getParent(), BB);
+  Type *RetTy = Type::getInt32Ty(*Context);
+  if (I->getType()->isTypeVector()) {
+    // The result of vector relational builtins has the width of the operand.
+    Type *IntTy = RetTy;
+    Type *ElemTy = cast<FixedVectorType>(Args[0]->getType())->getElementType();
+    if (ElemTy->isDoubleTy())
+      IntTy = Type::getInt64Ty(*Context);
+    if (ElemTy->isHalfTy())
+      IntTy = Type::getInt16Ty(*Context);
+    RetTy =
+        FixedVectorType::get(IntTy, I->getType()->getVectorComponentCount());
+  }
+  return transOCLRelationalCall(I, Args, RetTy, BB);
+}
+
+Instruction *SPIRVToLLVM::transOCLRelationalCall(SPIRVInstruction *I,
+                                                 ArrayRef<Value *> Args,
+                                                 Type *RetTy, BasicBlock *BB) {
+  std::vector<Type *> ArgTys;
+  for (Value *Arg : Args)
+    ArgTys.push_back(Arg->getType());
+  Op OC = I->getOpCode();
+  std::string MangledName;
+  mangleOpenClBuiltin(isRenamedByBuiltinLowering(OC)
+                          ? OCLSPIRVBuiltinMap::rmap(OC)
+                          : getSPIRVFuncName(OC, getSPIRVFuncSuffix(I)),
+                      ArgTys, MangledName);
+  AttributeList Attrs;
+  if (isFuncNoUnwind())
+    Attrs = AttributeList::get(*Context, AttributeList::FunctionIndex,
+                               {Attribute::NoUnwind});
+  Function *Func = getOrCreateFunction(M, RetTy, ArgTys, MangledName, nullptr,
+                                       &Attrs, /*TakeName=*/true);
+  addBuiltinToLower(Func);
+  CallInst *Call = CallInst::Create(Func, Args, "", BB);
+  setAttrByCalledFunc(Call);
+
+  Type *BoolTy = Type::getInt1Ty(*Context);
+  if (RetTy->isVectorTy())
+    BoolTy = FixedVectorType::get(
+        BoolTy, cast<FixedVectorType>(RetTy)->getNumElements());
+  Instruction *Res = CastInst::CreateTruncOrBitCast(Call, BoolTy, "", BB);
+  setName(Res, I);
+  if (Res->hasName())
+    Call->setName(Res->getName());
+  return Res;
+}
+
+bool SPIRVToLLVM::isRenamedByBuiltinLowering(Op OC) const {
+  return BuiltinLowering && isSPIRVBuiltinRenamedToOCL(OC);
+}
+
+void SPIRVToLLVM::addBuiltinToLower(Function *F) {
+  if (!BuiltinLowering || BuiltinLowering->hasBuiltinDecl(F))
+    return;
+  StringRef DemangledName;
+  Op OC = OpNop;
+  const BuiltinFuncInfo &Info = getBuiltinFuncInfo(F);
+  if (Info.IsOCLBuiltin) {
+    DemangledName = Info.getDemangledName(F);
+    OC = Info.OC;
+  }
+  BuiltinLowering->addBuiltinDecl(F, OC, DemangledName);
 }
 
 std::unique_ptr<SPIRVModule> readSpirvModule(std::istream &IS,
@@ -4624,30 +4763,300 @@ std::unique_ptr<SPIRVModule> readSpirvModule(std::istream &IS,
 
 } // namespace SPIRV
 
-std::unique_ptr<Module>
-llvm::convertSpirvToLLVM(LLVMContext &C, SPIRVModule &BM,
-                         const SPIRV::TranslatorOpts &Opts,
-                         std::string &ErrMsg) {
+namespace {
+// Assigns the function definitions of a SPIR-V binary to shards which are
+// translated independently. Entry points and functions with Export linkage
+// are declared by the shards using them. Other functions, and global
+// variables with internal or LinkOnceODR linkage, must be defined next to
+// their users, so they are grouped with every function referencing them.
+// Operands are not decoded: an operand word equal to the id of such an
+// entity is taken for a reference, skipping the literals of the most common
+// instructions. A literal taken for a reference only makes a group larger.
+class SpirvShardPlanner {
+public:
+  /// \returns false if \p Binary is not a SPIR-V module.
+  bool scan(ArrayRef<SPIRVWord> Binary);
+
+  /// \returns true if the module imports a debug info instruction set.
+  bool hasDebugInfo() const { return !DebugInstSets.empty(); }
+
+  /// \returns for each of at most \p NumShards shards the ids of the
+  /// functions and variables defined by the other shards.
+  std::vector<std::unordered_set<SPIRVId>> plan(unsigned NumShards);
+
+private:
+  static const unsigned NoNode = ~0U;
+
+  // A function definition or a global variable.
+  struct Node {
+    SPIRVId Id;
+    // Whether the node must be defined in the shard of its users.
+    bool Grouped;
+    // Number of instructions in the function body.
+    size_t Weight;
+    unsigned Parent;
+    // Words of the function body or of the variable instruction.
+    size_t Begin;
+    size_t End;
+  };
+
+  unsigned find(unsigned N) {
+    while (Nodes[N].Parent != N)
+      N = Nodes[N].Parent = Nodes[Nodes[N].Parent].Parent;
+    return N;
+  }
+  void join(unsigned A, unsigned B) { Nodes[find(A)].Parent = find(B); }
+  // Operand words of instruction Inst which may be ids of global entities.
+  ArrayRef<SPIRVWord> getReferences(ArrayRef<SPIRVWord> Inst) const;
+  // Group node N with the entities referenced by the instructions in
+  // Words[Begin, End).
+  void addReferences(unsigned N, size_t Begin, size_t End);
+
+  ArrayRef<SPIRVWord> Words;
+  std::vector<Node> Nodes;
+  std::vector<unsigned> NodeOf;
+  std::unordered_set<SPIRVId> DebugInstSets;
+  // Grouped nodes referenced by a constant, for constants referencing any.
+  std::unordered_map<SPIRVId, std::vector<unsigned>> ConstantRefs;
+};
+
+const unsigned SpirvShardPlanner::NoNode;
+} // namespace
+
+bool SpirvShardPlanner::scan(ArrayRef<SPIRVWord> Binary) {
+  if (Binary.size() < 5 || Binary[0] != MagicNumber)
+    return false;
+  Words = Binary;
+  SPIRVId Bound = Words[3];
+  NodeOf.assign(Bound, NoNode);
+
+  // Entry points and decorations precede the global variables and functions.
+  std::unordered_map<SPIRVId, SPIRVWord> Linkage;
+  std::unordered_set<SPIRVId> EntryPoints;
+  auto GetLinkage = [&](SPIRVId Id) -> SPIRVLinkageTypeKind {
+    auto Loc = Linkage.find(Id);
+    return Loc == Linkage.end()
+               ? internal::LinkageTypeInternal
+               : static_cast<SPIRVLinkageTypeKind>(Loc->second);
+  };
+  std::vector<std::pair<SPIRVId, size_t>> Constants;
+  Node *Function = nullptr;
+  bool HasBody = false;
+  for (size_t I = 5, E = Words.size(); I != E;) {
+    SPIRVWord WordCount = Words[I] >> 16;
+    Op OpCode = static_cast<Op>(Words[I] & 0xFFFF);
+    if (WordCount == 0 || WordCount > E - I)
+      return false;
+    const SPIRVWord *Inst = &Words[I];
+    if (OpCode == OpExtInstImport && WordCount > 2) {
+      const char *Name = reinterpret_cast<const char *>(Inst + 2);
+      SPIRVExtInstSetKind Set;
+      if (SPIRVBuiltinSetNameMap::rfind(
+              std::string(Name, strnlen(Name, (WordCount - 2) * 4)), &Set) &&
+          (Set == SPIRVEIS_Debug || Set == SPIRVEIS_OpenCL_DebugInfo_100))
+        DebugInstSets.insert(Inst[1]);
+    } else if (OpCode == OpEntryPoint && WordCount > 2) {
+      EntryPoints.insert(Inst[2]);
+    } else if (OpCode == OpDecorate && WordCount > 3 &&
+               Inst[2] == DecorationLinkageAttributes) {
+      Linkage[Inst[1]] = Inst[WordCount - 1];
+    } else if (OpCode == OpFunction && WordCount > 2) {
+      bool Grouped = !EntryPoints.count(Inst[2]) &&
+                     GetLinkage(Inst[2]) != LinkageTypeExport;
+      Nodes.push_back({Inst[2], Grouped, 0, 0, I + WordCount, 0});
+      Function = &Nodes.back();
+      HasBody = false;
+    } else if (OpCode == OpFunctionEnd && Function) {
+      Function->End = I;
+      // Functions without a body are declarations in every shard.
+      if (!HasBody)
+        Nodes.pop_back();
+      Function = nullptr;
+    } else if (Function) {
+      HasBody |= OpCode == OpLabel;
+      ++Function->Weight;
+    } else if (OpCode == OpVariable && WordCount > 3) {
+      // Built-in inputs and imported variables may be repeated in every
+      // shard.
+      SPIRVLinkageTypeKind Kind = GetLinkage(Inst[2]);
+      if (Inst[3] != StorageClassInput && Kind != LinkageTypeImport)
+        Nodes.push_back({Inst[2], Kind != LinkageTypeExport, 0, 0, I,
+                         I + WordCount});
+    } else if (isConstantOpCode(OpCode) && WordCount > 2) {
+      Constants.push_back({Inst[2], I});
+    }
+    I += WordCount;
+  }
+  if (Function)
+    return false;
+
+  for (unsigned N = 0, E = Nodes.size(); N != E; ++N) {
+    Node &Entity = Nodes[N];
+    if (Entity.Id >= Bound)
+      return false;
+    Entity.Parent = N;
+    NodeOf[Entity.Id] = N;
+  }
+
+  // Constants only reference values defined before them, except for
+  // function pointers, whose functions are nodes already.
+  for (auto &C : Constants) {
+    std::vector<unsigned> Refs;
+    ArrayRef<SPIRVWord> Inst = Words.slice(C.second, Words[C.second] >> 16);
+    for (SPIRVWord W : getReferences(Inst)) {
+      if (W >= Bound)
+        continue;
+      if (NodeOf[W] != NoNode && Nodes[NodeOf[W]].Grouped)
+        Refs.push_back(NodeOf[W]);
+      auto Loc = ConstantRefs.find(W);
+      if (Loc != ConstantRefs.end())
+        Refs.insert(Refs.end(), Loc->second.begin(), Loc->second.end());
+    }
+    if (!Refs.empty())
+      ConstantRefs[C.first] = std::move(Refs);
+  }
+
+  for (unsigned N = 0, E = Nodes.size(); N != E; ++N)
+    addReferences(N, Nodes[N].Begin, Nodes[N].End);
+  return true;
+}
+
+ArrayRef<SPIRVWord>
+SpirvShardPlanner::getReferences(ArrayRef<SPIRVWord> Inst) const {
+  auto Operands = [&](size_t First, size_t Count = ~size_t(0)) {
+    return Inst.size() > First
+               ? Inst.slice(First, std::min(Count, Inst.size() - First))
+               : ArrayRef<SPIRVWord>();
+  };
+  Op OpCode = static_cast<Op>(Inst[0] & 0xFFFF);
+  switch (OpCode) {
+  case OpLine:
+  case OpLabel:
+  case OpBranch:
+  case OpBranchConditional:
+  case OpSwitch:
+  case OpSelectionMerge:
+  case OpLoopMerge:
+    return {};
+  case OpLoad:
+  case OpCompositeExtract:
+    return Operands(3, 1);
+  case OpCompositeInsert:
+  case OpVectorShuffle:
+    return Operands(3, 2);
+  case OpStore:
+  case OpCopyMemory:
+    return Operands(1, 2);
+  case OpCopyMemorySized:
+    return Operands(1, 3);
+  case OpExtInst:
+    return Operands(5);
+  case OpVariable:
+    return Operands(4);
+  case OpConstantComposite:
+  case OpSpecConstantComposite:
+  case OpConstFunctionPointerINTEL:
+    return Operands(3);
+  case OpSpecConstantOp:
+    return Operands(4);
+  default:
+    // Other constants only have literal operands.
+    return isConstantOpCode(OpCode) ? ArrayRef<SPIRVWord>() : Operands(1);
+  }
+}
+
+void SpirvShardPlanner::addReferences(unsigned N, size_t Begin, size_t End) {
+  for (size_t I = Begin; I < End; I += Words[I] >> 16) {
+    for (SPIRVWord W : getReferences(Words.slice(I, Words[I] >> 16))) {
+      if (W >= NodeOf.size())
+        continue;
+      unsigned Ref = NodeOf[W];
+      if (Ref != NoNode && Nodes[Ref].Grouped)
+        join(N, Ref);
+      auto Loc = ConstantRefs.find(W);
+      if (Loc != ConstantRefs.end())
+        for (unsigned ConstantRef : Loc->second)
+          join(N, ConstantRef);
+    }
+  }
+}
+
+std::vector<std::unordered_set<SPIRVId>>
+SpirvShardPlanner::plan(unsigned NumShards) {
+  // Collect the groups in the order of their first node.
+  std::vector<unsigned> GroupOf(Nodes.size());
+  std::vector<size_t> GroupWeight;
+  std::unordered_map<unsigned, unsigned> GroupOfRoot;
+  for (unsigned N = 0, E = Nodes.size(); N != E; ++N) {
+    auto Ins = GroupOfRoot.insert({find(N), GroupWeight.size()});
+    if (Ins.second)
+      GroupWeight.push_back(0);
+    GroupOf[N] = Ins.first->second;
+    GroupWeight[GroupOf[N]] += Nodes[N].Weight;
+  }
+
+  size_t Count = std::max<size_t>(
+      1, std::min<size_t>(std::max(NumShards, 1U), GroupWeight.size()));
+  std::vector<std::unordered_set<SPIRVId>> Shards(Count);
+  if (Count == 1)
+    return Shards;
+
+  // Assign the heaviest group first to the shard with the least weight.
+  std::vector<unsigned> Order(GroupWeight.size());
+  for (unsigned G = 0, E = Order.size(); G != E; ++G)
+    Order[G] = G;
+  std::stable_sort(Order.begin(), Order.end(), [&](unsigned A, unsigned B) {
+    return GroupWeight[A] > GroupWeight[B];
+  });
+  std::vector<std::pair<size_t, size_t>> Load(Count);
+  std::vector<size_t> ShardOf(GroupWeight.size());
+  for (unsigned G : Order) {
+    size_t S = std::min_element(Load.begin(), Load.end()) - Load.begin();
+    ShardOf[G] = S;
+    Load[S].first += GroupWeight[G];
+    ++Load[S].second;
+  }
+
+  for (unsigned N = 0, E = Nodes.size(); N != E; ++N)
+    for (size_t S = 0; S != Count; ++S)
+      if (S != ShardOf[GroupOf[N]])
+        Shards[S].insert(Nodes[N].Id);
+  return Shards;
+}
+
+// Translate BM to a new module in C. The functions and variables in
+// DefinedElsewhere, if it is given, are only declared. The result is verified
+// unless verification is disabled.
+static std::unique_ptr<Module>
+translateSpirvModule(LLVMContext &C, SPIRVModule &BM,
+                     const SPIRV::TranslatorOpts &Opts,
+                     const std::unordered_set<SPIRVId> *DefinedElsewhere,
+                     std::string &ErrMsg) {
+  ManagedVerificationScope Verification;
   std::unique_ptr<Module> M(new Module("", C));
   SPIRVToLLVM BTL(M.get(), &BM);
+  BTL.setDefinedElsewhere(DefinedElsewhere);
 
   if (!BTL.translate()) {
     BM.getError(ErrMsg);
     return nullptr;
   }
-
-  llvm::ModulePass *LoweringPass =
-      createSPIRVBIsLoweringPass(*M, Opts.getDesiredBIsRepresentation());
-  if (LoweringPass) {
-    // nullptr means no additional lowering is required
-    llvm::legacy::PassManager PassMgr;
-    PassMgr.add(LoweringPass);
-    PassMgr.run(*M);
+  if (Opts.getVerificationLevel() != VerificationLevel::None) {
+    TranslationPhaseTimer Timer("verify");
+    if (!verifyModuleAfter(*M, "SPIR-V to LLVM translation", ErrMsg))
+      return nullptr;
   }
 
   return M;
 }
 
+std::unique_ptr<Module>
+llvm::convertSpirvToLLVM(LLVMContext &C, SPIRVModule &BM,
+                         const SPIRV::TranslatorOpts &Opts,
+                         std::string &ErrMsg) {
+  return translateSpirvModule(C, BM, Opts, nullptr, ErrMsg);
+}
+
 std::unique_ptr<Module>
 llvm::convertSpirvToLLVM(LLVMContext &C, SPIRVModule &BM, std::string &ErrMsg) {
   SPIRV::TranslatorOpts DefaultOpts;
@@ -4665,6 +5074,41 @@ bool llvm::readSpirv(LLVMContext &C, std::istream &IS, Module *&M,
 
 bool llvm::readSpirv(LLVMContext &C, const SPIRV::TranslatorOpts &Opts,
                      std::istream &IS, Module *&M, std::string &ErrMsg) {
+  if (!Opts.getTranslationCacheDir().empty()) {
+    std::string Input{std::istreambuf_iterator<char>(IS),
+                      std::istreambuf_iterator<char>()};
+    TranslationCache Cache(Opts, /*Reverse=*/true);
+    uint64_t Key = Cache.getKey(Input);
+    std::string Bitcode;
+    if (Cache.lookup(Key, Bitcode)) {
+      // An empty identifier gives the module the id of a fresh translation.
+      Expected<std::unique_ptr<Module>> MOrErr =
+          parseBitcodeFile(MemoryBufferRef(Bitcode, ""), C);
+      if (MOrErr) {
+        if (Opts.getVerificationLevel() != VerificationLevel::None) {
+          TranslationPhaseTimer Timer("verify");
+          if (!verifyModuleAfter(**MOrErr, "SPIR-V to LLVM translation",
+                                 ErrMsg))
+            return false;
+        }
+        M = MOrErr->release();
+        return true;
+      }
+      // A damaged entry is replaced by translating again.
+      consumeError(MOrErr.takeError());
+    }
+    SPIRV::TranslatorOpts UncachedOpts(Opts);
+    UncachedOpts.setTranslationCacheDir("");
+    std::istringstream SS(Input);
+    if (!readSpirv(C, UncachedOpts, SS, M, ErrMsg))
+      return false;
+    SmallString<0> Result;
+    raw_svector_ostream ResultOS(Result);
+    WriteBitcodeToFile(*M, ResultOS);
+    Cache.store(Key, Result);
+    return true;
+  }
+
   std::unique_ptr<SPIRVModule> BM(readSpirvModule(IS, Opts, ErrMsg));
 
   if (!BM)
@@ -4675,9 +5119,84 @@ bool llvm::readSpirv(LLVMContext &C, const SPIRV::TranslatorOpts &Opts,
   if (!M)
     return false;
 
-  if (DbgSaveTmpLLVM)
-    dumpLLVM(M, DbgTmpLLVMFileName);
+  return true;
+}
+
+bool llvm::readSpirv(LLVMContext &C, const SPIRV::TranslatorOpts &Opts,
+                     std::istream &IS, Module *&M, std::string &ErrMsg,
+                     SPIRV::TranslationStats &Stats) {
+  std::string Input{std::istreambuf_iterator<char>(IS),
+                    std::istreambuf_iterator<char>()};
+  Stats.BytesIn += Input.size();
+  std::istringstream SS(Input);
+  TranslationStatsScope Scope(&Stats);
+  return readSpirv(C, Opts, SS, M, ErrMsg);
+}
 
+bool llvm::readSpirvShards(const SPIRV::TranslatorOpts &Opts,
+                           std::istream &IS, unsigned NumShards,
+                           std::vector<SpirvShard> &Shards,
+                           std::string &ErrMsg) {
+  std::string Input{std::istreambuf_iterator<char>(IS),
+                    std::istreambuf_iterator<char>()};
+  SPIRV::TranslatorOpts ShardOpts(Opts);
+  ShardOpts.setTranslationCacheDir("");
+  if (Opts.isSPIRVTextFormat()) {
+    // Shards are planned on the binary form of the module.
+    std::istringstream SS(Input);
+    std::unique_ptr<SPIRVModule> BM(readSpirvModule(SS, Opts, ErrMsg));
+    if (!BM)
+      return false;
+    BM->setTextFormat(false);
+    std::ostringstream OS;
+    OS << *BM;
+    Input = OS.str();
+    ShardOpts.setSPIRVTextFormat(false);
+  }
+
+  std::vector<std::unordered_set<SPIRVId>> Plan(1);
+  {
+    TranslationPhaseTimer Timer("plan-shards");
+    std::vector<SPIRVWord> Words(Input.size() / sizeof(SPIRVWord));
+    std::memcpy(Words.data(), Input.data(), Words.size() * sizeof(SPIRVWord));
+    SpirvShardPlanner Planner;
+    // A damaged module is translated as one shard to report the error.
+    if (Planner.scan(Words)) {
+      // Debug info of a function is not split from the debug info of the
+      // compile unit, so every shard would describe every function.
+      if (Planner.hasDebugInfo() && NumShards > 1) {
+        ErrMsg = "Modules with debug info cannot be translated to more than "
+                 "one shard";
+        return false;
+      }
+      Plan = Planner.plan(NumShards);
+    }
+  }
+
+  Shards.clear();
+  Shards.resize(Plan.size());
+  std::vector<std::string> Errors(Plan.size());
+  ThreadPool Pool(hardware_concurrency(Plan.size()));
+  for (size_t I = 0, E = Plan.size(); I != E; ++I)
+    Pool.async([&, I] {
+      SpirvShard &Shard = Shards[I];
+      Shard.Context = std::make_unique<LLVMContext>();
+      std::istringstream SS(Input);
+      std::unique_ptr<SPIRVModule> BM(
+          readSpirvModule(SS, ShardOpts, Errors[I]));
+      if (BM)
+        Shard.M = translateSpirvModule(*Shard.Context, *BM, ShardOpts,
+                                       Plan.size() > 1 ? &Plan[I] : nullptr,
+                                       Errors[I]);
+    });
+  Pool.wait();
+
+  for (size_t I = 0, E = Shards.size(); I != E; ++I)
+    if (!Shards[I].M) {
+      ErrMsg = Errors[I];
+      Shards.clear();
+      return false;
+    }
   return true;
 }
 
@@ -4727,6 +5246,272 @@ bool llvm::getSpecConstInfo(std::istream &IS,
   return !IS.fail();
 }
 
+bool llvm::getSpirvModuleInfo(std::istream &IS, SpirvModuleInfo &Info) {
+  Info = SpirvModuleInfo();
+  std::unique_ptr<SPIRVModule> BM(SPIRVModule::createSPIRVModule());
+  SPIRVDecoder D(IS, *BM);
+  SPIRVWord Magic;
+  D >> Magic;
+  if (!BM->getErrorLog().checkError(Magic == MagicNumber, SPIRVEC_InvalidModule,
+                                    "invalid magic number")) {
+    return false;
+  }
+  // Skip the rest of the header
+  D.ignore(4);
+
+  struct ArgTypeInfo {
+    Op OpCode;
+    SPIRVWord StorageClass;
+    SPIRVWord AccessQualifier;
+  };
+  // Kernels whose OpFunction hasn't been reached yet.
+  std::unordered_map<SPIRVId, size_t> KernelIdx;
+  std::unordered_map<SPIRVId, std::string> Names;
+  std::unordered_map<SPIRVId, std::vector<SPIRVWord>> ParamAttrs;
+  std::unordered_map<SPIRVId, ArgTypeInfo> Types;
+  std::vector<std::string> ArgTypeStrs;
+  SpirvKernelInfo *Kernel = nullptr;
+  const std::string ArgTypeStrPrefix =
+      std::string(SPIR_MD_KERNEL_ARG_TYPE) + ".";
+
+  // Set if an instruction is shorter than the operands read from it.
+  bool Malformed = false;
+  // Skip the operands of the current instruction that follow the first
+  // \p Read words.
+  auto SkipRest = [&](size_t Read) {
+    if (Read >= D.WordCount) {
+      Malformed = true;
+      return;
+    }
+    D.ignore(D.WordCount - 1 - Read);
+  };
+  // Minimum word count of the instructions whose operands are read below.
+  auto GetMinWordCount = [](Op OC) -> SPIRVWord {
+    switch (OC) {
+    case OpCapability:
+    case OpExtension:
+    case OpGroupDecorate:
+      return 2;
+    case OpEntryPoint:
+      return 4;
+    case OpExecutionMode:
+    case OpString:
+    case OpName:
+    case OpDecorate:
+    case OpTypePointer:
+    case OpTypePipe:
+    case OpFunction:
+    case OpFunctionParameter:
+      return 3;
+    default:
+      return isTypeOpCode(OC) ? 2 : 1;
+    }
+  };
+
+  while (!Malformed && D.getWordCountAndOpCode()) {
+    if (D.WordCount < GetMinWordCount(D.OpCode)) {
+      Malformed = true;
+      break;
+    }
+    // Everything needed has been read once the parameters of the last kernel
+    // are behind.
+    if (KernelIdx.empty() && !Kernel && !Info.Kernels.empty())
+      break;
+    if (D.OpCode != OpFunctionParameter)
+      Kernel = nullptr;
+    switch (D.OpCode) {
+    case OpCapability: {
+      SPIRVWord Cap;
+      D >> Cap;
+      Info.Capabilities.push_back(Cap);
+      SkipRest(1);
+      break;
+    }
+    case OpExtension: {
+      std::string Ext;
+      D >> Ext;
+      SkipRest(getSizeInWords(Ext));
+      Info.Extensions.push_back(Ext);
+      break;
+    }
+    case OpEntryPoint: {
+      SPIRVWord Model;
+      SPIRVId Id;
+      std::string Name;
+      D >> Model >> Id >> Name;
+      SkipRest(2 + getSizeInWords(Name));
+      if (Model != ExecutionModelKernel || KernelIdx.count(Id))
+        break;
+      KernelIdx[Id] = Info.Kernels.size();
+      Info.Kernels.emplace_back();
+      Info.Kernels.back().Name = Name;
+      break;
+    }
+    case OpExecutionMode: {
+      SPIRVId Id;
+      SPIRVWord Mode;
+      D >> Id >> Mode;
+      std::vector<SPIRVWord> Literals(D.WordCount - 3);
+      for (auto &L : Literals)
+        D >> L;
+      SkipRest(D.WordCount - 1);
+      auto Loc = KernelIdx.find(Id);
+      if (Loc == KernelIdx.end())
+        break;
+      SpirvKernelInfo &KI = Info.Kernels[Loc->second];
+      if (Mode == ExecutionModeLocalSize && Literals.size() == 3)
+        std::copy(Literals.begin(), Literals.end(), KI.ReqdWorkGroupSize);
+      else if (Mode == ExecutionModeSubgroupSize && Literals.size() == 1)
+        KI.SubgroupSize = Literals[0];
+      KI.ExecutionModes[Mode] = std::move(Literals);
+      break;
+    }
+    case OpString: {
+      SPIRVId Id;
+      std::string Str;
+      D >> Id >> Str;
+      SkipRest(1 + getSizeInWords(Str));
+      if (Str.find(ArgTypeStrPrefix) == 0)
+        ArgTypeStrs.push_back(Str.substr(ArgTypeStrPrefix.size()));
+      break;
+    }
+    case OpName: {
+      SPIRVId Id;
+      std::string Name;
+      D >> Id >> Name;
+      SkipRest(1 + getSizeInWords(Name));
+      Names[Id] = std::move(Name);
+      break;
+    }
+    case OpDecorate: {
+      SPIRVId Target;
+      SPIRVWord Dec;
+      D >> Target >> Dec;
+      if (Dec == DecorationFuncParamAttr && D.WordCount == 4) {
+        SPIRVWord Attr;
+        D >> Attr;
+        ParamAttrs[Target].push_back(Attr);
+        SkipRest(3);
+      } else {
+        SkipRest(2);
+      }
+      break;
+    }
+    case OpGroupDecorate: {
+      SPIRVId Group;
+      D >> Group;
+      std::vector<SPIRVId> Targets(D.WordCount - 2);
+      for (auto &T : Targets)
+        D >> T;
+      SkipRest(D.WordCount - 1);
+      auto Loc = ParamAttrs.find(Group);
+      if (Loc == ParamAttrs.end())
+        break;
+      const std::vector<SPIRVWord> Attrs = Loc->second;
+      for (auto T : Targets)
+        ParamAttrs[T].insert(ParamAttrs[T].end(), Attrs.begin(), Attrs.end());
+      break;
+    }
+    case OpTypePointer:
+    case OpTypeImage:
+    case OpTypePipe: {
+      SPIRVId Id;
+      SPIRVWord Word;
+      D >> Id;
+      ArgTypeInfo TI = {D.OpCode, ~0U, ~0U};
+      size_t Read = 1;
+      // OpTypePointer <id> <storage class> <pointee>
+      // OpTypePipe <id> <access qualifier>
+      // OpTypeImage <id> ... <access qualifier> with the qualifier optional
+      if (D.OpCode == OpTypePointer || D.OpCode == OpTypePipe) {
+        D >> Word;
+        ++Read;
+        (D.OpCode == OpTypePointer ? TI.StorageClass : TI.AccessQualifier) =
+            Word;
+      } else if (D.WordCount == 10) {
+        for (; Read != 9; ++Read)
+          D >> Word;
+        TI.AccessQualifier = Word;
+      }
+      SkipRest(Read);
+      Types[Id] = TI;
+      break;
+    }
+    case OpFunction: {
+      SPIRVId ResultTy, Id;
+      D >> ResultTy >> Id;
+      SkipRest(2);
+      auto Loc = KernelIdx.find(Id);
+      if (Loc != KernelIdx.end()) {
+        Kernel = &Info.Kernels[Loc->second];
+        KernelIdx.erase(Loc);
+      }
+      break;
+    }
+    case OpFunctionParameter: {
+      if (!Kernel) {
+        D.ignoreInstruction();
+        break;
+      }
+      SPIRVId Ty, Id;
+      D >> Ty >> Id;
+      SkipRest(2);
+      SpirvKernelArgInfo Arg;
+      auto Name = Names.find(Id);
+      if (Name != Names.end())
+        Arg.Name = Name->second;
+      auto TI = Types.find(Ty);
+      if (TI != Types.end()) {
+        Arg.TypeOpCode = TI->second.OpCode;
+        Arg.StorageClass = TI->second.StorageClass;
+        Arg.AccessQualifier = TI->second.AccessQualifier;
+      }
+      auto Attrs = ParamAttrs.find(Id);
+      if (Attrs != ParamAttrs.end())
+        Arg.Attributes = Attrs->second;
+      Kernel->Args.push_back(std::move(Arg));
+      break;
+    }
+    default:
+      if (isTypeOpCode(D.OpCode)) {
+        SPIRVId Id;
+        D >> Id;
+        SkipRest(1);
+        Types[Id] = {D.OpCode, ~0U, ~0U};
+        break;
+      }
+      D.ignoreInstruction();
+    }
+  }
+  if (!BM->getErrorLog().checkError(!Malformed, SPIRVEC_InvalidModule,
+                                    "malformed instruction"))
+    return false;
+
+  // kernel_arg_type.<kernel name>.<type>,<type>,...
+  for (auto &KI : Info.Kernels) {
+    std::string Prefix = KI.Name + ".";
+    auto Str = std::find_if(
+        ArgTypeStrs.begin(), ArgTypeStrs.end(),
+        [&](const std::string &S) { return S.find(Prefix) == 0; });
+    if (Str == ArgTypeStrs.end())
+      continue;
+    StringRef TypeStr = StringRef(*Str).drop_front(Prefix.size());
+    int CountBraces = 0;
+    size_t Start = 0, ArgNo = 0;
+    for (size_t I = 0; I < TypeStr.size() && ArgNo < KI.Args.size(); ++I) {
+      if (TypeStr[I] == '<')
+        ++CountBraces;
+      else if (TypeStr[I] == '>')
+        --CountBraces;
+      else if (TypeStr[I] == ',' && CountBraces == 0) {
+        KI.Args[ArgNo++].TypeName = TypeStr.slice(Start, I).str();
+        Start = I + 1;
+      }
+    }
+  }
+  return KernelIdx.empty() && !IS.bad();
+}
+
 // clang-format off
 const StringSet<> SPIRVToLLVM::BuiltInConstFunc {
   "convert", "get_work_dim", "get_global_size", "sub_group_ballot_bit_count",
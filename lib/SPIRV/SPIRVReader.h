@@ -43,10 +43,13 @@
 
 #include "SPIRVModule.h"
 
+#include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/StringSet.h"
 #include "llvm/IR/GlobalValue.h" // llvm::GlobalValue::LinkageTypes
 
+#include <unordered_set>
+
 namespace llvm {
 class Metadata;
 class Module;
@@ -73,6 +76,7 @@ class SPIRVConstantSampler;
 class SPIRVConstantPipeStorage;
 class SPIRVLoopMerge;
 class SPIRVToLLVMDbgTran;
+class SPIRVToOCLBase;
 class SPIRVToLLVM {
 public:
   SPIRVToLLVM(Module *LLVMModule, SPIRVModule *TheSPIRVModule);
@@ -88,6 +92,14 @@ public:
   bool translate();
   bool transAddressingModel();
 
+  /// Translate the functions and variables with ids in \p Ids, which are
+  /// defined by another shard of the module, as declarations where they are
+  /// referenced. See readSpirvShards.
+  void setDefinedElsewhere(const std::unordered_set<SPIRVId> *Ids) {
+    DefinedElsewhere = Ids;
+  }
+  bool isDefinedElsewhere(const SPIRVValue *V) const;
+
   Value *transValue(SPIRVValue *, Function *F, BasicBlock *,
                     bool CreatePlaceHolder = true);
   Value *transValueWithoutDecoration(SPIRVValue *, Function *F, BasicBlock *,
@@ -198,7 +210,11 @@ private:
   SPIRVBlockToLLVMStructMap BlockMap;
   SPIRVToLLVMPlaceholderMap PlaceholderMap;
   std::unique_ptr<SPIRVToLLVMDbgTran> DbgTran;
+  // Lowers the SPIR-V builtin calls of each translated function to the
+  // desired representation. Null for SPIR-V friendly IR.
+  std::unique_ptr<SPIRVToOCLBase> BuiltinLowering;
   std::vector<Constant *> GlobalAnnotations;
+  const std::unordered_set<SPIRVId> *DefinedElsewhere = nullptr;
 
   // Loops metadata is translated in the end of a function translation.
   // This storage contains pairs of translated loop header basic block and loop
@@ -276,6 +292,17 @@ private:
   llvm::GlobalValue::LinkageTypes transLinkageType(const SPIRVValue *V);
   Instruction *transOCLAllAny(SPIRVInstruction *BI, BasicBlock *BB);
   Instruction *transOCLRelational(SPIRVInstruction *BI, BasicBlock *BB);
+  // Create the call of the relational builtin for \p BI, whose arguments and
+  // result are integers, and convert the result to bool.
+  Instruction *transOCLRelationalCall(SPIRVInstruction *BI,
+                                      ArrayRef<Value *> Args, Type *RetTy,
+                                      BasicBlock *BB);
+  // Whether calls of SPIR-V builtin \p OC are created with their OpenCL name
+  // because the desired representation only renames them.
+  bool isRenamedByBuiltinLowering(Op OC) const;
+  // Tell BuiltinLowering which builtin \p F declares, so that it visits calls
+  // of \p F without demangling it.
+  void addBuiltinToLower(Function *F);
 
   void transUserSemantic(SPIRV::SPIRVFunction *Fun);
   void transGlobalAnnotations();
@@ -0,0 +1,86 @@
+//===- SPIRVSession.cpp - Reusable translation session ----------*- C++ -*-===//
+//
+//                     The LLVM/SPIR-V Translator
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+// Copyright (c) 2021 Intel Corporation. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal with the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimers.
+// Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimers in the documentation
+// and/or other materials provided with the distribution.
+// Neither the names of Advanced Micro Devices, Inc., nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// Software without specific prior written permission.
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH
+// THE SOFTWARE.
+//
+/// \file
+///
+/// This file implements TranslatorSession, which keeps name based caches warm
+/// between translations.
+///
+//===----------------------------------------------------------------------===//
+
+#include "LLVMSPIRVLib.h"
+#include "SPIRVInternal.h"
+
+using namespace SPIRV;
+
+namespace SPIRV {
+
+class TranslatorSessionImpl {
+public:
+  BuiltinNameCache NameCache;
+  std::atomic<uint64_t> Translations{0};
+};
+
+} // namespace SPIRV
+
+TranslatorSession::TranslatorSession(const TranslatorOpts &Opts)
+    : Opts(Opts), Impl(new TranslatorSessionImpl()) {}
+
+TranslatorSession::~TranslatorSession() = default;
+
+bool TranslatorSession::writeSpirv(llvm::Module *M, std::ostream &OS,
+                                   std::string &ErrMsg) {
+  BuiltinNameCacheScope Scope(&Impl->NameCache);
+  ++Impl->Translations;
+  return llvm::writeSpirv(M, Opts, OS, ErrMsg);
+}
+
+bool TranslatorSession::readSpirv(llvm::LLVMContext &C, std::istream &IS,
+                                  llvm::Module *&M, std::string &ErrMsg) {
+  BuiltinNameCacheScope Scope(&Impl->NameCache);
+  ++Impl->Translations;
+  return llvm::readSpirv(C, Opts, IS, M, ErrMsg);
+}
+
+TranslatorSessionStats TranslatorSession::getStats() const {
+  TranslatorSessionStats Stats;
+  Stats.Translations = Impl->Translations;
+  Stats.BuiltinNameHits = Impl->NameCache.getNumHits();
+  Stats.BuiltinNameMisses = Impl->NameCache.getNumMisses();
+  Stats.BuiltinNamesCached = Impl->NameCache.size();
+  return Stats;
+}
+
+void TranslatorSession::resetStats() {
+  Impl->Translations = 0;
+  Impl->NameCache.resetStats();
+}
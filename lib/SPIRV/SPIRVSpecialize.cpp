@@ -0,0 +1,414 @@
+//===- SPIRVSpecialize.cpp - Binary spec constant patching ------*- C++ -*-===//
+//
+//                     The LLVM/SPIR-V Translator
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+// Copyright (c) 2021 Intel Corporation. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal with the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimers.
+// Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimers in the documentation
+// and/or other materials provided with the distribution.
+// Neither the names of Advanced Micro Devices, Inc., nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// Software without specific prior written permission.
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH
+// THE SOFTWARE.
+//
+/// \file
+///
+/// This file implements specializeSpirv, which applies specialization
+/// constant values to a SPIR-V binary by patching its word stream, without
+/// building a SPIRVModule or an LLVM module.
+///
+//===----------------------------------------------------------------------===//
+
+#include "LLVMSPIRVLib.h"
+#include "SPIRVInternal.h"
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/Support/MathExtras.h"
+
+using namespace SPIRV;
+using namespace llvm;
+
+namespace {
+
+// Value of an integer or boolean scalar constant, zero-extended from its bit
+// width. Booleans have a width of 1.
+struct ScalarValue {
+  uint64_t Bits;
+  unsigned Width;
+};
+
+class SpecConstPatcher {
+public:
+  SpecConstPatcher(const std::map<uint32_t, uint64_t> &SpecConsts,
+                   SmallVectorImpl<uint32_t> &Out)
+      : SpecConsts(SpecConsts), Out(Out) {}
+
+  bool run(ArrayRef<uint32_t> In);
+
+private:
+  const std::map<uint32_t, uint64_t> &SpecConsts;
+  SmallVectorImpl<uint32_t> &Out;
+  // SpecId of each decorated result id.
+  DenseMap<SPIRVId, SPIRVWord> SpecIds;
+  // Bit width of integer and boolean types.
+  DenseMap<SPIRVId, unsigned> ScalarTypeWidths;
+  // Integer and boolean constants whose value is known.
+  DenseMap<SPIRVId, ScalarValue> Values;
+  // Results that remain specialization constants in the output.
+  DenseSet<SPIRVId> Unfolded;
+
+  bool getSpecValue(SPIRVId Id, uint64_t &Value) const;
+  void emit(Op OC, ArrayRef<uint32_t> Operands);
+  void emitScalar(SPIRVId Type, SPIRVId Id, ScalarValue V);
+  bool fold(SPIRVId Type, Op OC, ArrayRef<uint32_t> Operands,
+            ScalarValue &Result) const;
+  size_t patchComposite(ArrayRef<uint32_t> In, size_t Pos);
+};
+
+// Look up the externally provided value of the specialization constant \p Id.
+bool SpecConstPatcher::getSpecValue(SPIRVId Id, uint64_t &Value) const {
+  auto SpecId = SpecIds.find(Id);
+  if (SpecId == SpecIds.end())
+    return false;
+  auto It = SpecConsts.find(SpecId->second);
+  if (It == SpecConsts.end())
+    return false;
+  Value = It->second;
+  return true;
+}
+
+void SpecConstPatcher::emit(Op OC, ArrayRef<uint32_t> Operands) {
+  Out.push_back(((Operands.size() + 1) << WordCountShift) | OC);
+  Out.append(Operands.begin(), Operands.end());
+}
+
+void SpecConstPatcher::emitScalar(SPIRVId Type, SPIRVId Id, ScalarValue V) {
+  if (V.Width == 1) {
+    emit(V.Bits ? OpConstantTrue : OpConstantFalse, {Type, Id});
+    return;
+  }
+  uint32_t Words[] = {Type, Id, static_cast<uint32_t>(V.Bits),
+                      static_cast<uint32_t>(V.Bits >> 32)};
+  emit(OpConstant, makeArrayRef(Words, V.Width > 32 ? 4 : 3));
+}
+
+// Evaluate an OpSpecConstantOp over integer and boolean scalars. Returns false
+// for any operation, operand or result that can't be folded here, including
+// operations whose result is undefined (division by zero, oversized shifts).
+bool SpecConstPatcher::fold(SPIRVId Type, Op OC, ArrayRef<uint32_t> Operands,
+                            ScalarValue &Result) const {
+  auto TypeWidth = ScalarTypeWidths.find(Type);
+  if (TypeWidth == ScalarTypeWidths.end() || TypeWidth->second > 64)
+    return false;
+  SmallVector<ScalarValue, 3> Ops;
+  for (SPIRVId Id : Operands) {
+    auto It = Values.find(Id);
+    if (It == Values.end())
+      return false;
+    Ops.push_back(It->second);
+  }
+  const unsigned Width = TypeWidth->second;
+  auto SExt = [](const ScalarValue &V) {
+    return V.Width >= 64 ? static_cast<int64_t>(V.Bits)
+                         : SignExtend64(V.Bits, V.Width);
+  };
+  auto NumOps = Ops.size();
+  uint64_t R = 0;
+  switch (OC) {
+  case OpSConvert:
+    if (NumOps != 1)
+      return false;
+    R = SExt(Ops[0]);
+    break;
+  case OpUConvert:
+  case OpLogicalNot:
+  case OpNot:
+    if (NumOps != 1)
+      return false;
+    R = OC == OpUConvert ? Ops[0].Bits : ~Ops[0].Bits;
+    break;
+  case OpSNegate:
+    if (NumOps != 1)
+      return false;
+    R = -Ops[0].Bits;
+    break;
+  case OpSelect:
+    if (NumOps != 3)
+      return false;
+    R = Ops[0].Bits ? Ops[1].Bits : Ops[2].Bits;
+    break;
+  default: {
+    if (NumOps != 2)
+      return false;
+    uint64_t A = Ops[0].Bits, B = Ops[1].Bits;
+    int64_t SA = SExt(Ops[0]), SB = SExt(Ops[1]);
+    unsigned OpWidth = Ops[0].Width;
+    switch (OC) {
+    case OpIAdd:
+      R = A + B;
+      break;
+    case OpISub:
+      R = A - B;
+      break;
+    case OpIMul:
+      R = A * B;
+      break;
+    case OpUDiv:
+    case OpUMod:
+      if (B == 0)
+        return false;
+      R = OC == OpUDiv ? A / B : A % B;
+      break;
+    case OpSDiv:
+    case OpSRem:
+    case OpSMod:
+      if (SB == 0 || (SB == -1 && SA == std::numeric_limits<int64_t>::min()))
+        return false;
+      if (OC == OpSDiv)
+        R = SA / SB;
+      else if (OC == OpSRem)
+        R = SA % SB;
+      else
+        R = SA % SB != 0 && ((SA < 0) != (SB < 0)) ? SA % SB + SB : SA % SB;
+      break;
+    case OpShiftLeftLogical:
+    case OpShiftRightLogical:
+    case OpShiftRightArithmetic:
+      if (B >= OpWidth)
+        return false;
+      if (OC == OpShiftLeftLogical)
+        R = A << B;
+      else if (OC == OpShiftRightLogical)
+        R = A >> B;
+      else
+        R = SA >> B;
+      break;
+    case OpBitwiseOr:
+    case OpLogicalOr:
+      R = A | B;
+      break;
+    case OpBitwiseXor:
+      R = A ^ B;
+      break;
+    case OpBitwiseAnd:
+    case OpLogicalAnd:
+      R = A & B;
+      break;
+    case OpIEqual:
+    case OpLogicalEqual:
+      R = A == B;
+      break;
+    case OpINotEqual:
+    case OpLogicalNotEqual:
+      R = A != B;
+      break;
+    case OpUGreaterThan:
+      R = A > B;
+      break;
+    case OpSGreaterThan:
+      R = SA > SB;
+      break;
+    case OpUGreaterThanEqual:
+      R = A >= B;
+      break;
+    case OpSGreaterThanEqual:
+      R = SA >= SB;
+      break;
+    case OpULessThan:
+      R = A < B;
+      break;
+    case OpSLessThan:
+      R = SA < SB;
+      break;
+    case OpULessThanEqual:
+      R = A <= B;
+      break;
+    case OpSLessThanEqual:
+      R = SA <= SB;
+      break;
+    default:
+      return false;
+    }
+  }
+  }
+  Result.Width = Width;
+  Result.Bits = R & maskTrailingOnes<uint64_t>(Width);
+  return true;
+}
+
+// Patch an OpSpecConstantComposite at \p Pos together with the
+// OpSpecConstantCompositeContinuedINTEL instructions that follow it. They
+// become OpConstantComposite* only if none of their constituents remains a
+// specialization constant. Returns the position after the last instruction.
+size_t SpecConstPatcher::patchComposite(ArrayRef<uint32_t> In, size_t Pos) {
+  const size_t Begin = Pos;
+  const SPIRVId Id = In[Pos + 2];
+  bool IsConstant = true;
+  for (bool Head = true; Pos < In.size(); Head = false) {
+    SPIRVWord WordCount = In[Pos] >> WordCountShift;
+    Op OC = static_cast<Op>(In[Pos] & OpCodeMask);
+    if (!Head && OC != OpSpecConstantCompositeContinuedINTEL)
+      break;
+    if (WordCount == 0 || Pos + WordCount > In.size())
+      return 0;
+    for (size_t I = Pos + (Head ? 3 : 1); I != Pos + WordCount; ++I)
+      IsConstant &= !Unfolded.count(In[I]);
+    Pos += WordCount;
+  }
+  for (size_t I = Begin; I != Pos; I += In[I] >> WordCountShift) {
+    Op OC = static_cast<Op>(In[I] & OpCodeMask);
+    if (IsConstant)
+      OC = OC == OpSpecConstantComposite ? OpConstantComposite
+                                         : OpConstantCompositeContinuedINTEL;
+    Out.push_back((In[I] & ~OpCodeMask) | OC);
+    Out.append(In.begin() + I + 1, In.begin() + I + (In[I] >> WordCountShift));
+  }
+  if (!IsConstant)
+    Unfolded.insert(Id);
+  return Pos;
+}
+
+bool SpecConstPatcher::run(ArrayRef<uint32_t> In) {
+  const size_t HeaderSize = 5;
+  if (In.size() < HeaderSize || In[0] != MagicNumber)
+    return false;
+  Out.clear();
+  Out.reserve(In.size());
+  Out.append(In.begin(), In.begin() + HeaderSize);
+
+  size_t Pos = HeaderSize;
+  while (Pos < In.size()) {
+    SPIRVWord WordCount = In[Pos] >> WordCountShift;
+    Op OC = static_cast<Op>(In[Pos] & OpCodeMask);
+    if (WordCount == 0 || Pos + WordCount > In.size())
+      return false;
+    ArrayRef<uint32_t> Inst = In.slice(Pos, WordCount);
+    // According to the logical layout of SPIRV module (p2.4 of the spec),
+    // all constant instructions must appear before function declarations.
+    if (OC == OpFunction)
+      break;
+    switch (OC) {
+    case OpDecorate:
+      // SpecId is only valid on specialization constants, which are all
+      // rewritten below.
+      if (WordCount == 4 && Inst[2] == DecorationSpecId) {
+        SpecIds[Inst[1]] = Inst[3];
+        Pos += WordCount;
+        continue;
+      }
+      break;
+    case OpTypeBool:
+      if (WordCount == 2)
+        ScalarTypeWidths[Inst[1]] = 1;
+      break;
+    case OpTypeInt:
+      if (WordCount == 4)
+        ScalarTypeWidths[Inst[1]] = Inst[2];
+      break;
+    case OpConstant: {
+      auto Width = ScalarTypeWidths.find(Inst[1]);
+      if (WordCount >= 4 && Width != ScalarTypeWidths.end() &&
+          Width->second <= 64) {
+        uint64_t Bits = Inst[3];
+        if (WordCount > 4)
+          Bits |= static_cast<uint64_t>(Inst[4]) << 32;
+        Values[Inst[2]] = {Bits, Width->second};
+      }
+      break;
+    }
+    case OpConstantTrue:
+    case OpConstantFalse:
+      if (WordCount == 3)
+        Values[Inst[2]] = {OC == OpConstantTrue, 1};
+      break;
+    case OpSpecConstantTrue:
+    case OpSpecConstantFalse: {
+      if (WordCount != 3)
+        return false;
+      uint64_t Value = OC == OpSpecConstantTrue;
+      getSpecValue(Inst[2], Value);
+      ScalarValue V = {Value != 0, 1};
+      Values[Inst[2]] = V;
+      emitScalar(Inst[1], Inst[2], V);
+      Pos += WordCount;
+      continue;
+    }
+    case OpSpecConstant: {
+      if (WordCount < 4)
+        return false;
+      uint64_t Value = Inst[3];
+      if (WordCount > 4)
+        Value |= static_cast<uint64_t>(Inst[4]) << 32;
+      bool IsProvided = getSpecValue(Inst[2], Value);
+      // Literal words beyond the first 64 bits are kept when no value is
+      // provided and cleared otherwise.
+      Out.push_back((In[Pos] & ~OpCodeMask) | OpConstant);
+      Out.append({Inst[1], Inst[2], static_cast<uint32_t>(Value)});
+      if (WordCount > 4)
+        Out.push_back(static_cast<uint32_t>(Value >> 32));
+      for (size_t I = 5; I < WordCount; ++I)
+        Out.push_back(IsProvided ? 0 : Inst[I]);
+      auto Width = ScalarTypeWidths.find(Inst[1]);
+      if (Width != ScalarTypeWidths.end() && Width->second <= 64)
+        Values[Inst[2]] = {Value & maskTrailingOnes<uint64_t>(Width->second),
+                           Width->second};
+      Pos += WordCount;
+      continue;
+    }
+    case OpSpecConstantComposite:
+      if (WordCount < 3)
+        return false;
+      Pos = patchComposite(In, Pos);
+      if (!Pos)
+        return false;
+      continue;
+    case OpSpecConstantOp: {
+      if (WordCount < 4)
+        return false;
+      ScalarValue V;
+      if (fold(Inst[1], static_cast<Op>(Inst[3]), Inst.drop_front(4), V)) {
+        Values[Inst[2]] = V;
+        emitScalar(Inst[1], Inst[2], V);
+        Pos += WordCount;
+        continue;
+      }
+      Unfolded.insert(Inst[2]);
+      break;
+    }
+    default:
+      break;
+    }
+    Out.append(Inst.begin(), Inst.end());
+    Pos += WordCount;
+  }
+  Out.append(In.begin() + Pos, In.end());
+  return true;
+}
+
+} // namespace
+
+bool llvm::specializeSpirv(ArrayRef<uint32_t> In,
+                           const std::map<uint32_t, uint64_t> &SpecConsts,
+                           SmallVectorImpl<uint32_t> &Out) {
+  return SpecConstPatcher(SpecConsts, Out).run(In);
+}
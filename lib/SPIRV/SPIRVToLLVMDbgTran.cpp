@@ -516,7 +516,8 @@ DINode *SPIRVToLLVMDbgTran::transFunction(const SPIRVExtInst *DebugInst) {
 
   // Function.
   SPIRVEntry *E = BM->getEntry(Ops[FunctionIdIdx]);
-  if (E->getOpCode() == OpFunction) {
+  if (E->getOpCode() == OpFunction &&
+      !SPIRVReader->isDefinedElsewhere(static_cast<SPIRVFunction *>(E))) {
     SPIRVFunction *BF = static_cast<SPIRVFunction *>(E);
     llvm::Function *F = SPIRVReader->transFunction(BF);
     assert(F && "Translation of function failed!");
@@ -627,6 +628,8 @@ MDNode *SPIRVToLLVMDbgTran::transGlobalVariable(const SPIRVExtInst *DebugInst) {
   // static const).
   if (VarDecl && !getDbgInst<SPIRVDebug::DebugInfoNone>(Ops[VariableIdx])) {
     SPIRVValue *V = BM->get<SPIRVValue>(Ops[VariableIdx]);
+    if (SPIRVReader->isDefinedElsewhere(V))
+      return VarDecl;
     Value *Var = SPIRVReader->transValue(V, nullptr, nullptr);
     llvm::GlobalVariable *GV = dyn_cast_or_null<llvm::GlobalVariable>(Var);
     if (GV && !GV->hasMetadata())
@@ -958,24 +961,35 @@ SPIRVToLLVMDbgTran::transDebugIntrinsic(const SPIRVExtInst *DebugInst,
 }
 
 DebugLoc SPIRVToLLVMDbgTran::transDebugScope(const SPIRVInstruction *Inst) {
+  SPIRVEntry *S = Inst->getDebugScope();
+  if (!S)
+    return DebugLoc();
+  // Instructions following the same OpLine share its SPIRVLine, so the pair
+  // identifies the resulting location.
+  std::shared_ptr<const SPIRVLine> L = Inst->getLine();
+  auto Key = std::make_pair(L.get(), static_cast<const SPIRVEntry *>(S));
+  auto It = DebugLocCache.find(Key);
+  if (It != DebugLocCache.end())
+    return It->second;
+
   unsigned Line = 0;
   unsigned Col = 0;
   MDNode *Scope = nullptr;
   MDNode *InlinedAt = nullptr;
-  if (auto L = Inst->getLine()) {
+  if (L) {
     Line = L->getLine();
     Col = L->getColumn();
   }
-  if (SPIRVEntry *S = Inst->getDebugScope()) {
-    using namespace SPIRVDebug::Operand::Scope;
-    SPIRVExtInst *DbgScope = static_cast<SPIRVExtInst *>(S);
-    SPIRVWordVec Ops = DbgScope->getArguments();
-    Scope = getScope(BM->getEntry(Ops[ScopeIdx]));
-    if (Ops.size() > InlinedAtIdx)
-      InlinedAt = transDebugInst(BM->get<SPIRVExtInst>(Ops[InlinedAtIdx]));
-    return DILocation::get(M->getContext(), Line, Col, Scope, InlinedAt);
-  }
-  return DebugLoc();
+  using namespace SPIRVDebug::Operand::Scope;
+  SPIRVExtInst *DbgScope = static_cast<SPIRVExtInst *>(S);
+  SPIRVWordVec Ops = DbgScope->getArguments();
+  Scope = getScope(BM->getEntry(Ops[ScopeIdx]));
+  if (Ops.size() > InlinedAtIdx)
+    InlinedAt = transDebugInst(BM->get<SPIRVExtInst>(Ops[InlinedAtIdx]));
+  DILocation *Loc =
+      DILocation::get(M->getContext(), Line, Col, Scope, InlinedAt);
+  DebugLocCache[Key] = Loc;
+  return Loc;
 }
 
 MDNode *SPIRVToLLVMDbgTran::transDebugInlined(const SPIRVExtInst *Inst) {
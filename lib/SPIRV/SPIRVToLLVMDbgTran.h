@@ -41,6 +41,7 @@
 
 #include "SPIRVInstruction.h"
 
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/IR/DIBuilder.h"
 #include "llvm/IR/DebugLoc.h"
 
@@ -154,6 +155,9 @@ private:
   std::unordered_map<std::string, DIFile *> FileMap;
   std::unordered_map<SPIRVId, DISubprogram *> FuncMap;
   std::unordered_map<const SPIRVExtInst *, MDNode *> DebugInstCache;
+  // Locations by OpLine and DebugScope of the instruction.
+  DenseMap<std::pair<const SPIRVLine *, const SPIRVEntry *>, DILocation *>
+      DebugLocCache;
 
   struct SplitFileName {
     SplitFileName(const std::string &FileName);
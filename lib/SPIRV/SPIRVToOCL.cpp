@@ -53,60 +53,79 @@ void SPIRVToOCLBase::visitCallInst(CallInst &CI) {
   if (!F)
     return;
 
-  auto MangledName = F->getName();
-  StringRef DemangledName;
-  Op OC = OpNop;
-  if (!oclIsBuiltin(MangledName, DemangledName) ||
-      (OC = getSPIRVFuncOC(DemangledName)) == OpNop)
+  auto Decl = BuiltinDecls.find(F);
+  if (Decl != BuiltinDecls.end()) {
+    if (Decl->second.first != OpNop)
+      visitCallSPIRVBuiltinOp(&CI, Decl->second.first, Decl->second.second);
     return;
+  }
+
+  const BuiltinFuncInfo &Info = getBuiltinFuncInfo(F);
+  if (!Info.IsOCLBuiltin || Info.OC == OpNop)
+    return;
+  visitCallSPIRVBuiltinOp(&CI, Info.OC, Info.getDemangledName(F));
+}
+
+bool isSPIRVBuiltinRenamedToOCL(Op OC) {
+  return OC != OpImageQuerySize && OC != OpImageQuerySizeLod &&
+         OC != OpMemoryBarrier && OC != OpControlBarrier &&
+         !isAtomicOpCode(OC) && !isGroupOpCode(OC) &&
+         !isGroupNonUniformOpcode(OC) && !isPipeOpCode(OC) &&
+         !isMediaBlockINTELOpcode(OC) && !isCvtOpCode(OC) &&
+         OC != OpGroupAsyncCopy && OC != OpGroupWaitEvents &&
+         OC != OpImageSampleExplicitLod && OCLSPIRVBuiltinMap::rfind(OC);
+}
+
+void SPIRVToOCLBase::visitCallSPIRVBuiltinOp(CallInst *CI, Op OC,
+                                             StringRef DemangledName) {
   LLVM_DEBUG(dbgs() << "DemangledName = " << DemangledName.str() << '\n'
                     << "OpCode = " << OC << '\n');
 
   if (OC == OpImageQuerySize || OC == OpImageQuerySizeLod) {
-    visitCallSPRIVImageQuerySize(&CI);
+    visitCallSPRIVImageQuerySize(CI);
     return;
   }
   if (OC == OpMemoryBarrier) {
-    visitCallSPIRVMemoryBarrier(&CI);
+    visitCallSPIRVMemoryBarrier(CI);
     return;
   }
   if (OC == OpControlBarrier) {
-    visitCallSPIRVControlBarrier(&CI);
+    visitCallSPIRVControlBarrier(CI);
   }
   if (isAtomicOpCode(OC)) {
-    visitCallSPIRVAtomicBuiltin(&CI, OC);
+    visitCallSPIRVAtomicBuiltin(CI, OC);
     return;
   }
   if (isGroupOpCode(OC) || isGroupNonUniformOpcode(OC)) {
-    visitCallSPIRVGroupBuiltin(&CI, OC);
+    visitCallSPIRVGroupBuiltin(CI, OC);
     return;
   }
   if (isPipeOpCode(OC)) {
-    visitCallSPIRVPipeBuiltin(&CI, OC);
+    visitCallSPIRVPipeBuiltin(CI, OC);
     return;
   }
   if (isMediaBlockINTELOpcode(OC)) {
-    visitCallSPIRVImageMediaBlockBuiltin(&CI, OC);
+    visitCallSPIRVImageMediaBlockBuiltin(CI, OC);
     return;
   }
   if (isCvtOpCode(OC)) {
-    visitCallSPIRVCvtBuiltin(&CI, OC, DemangledName);
+    visitCallSPIRVCvtBuiltin(CI, OC, DemangledName);
     return;
   }
   if (OC == OpGroupAsyncCopy) {
-    visitCallAsyncWorkGroupCopy(&CI, OC);
+    visitCallAsyncWorkGroupCopy(CI, OC);
     return;
   }
   if (OC == OpGroupWaitEvents) {
-    visitCallGroupWaitEvents(&CI, OC);
+    visitCallGroupWaitEvents(CI, OC);
     return;
   }
   if (OC == OpImageSampleExplicitLod) {
-    visitCallSPIRVImageSampleExplicitLodBuiltIn(&CI, OC);
+    visitCallSPIRVImageSampleExplicitLodBuiltIn(CI, OC);
     return;
   }
   if (OCLSPIRVBuiltinMap::rfind(OC))
-    visitCallSPIRVBuiltin(&CI, OC);
+    visitCallSPIRVBuiltin(CI, OC);
 }
 
 void SPIRVToOCLBase::visitCastInst(CastInst &Cast) {
@@ -665,6 +684,21 @@ std::string SPIRVToOCLBase::getGroupBuiltinPrefix(CallInst *CI) {
   return Prefix;
 }
 
+std::unique_ptr<SPIRVToOCLBase>
+createSPIRVBIsLowering(BIsRepresentation BIsRepresentation) {
+  switch (BIsRepresentation) {
+  case BIsRepresentation::OpenCL12:
+    return createSPIRVToOCL12Lowering();
+  case BIsRepresentation::OpenCL20:
+    return createSPIRVToOCL20Lowering();
+  case BIsRepresentation::SPIRVFriendlyIR:
+    // nothing to do, already done
+    return nullptr;
+  }
+  llvm_unreachable("Unsupported built-ins representation");
+  return nullptr;
+}
+
 } // namespace SPIRV
 
 ModulePass *
@@ -43,7 +43,9 @@
 #include "llvm/IR/InstVisitor.h"
 #include "llvm/Pass.h"
 
+#include <memory>
 #include <string>
+#include <utility>
 
 namespace SPIRV {
 
@@ -56,6 +58,27 @@ public:
 
   void visitCallInst(CallInst &CI);
 
+  /// Transform call \p CI of SPIR-V builtin \p OC, whose unmangled name is
+  /// \p DemangledName, to the OpenCL builtin.
+  void visitCallSPIRVBuiltinOp(CallInst *CI, Op OC, StringRef DemangledName);
+
+  /// Remember that \p F declares SPIR-V builtin \p OC with unmangled name
+  /// \p Name, or a function whose calls are not lowered if \p OC is OpNop,
+  /// so that calls of \p F are visited without demangling it.
+  void addBuiltinDecl(Function *F, Op OC, StringRef Name) {
+    BuiltinDecls[F] = std::make_pair(OC, Name.str());
+  }
+  bool hasBuiltinDecl(Function *F) const { return BuiltinDecls.count(F); }
+
+  /// Transform the SPIR-V builtin calls and vector casts of \p F, which the
+  /// SPIR-V reader has just translated, without visiting the rest of the
+  /// module.
+  void lowerFunction(Function &F) {
+    M = F.getParent();
+    Ctx = &M->getContext();
+    visit(F);
+  }
+
   // SPIR-V reader should translate vector casts into OCL built-ins because
   // such conversions are not defined neither by OpenCL C/C++ nor
   // by SPIR 1.2/2.0 standards. So, it is safer to convert such casts into
@@ -175,6 +198,9 @@ public:
 
   Module *M;
   LLVMContext *Ctx;
+
+  /// Builtin declarations registered by addBuiltinDecl.
+  DenseMap<Function *, std::pair<Op, std::string>> BuiltinDecls;
 };
 
 class SPIRVToOCLLegacy : public ModulePass {
@@ -185,4 +211,16 @@ public:
   bool runOnModule(Module &M) override = 0;
 };
 
+/// \returns true if calls of SPIR-V builtin \p OC are lowered to OpenCL
+/// builtins only by renaming them to OCLSPIRVBuiltinMap::rmap(OC).
+bool isSPIRVBuiltinRenamedToOCL(Op OC);
+
+/// Create the lowering of SPIR-V builtins to \p BIsRepresentation for the
+/// SPIR-V reader to apply to each function it translates.
+/// \returns null if no lowering is required.
+std::unique_ptr<SPIRVToOCLBase>
+createSPIRVBIsLowering(BIsRepresentation BIsRepresentation);
+std::unique_ptr<SPIRVToOCLBase> createSPIRVToOCL12Lowering();
+std::unique_ptr<SPIRVToOCLBase> createSPIRVToOCL20Lowering();
+
 } // namespace SPIRV
@@ -37,7 +37,8 @@
 //
 //===----------------------------------------------------------------------===//
 #include "SPIRVToOCL.h"
-#include "llvm/IR/Verifier.h"
+#include "libSPIRV/SPIRVDebug.h"
+#include "llvm/IR/PassManager.h"
 
 #define DEBUG_TYPE "spvtocl12"
 
@@ -137,11 +138,7 @@ bool SPIRVToOCL12Base::runSPIRVToOCL(Module &Module) {
 
   LLVM_DEBUG(dbgs() << "After SPIRVToOCL12:\n" << *M);
 
-  std::string Err;
-  raw_string_ostream ErrorOS(Err);
-  if (verifyModule(*M, &ErrorOS)) {
-    LLVM_DEBUG(errs() << "Fails to verify module: " << ErrorOS.str());
-  }
+  verifyRegularizationPass(*M, "SPIRVToOCL12");
   return true;
 }
 
@@ -345,6 +342,10 @@ std::string SPIRVToOCL12Base::mapAtomicName(Op OC, Type *Ty) {
   return Prefix += OCL12SPIRVBuiltinMap::rmap(OC);
 }
 
+std::unique_ptr<SPIRVToOCLBase> createSPIRVToOCL12Lowering() {
+  return std::make_unique<SPIRVToOCL12Base>();
+}
+
 } // namespace SPIRV
 
 INITIALIZE_PASS(SPIRVToOCL12Legacy, "spvtoocl12",
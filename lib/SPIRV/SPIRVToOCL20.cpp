@@ -39,7 +39,8 @@
 
 #include "OCLUtil.h"
 #include "SPIRVToOCL.h"
-#include "llvm/IR/Verifier.h"
+#include "libSPIRV/SPIRVDebug.h"
+#include "llvm/IR/PassManager.h"
 
 namespace SPIRV {
 
@@ -114,11 +115,7 @@ bool SPIRVToOCL20Base::runSPIRVToOCL(Module &Module) {
 
   LLVM_DEBUG(dbgs() << "After SPIRVToOCL20:\n" << *M);
 
-  std::string Err;
-  raw_string_ostream ErrorOS(Err);
-  if (verifyModule(*M, &ErrorOS)) {
-    LLVM_DEBUG(errs() << "Fails to verify module: " << ErrorOS.str());
-  }
+  verifyRegularizationPass(*M, "SPIRVToOCL20");
   return true;
 }
 
@@ -306,6 +303,10 @@ Instruction *SPIRVToOCL20Base::visitCallSPIRVAtomicCmpExchg(CallInst *CI,
       &Attrs);
 }
 
+std::unique_ptr<SPIRVToOCLBase> createSPIRVToOCL20Lowering() {
+  return std::make_unique<SPIRVToOCL20Base>();
+}
+
 } // namespace SPIRV
 
 INITIALIZE_PASS(SPIRVToOCL20Legacy, "spvtoocl20",
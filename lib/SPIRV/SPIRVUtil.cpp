@@ -46,6 +46,7 @@
 #include "SPIRVInternal.h"
 #include "SPIRVMDWalker.h"
 #include "libSPIRV/SPIRVDecorate.h"
+#include "libSPIRV/SPIRVStats.h"
 #include "libSPIRV/SPIRVValue.h"
 
 #include "llvm/ADT/StringSwitch.h"
@@ -60,18 +61,12 @@
 
 #include <functional>
 #include <sstream>
+#include <unordered_map>
 
 #define DEBUG_TYPE "spirv"
 
 namespace SPIRV {
 
-#ifdef _SPIRV_SUPPORT_TEXT_FMT
-cl::opt<bool, true>
-    UseTextFormat("spirv-text",
-                  cl::desc("Use text format for SPIR-V for debugging purpose"),
-                  cl::location(SPIRVUseTextFormat));
-#endif
-
 #ifdef _SPIRVDBG
 cl::opt<bool, true> EnableDbgOutput("spirv-debug",
                                     cl::desc("Enable SPIR-V debug output"),
@@ -536,23 +531,18 @@ bool isMangledTypeFP(char Mangled) {
 }
 
 // Check if a mangled type Name is half
-bool isMangledTypeHalf(std::string Mangled) {
+bool isMangledTypeHalf(StringRef Mangled) {
   return Mangled == "Dh"; /* half */
 }
 
-void eraseSubstitutionFromMangledName(std::string &MangledName) {
-  auto Len = MangledName.length();
-  while (Len >= 2 && MangledName.substr(Len - 2, 2) == "S_") {
-    Len -= 2;
-    MangledName.erase(Len, 2);
-  }
-}
-
 ParamType lastFuncParamType(StringRef MangledName) {
-  std::string Copy(MangledName);
-  eraseSubstitutionFromMangledName(Copy);
-  char Mangled = Copy.back();
-  std::string Mangled2 = Copy.substr(Copy.size() - 2);
+  // Skip substitutions at the end of the mangled name.
+  while (MangledName.size() >= 2 && MangledName.endswith("S_"))
+    MangledName = MangledName.drop_back(2);
+  if (MangledName.empty())
+    return ParamType::UNKNOWN;
+  char Mangled = MangledName.back();
+  StringRef Mangled2 = MangledName.take_back(2);
 
   if (isMangledTypeFP(Mangled) || isMangledTypeHalf(Mangled2)) {
     return ParamType::FLOAT;
@@ -579,6 +569,122 @@ bool containsUnsignedAtomicType(StringRef Name) {
       Name[Loc + strlen(kMangledName::AtomicPrefixIncoming)]);
 }
 
+// Decode an extended instruction from a demangled name in the format
+// __spirv_{ExtSetShortName}_{ExtOpName}__{Postfixes}
+static void getExtInstFromDemangledName(StringRef S, BuiltinFuncInfo &Info) {
+  if (!S.startswith(kSPIRVName::Prefix))
+    return;
+  S = S.drop_front(strlen(kSPIRVName::Prefix));
+  auto Loc = S.find(kSPIRVPostfix::Divider);
+  auto ExtSetName = S.substr(0, Loc);
+  SPIRVExtInstSetKind Set = SPIRVEIS_Count;
+  if (!SPIRVExtSetShortNameMap::rfind(ExtSetName.str(), &Set))
+    return;
+
+  auto ExtOpName = S.substr(Loc + 1);
+  auto Splited = ExtOpName.split(kSPIRVPostfix::ExtDivider);
+  OCLExtOpKind EOC;
+  if (!OCLExtOpMap::rfind(Splited.first.str(), &EOC))
+    return;
+
+  Info.ExtSet = Set;
+  Info.ExtOp = EOC;
+  SmallVector<StringRef, 2> P;
+  Splited.second.split(P, kSPIRVPostfix::Divider);
+  for (auto &I : P)
+    Info.ExtDec.push_back(I.str());
+}
+
+static void computeBuiltinFuncInfo(StringRef Name, BuiltinFuncInfo &Info) {
+  if (TranslationStats *Stats = getActiveTranslationStats())
+    ++Stats->BuiltinNameMisses;
+  Info = BuiltinFuncInfo();
+  Info.Name = Name.str();
+  Info.LastParamType = lastFuncParamType(Name);
+
+  StringRef DemangledName;
+  Info.IsOCLBuiltin = oclIsBuiltin(Name, DemangledName);
+  Info.IsDecoratedSPIRV = Name.startswith(kSPIRVName::Prefix);
+  if (!Info.IsOCLBuiltin) {
+    if (!Info.IsDecoratedSPIRV)
+      return;
+    DemangledName = Name;
+  }
+  Info.DemangledStart = DemangledName.data() - Name.data();
+  Info.DemangledLen = DemangledName.size();
+  Info.OC = getSPIRVFuncOC(DemangledName, &Info.OCDec);
+  if (Info.IsOCLBuiltin)
+    getExtInstFromDemangledName(DemangledName, Info);
+}
+
+// Name cache of the session translating on this thread, if any.
+static thread_local BuiltinNameCache *ActiveNameCache = nullptr;
+
+static void fillBuiltinFuncInfo(StringRef Name, BuiltinFuncInfo &Info) {
+  if (ActiveNameCache)
+    ActiveNameCache->lookup(Name, Info);
+  else
+    computeBuiltinFuncInfo(Name, Info);
+}
+
+const BuiltinFuncInfo &getBuiltinFuncInfo(const Function *F) {
+  // Functions of translated modules are destroyed without notifying the
+  // cache, so it is trimmed once it grows beyond this number of entries.
+  const size_t MaxCachedFuncs = 1 << 16;
+  static thread_local std::unordered_map<const Function *, BuiltinFuncInfo>
+      Cache;
+
+  StringRef Name = F->getName();
+  auto Loc = Cache.find(F);
+  if (Loc != Cache.end()) {
+    if (Loc->second.Name != Name)
+      fillBuiltinFuncInfo(Name, Loc->second);
+    else if (TranslationStats *Stats = getActiveTranslationStats())
+      ++Stats->BuiltinNameHits;
+    return Loc->second;
+  }
+  if (Cache.size() >= MaxCachedFuncs)
+    Cache.clear();
+  BuiltinFuncInfo &Info = Cache[F];
+  fillBuiltinFuncInfo(Name, Info);
+  return Info;
+}
+
+void BuiltinNameCache::lookup(StringRef Name, BuiltinFuncInfo &Info) {
+  // User function names are cached too, so bound the memory used by a
+  // long-lived cache the same way as the per-thread one.
+  const size_t MaxCachedNames = 1 << 16;
+  {
+    std::lock_guard<std::mutex> Guard(Lock);
+    auto Loc = Map.find(Name);
+    if (Loc != Map.end()) {
+      ++Hits;
+      if (TranslationStats *Stats = getActiveTranslationStats())
+        ++Stats->BuiltinNameHits;
+      Info = Loc->second;
+      return;
+    }
+  }
+  ++Misses;
+  computeBuiltinFuncInfo(Name, Info);
+  std::lock_guard<std::mutex> Guard(Lock);
+  if (Map.size() >= MaxCachedNames)
+    Map.clear();
+  Map.try_emplace(Name, Info);
+}
+
+size_t BuiltinNameCache::size() const {
+  std::lock_guard<std::mutex> Guard(Lock);
+  return Map.size();
+}
+
+BuiltinNameCacheScope::BuiltinNameCacheScope(BuiltinNameCache *Cache)
+    : Saved(ActiveNameCache) {
+  ActiveNameCache = Cache;
+}
+
+BuiltinNameCacheScope::~BuiltinNameCacheScope() { ActiveNameCache = Saved; }
+
 bool isFunctionPointerType(Type *T) {
   if (isa<PointerType>(T) && isa<FunctionType>(T->getPointerElementType())) {
     return true;
@@ -42,6 +42,8 @@
 #include "LLVMToSPIRVDbgTran.h"
 #include "SPIRVAsm.h"
 #include "SPIRVBasicBlock.h"
+#include "SPIRVCache.h"
+#include "SPIRVDebug.h"
 #include "SPIRVEntry.h"
 #include "SPIRVEnum.h"
 #include "SPIRVExtInst.h"
@@ -52,19 +54,25 @@
 #include "SPIRVMDWalker.h"
 #include "SPIRVMemAliasingINTEL.h"
 #include "SPIRVModule.h"
+#include "SPIRVStats.h"
 #include "SPIRVType.h"
 #include "SPIRVUtil.h"
 #include "SPIRVValue.h"
 #include "VectorComputeUtil.h"
 
 #include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringSwitch.h"
 #include "llvm/ADT/Triple.h"
 #include "llvm/Analysis/ValueTracking.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
 #include "llvm/IR/Constants.h"
+#include "llvm/IR/DebugInfoMetadata.h"
 #include "llvm/IR/DerivedTypes.h"
 #include "llvm/IR/Function.h"
 #include "llvm/IR/InlineAsm.h"
+#include "llvm/IR/InstIterator.h"
 #include "llvm/IR/InstrTypes.h"
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/IntrinsicInst.h"
@@ -75,15 +83,21 @@
 #include "llvm/Support/Casting.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/xxhash.h"
 #include "llvm/Transforms/Utils.h" // loop-simplify pass
+#include "llvm/Transforms/Utils/Cloning.h"
 
+#include <chrono>
 #include <cstdlib>
+#include <cstring>
 #include <functional>
 #include <iostream>
 #include <memory>
 #include <queue>
 #include <regex>
 #include <set>
+#include <sstream>
 #include <vector>
 
 #define DEBUG_TYPE "spirv"
@@ -149,51 +163,34 @@ bool LLVMToSPIRVBase::isKernel(Function *F) {
 }
 
 bool LLVMToSPIRVBase::isBuiltinTransToInst(Function *F) {
-  StringRef DemangledName;
-  if (!oclIsBuiltin(F->getName(), DemangledName) &&
-      !isDecoratedSPIRVFunc(F, DemangledName))
+  const BuiltinFuncInfo &Info = getBuiltinFuncInfo(F);
+  if (!Info.isBuiltin())
     return false;
-  SPIRVDBG(spvdbgs() << "CallInst: demangled name: " << DemangledName.str()
-                     << '\n');
-  return getSPIRVFuncOC(DemangledName) != OpNop;
+  SPIRVDBG(spvdbgs() << "CallInst: demangled name: "
+                     << Info.getDemangledName(F).str() << '\n');
+  return Info.OC != OpNop;
 }
 
 bool LLVMToSPIRVBase::isBuiltinTransToExtInst(
     Function *F, SPIRVExtInstSetKind *ExtSet, SPIRVWord *ExtOp,
     SmallVectorImpl<std::string> *Dec) {
-  StringRef DemangledName;
-  if (!oclIsBuiltin(F->getName(), DemangledName))
+  const BuiltinFuncInfo &Info = getBuiltinFuncInfo(F);
+  if (!Info.IsOCLBuiltin)
     return false;
   LLVM_DEBUG(dbgs() << "[oclIsBuiltinTransToExtInst] CallInst: demangled name: "
-                    << DemangledName << '\n');
-  StringRef S = DemangledName;
-  if (!S.startswith(kSPIRVName::Prefix))
+                    << Info.getDemangledName(F) << '\n');
+  if (!Info.isExtInst())
     return false;
-  S = S.drop_front(strlen(kSPIRVName::Prefix));
-  auto Loc = S.find(kSPIRVPostfix::Divider);
-  auto ExtSetName = S.substr(0, Loc);
-  SPIRVExtInstSetKind Set = SPIRVEIS_Count;
-  if (!SPIRVExtSetShortNameMap::rfind(ExtSetName.str(), &Set))
-    return false;
-  assert((Set == SPIRVEIS_OpenCL || Set == BM->getDebugInfoEIS()) &&
+  assert((Info.ExtSet == SPIRVEIS_OpenCL ||
+          Info.ExtSet == BM->getDebugInfoEIS()) &&
          "Unsupported extended instruction set");
 
-  auto ExtOpName = S.substr(Loc + 1);
-  auto Splited = ExtOpName.split(kSPIRVPostfix::ExtDivider);
-  OCLExtOpKind EOC;
-  if (!OCLExtOpMap::rfind(Splited.first.str(), &EOC))
-    return false;
-
   if (ExtSet)
-    *ExtSet = Set;
+    *ExtSet = Info.ExtSet;
   if (ExtOp)
-    *ExtOp = EOC;
-  if (Dec) {
-    SmallVector<StringRef, 2> P;
-    Splited.second.split(P, kSPIRVPostfix::Divider);
-    for (auto &I : P)
-      Dec->push_back(I.str());
-  }
+    *ExtOp = Info.ExtOp;
+  if (Dec)
+    Dec->append(Info.ExtDec.begin(), Info.ExtDec.end());
   return true;
 }
 
@@ -280,7 +277,8 @@ SPIRVType *LLVMToSPIRVBase::transType(Type *T) {
             ExtensionID::SPV_INTEL_arbitrary_precision_integers) ||
         BM->getErrorLog().checkError(
             BitWidth == 8 || BitWidth == 16 || BitWidth == 32 || BitWidth == 64,
-            SPIRVEC_InvalidBitWidth, std::to_string(BitWidth))) {
+            SPIRVEC_InvalidBitWidth,
+            [&] { return std::to_string(BitWidth); })) {
       return mapType(T, BM->addIntegerType(T->getIntegerBitWidth()));
     }
   }
@@ -725,6 +723,39 @@ void LLVMToSPIRVBase::transFPGAFunctionMetadata(SPIRVFunction *BF,
   }
 }
 
+SPIRVValue *LLVMToSPIRVBase::getLiteralConstant(SPIRVType *Ty,
+                                                uint64_t Literal) {
+  auto &BV = LiteralConstMap[std::make_pair(Ty, Literal)];
+  if (!BV)
+    BV = BM->addConstant(Ty, Literal);
+  return BV;
+}
+
+// Translate the elements of a data array or vector straight from their raw
+// values. Going through getElementAsConstant would create (and keep alive)
+// an LLVM constant per distinct element, which dominates memory for large
+// lookup tables. Repeated elements share one SPIR-V constant through
+// LiteralConstMap, and addCompositeConstant splits the result into
+// OpConstantCompositeContinuedINTEL when SPV_INTEL_long_constant_composite is
+// enabled. Returns nullptr for element types not handled here.
+SPIRVValue *
+LLVMToSPIRVBase::transConstantDataSequential(ConstantDataSequential *CDS) {
+  Type *ElemTy = CDS->getElementType();
+  bool IsFP = ElemTy->isHalfTy() || ElemTy->isFloatTy() || ElemTy->isDoubleTy();
+  if (!IsFP && !ElemTy->isIntegerTy())
+    return nullptr;
+  SPIRVType *BElemTy = transType(ElemTy);
+  std::vector<SPIRVValue *> BV;
+  BV.reserve(CDS->getNumElements());
+  for (unsigned I = 0, E = CDS->getNumElements(); I != E; ++I) {
+    uint64_t Literal =
+        IsFP ? CDS->getElementAsAPFloat(I).bitcastToAPInt().getZExtValue()
+             : CDS->getElementAsInteger(I);
+    BV.push_back(getLiteralConstant(BElemTy, Literal));
+  }
+  return BM->addCompositeConstant(transType(CDS->getType()), BV);
+}
+
 SPIRVValue *LLVMToSPIRVBase::transConstant(Value *V) {
   if (auto CPNull = dyn_cast<ConstantPointerNull>(V))
     return BM->addNullConstant(
@@ -749,15 +780,19 @@ SPIRVValue *LLVMToSPIRVBase::transConstant(Value *V) {
           SPIRVEC_InvalidBitWidth, std::to_string(BitWidth));
       return BM->addConstant(transType(V->getType()), ConstI->getValue());
     }
-    return BM->addConstant(transType(V->getType()), ConstI->getZExtValue());
+    return getLiteralConstant(transType(V->getType()), ConstI->getZExtValue());
   }
 
   if (auto ConstFP = dyn_cast<ConstantFP>(V)) {
     auto BT = static_cast<SPIRVType *>(transType(V->getType()));
-    return BM->addConstant(
+    return getLiteralConstant(
         BT, ConstFP->getValueAPF().bitcastToAPInt().getZExtValue());
   }
 
+  if (auto CDS = dyn_cast<ConstantDataSequential>(V))
+    if (auto BV = transConstantDataSequential(CDS))
+      return BV;
+
   if (auto ConstDA = dyn_cast<ConstantDataArray>(V)) {
     std::vector<SPIRVValue *> BV;
     for (unsigned I = 0, E = ConstDA->getNumElements(); I != E; ++I)
@@ -913,21 +948,24 @@ SPIRV::SPIRVInstruction *LLVMToSPIRVBase::transUnaryInst(UnaryInstruction *U,
     const auto DestAddrSpace = Cast->getDestTy()->getPointerAddressSpace();
     if (DestAddrSpace == SPIRAS_Generic) {
       getErrorLog().checkError(
-          SrcAddrSpace != SPIRAS_Constant, SPIRVEC_InvalidModule,
-          "Casts from constant address space to generic are illegal\n" +
-              toString(U));
+          SrcAddrSpace != SPIRAS_Constant, SPIRVEC_InvalidModule, [&] {
+            return "Casts from constant address space to generic are "
+                   "illegal\n" +
+                   toString(U);
+          });
       BOC = OpPtrCastToGeneric;
       // In SPIR-V only casts to/from generic are allowed. But with
       // SPV_INTEL_usm_storage_classes we can also have casts from global_device
       // and global_host to global addr space and vice versa.
     } else if (SrcAddrSpace == SPIRAS_GlobalDevice ||
                SrcAddrSpace == SPIRAS_GlobalHost) {
-      getErrorLog().checkError(DestAddrSpace == SPIRAS_Global ||
-                                   DestAddrSpace == SPIRAS_Generic,
-                               SPIRVEC_InvalidModule,
-                               "Casts from global_device/global_host only "
-                               "allowed to global/generic\n" +
-                                   toString(U));
+      getErrorLog().checkError(
+          DestAddrSpace == SPIRAS_Global || DestAddrSpace == SPIRAS_Generic,
+          SPIRVEC_InvalidModule, [&] {
+            return "Casts from global_device/global_host only "
+                   "allowed to global/generic\n" +
+                   toString(U);
+          });
       if (!BM->isAllowedToUseExtension(
               ExtensionID::SPV_INTEL_usm_storage_classes)) {
         if (DestAddrSpace == SPIRAS_Global)
@@ -938,12 +976,13 @@ SPIRV::SPIRVInstruction *LLVMToSPIRVBase::transUnaryInst(UnaryInstruction *U,
       }
     } else if (DestAddrSpace == SPIRAS_GlobalDevice ||
                DestAddrSpace == SPIRAS_GlobalHost) {
-      getErrorLog().checkError(SrcAddrSpace == SPIRAS_Global ||
-                                   SrcAddrSpace == SPIRAS_Generic,
-                               SPIRVEC_InvalidModule,
-                               "Casts to global_device/global_host only "
-                               "allowed from global/generic\n" +
-                                   toString(U));
+      getErrorLog().checkError(
+          SrcAddrSpace == SPIRAS_Global || SrcAddrSpace == SPIRAS_Generic,
+          SPIRVEC_InvalidModule, [&] {
+            return "Casts to global_device/global_host only "
+                   "allowed from global/generic\n" +
+                   toString(U);
+          });
       if (!BM->isAllowedToUseExtension(
               ExtensionID::SPV_INTEL_usm_storage_classes)) {
         if (SrcAddrSpace == SPIRAS_Global)
@@ -954,14 +993,17 @@ SPIRV::SPIRVInstruction *LLVMToSPIRVBase::transUnaryInst(UnaryInstruction *U,
       }
     } else {
       getErrorLog().checkError(
-          SrcAddrSpace == SPIRAS_Generic, SPIRVEC_InvalidModule,
-          "Casts from private/local/global address space are allowed only to "
-          "generic\n" +
-              toString(U));
+          SrcAddrSpace == SPIRAS_Generic, SPIRVEC_InvalidModule, [&] {
+            return "Casts from private/local/global address space are allowed "
+                   "only to generic\n" +
+                   toString(U);
+          });
       getErrorLog().checkError(
-          DestAddrSpace != SPIRAS_Constant, SPIRVEC_InvalidModule,
-          "Casts from generic address space to constant are illegal\n" +
-              toString(U));
+          DestAddrSpace != SPIRAS_Constant, SPIRVEC_InvalidModule, [&] {
+            return "Casts from generic address space to constant are "
+                   "illegal\n" +
+                   toString(U);
+          });
       BOC = OpGenericCastToPtr;
     }
   } else {
@@ -1717,10 +1759,11 @@ LLVMToSPIRVBase::transValueWithoutDecoration(Value *V, SPIRVBasicBlock *BB,
     AtomicRMWInst::BinOp Op = ARMW->getOperation();
     if (!BM->getErrorLog().checkError(
             !AtomicRMWInst::isFPOperation(Op) && Op != AtomicRMWInst::Nand,
-            SPIRVEC_InvalidInstruction,
-            OCLUtil::toString(V) + "\nAtomic " +
-                AtomicRMWInst::getOperationName(Op).str() +
-                " is not supported in SPIR-V!\n"))
+            SPIRVEC_InvalidInstruction, [&] {
+              return OCLUtil::toString(V) + "\nAtomic " +
+                     AtomicRMWInst::getOperationName(Op).str() +
+                     " is not supported in SPIR-V!\n";
+            }))
       return nullptr;
 
     spv::Op OC = LLVMSPIRVAtomicRmwOpCodeMap::map(Op);
@@ -2916,16 +2959,18 @@ SPIRVValue *LLVMToSPIRVBase::transDirectCallInst(CallInst *CI,
   SPIRVWord ExtOp = SPIRVWORD_MAX;
   llvm::Function *F = CI->getCalledFunction();
   auto MangledName = F->getName();
-  StringRef DemangledName;
 
   if (MangledName.startswith(SPCV_CAST) || MangledName == SAMPLER_INIT)
     return oclTransSpvcCastSampler(CI, BB);
 
-  if (oclIsBuiltin(MangledName, DemangledName) ||
-      isDecoratedSPIRVFunc(F, DemangledName)) {
-    if (auto BV = transBuiltinToConstant(DemangledName, CI))
+  const BuiltinFuncInfo &Info = getBuiltinFuncInfo(F);
+  if (Info.isBuiltin() && Info.OC != OpNop) {
+    // Copy out of the cache since translation of the arguments may query it.
+    Op OC = Info.OC;
+    SmallVector<std::string, 2> Dec(Info.OCDec.begin(), Info.OCDec.end());
+    if (auto BV = transBuiltinToConstant(OC, CI))
       return BV;
-    if (auto BV = transBuiltinToInst(DemangledName, CI, BB))
+    if (auto BV = transBuiltinToInst(OC, Dec, CI, BB))
       return BV;
   }
 
@@ -3279,6 +3324,15 @@ void LLVMToSPIRVBase::transFunction(Function *I) {
   if (IsKernelEntryPoint) {
     collectInputOutputVariables(BF, I);
   }
+
+  if (StreamFunctionBodies) {
+    for (auto &FI : *I) {
+      for (auto &BI : FI)
+        ValueMap.erase(&BI);
+      ValueMap.erase(&FI);
+    }
+    BM->streamFunction(BF);
+  }
 }
 
 bool isEmptyLLVMModule(Module *M) {
@@ -3286,7 +3340,21 @@ bool isEmptyLLVMModule(Module *M) {
          M->global_empty(); // No global variables
 }
 
+// Debug info is translated once all functions are, and refers to their
+// instructions, so function bodies are only streamed without it.
+static bool canStreamFunctionBodies(const Module &M) {
+#ifdef LLVM_SPIRV_ENABLE_TRACE
+  // Trace offsets are counted in the order instructions are encoded.
+  return false;
+#else
+  if (M.getNamedMetadata("llvm.dbg.cu"))
+    return false;
+  return none_of(M, [](const Function &F) { return F.getSubprogram(); });
+#endif
+}
+
 bool LLVMToSPIRVBase::translate() {
+  TranslationPhaseTimer Timer("llvm-to-spirv");
   BM->setGeneratorVer(KTranslatorVer);
 
   if (isEmptyLLVMModule(M))
@@ -3326,6 +3394,8 @@ bool LLVMToSPIRVBase::translate() {
   }
   for (auto I : Decls)
     transFunctionDecl(I);
+  StreamFunctionBodies =
+      BM->shouldStreamFunctionBodies() && canStreamFunctionBodies(*M);
   for (auto I : Defs)
     transFunction(I);
 
@@ -3348,18 +3418,17 @@ llvm::IntegerType *LLVMToSPIRVBase::getSizetType(unsigned AS) {
 void LLVMToSPIRVBase::oclGetMutatedArgumentTypesByBuiltin(
     llvm::FunctionType *FT, std::map<unsigned, Type *> &ChangedType,
     Function *F) {
-  StringRef Demangled;
-  if (!oclIsBuiltin(F->getName(), Demangled))
+  const BuiltinFuncInfo &Info = getBuiltinFuncInfo(F);
+  if (!Info.IsOCLBuiltin)
     return;
+  StringRef Demangled = Info.getDemangledName(F);
   if (Demangled.find(kSPIRVName::SampledImage) == std::string::npos)
     return;
   if (FT->getParamType(1)->isIntegerTy())
     ChangedType[1] = getSamplerType(F->getParent());
 }
 
-SPIRVValue *LLVMToSPIRVBase::transBuiltinToConstant(StringRef DemangledName,
-                                                    CallInst *CI) {
-  Op OC = getSPIRVFuncOC(DemangledName);
+SPIRVValue *LLVMToSPIRVBase::transBuiltinToConstant(Op OC, CallInst *CI) {
   if (!isSpecConstantOpCode(OC))
     return nullptr;
   if (OC == spv::OpSpecConstantComposite) {
@@ -3382,12 +3451,9 @@ SPIRVValue *LLVMToSPIRVBase::transBuiltinToConstant(StringRef DemangledName,
   return SC;
 }
 
-SPIRVInstruction *LLVMToSPIRVBase::transBuiltinToInst(StringRef DemangledName,
-                                                      CallInst *CI,
-                                                      SPIRVBasicBlock *BB) {
-  SmallVector<std::string, 2> Dec;
-  auto OC = getSPIRVFuncOC(DemangledName, &Dec);
-
+SPIRVInstruction *LLVMToSPIRVBase::transBuiltinToInst(
+    Op OC, const SmallVectorImpl<std::string> &Dec, CallInst *CI,
+    SPIRVBasicBlock *BB) {
   if (OC == OpNop)
     return nullptr;
 
@@ -3399,10 +3465,12 @@ SPIRVInstruction *LLVMToSPIRVBase::transBuiltinToInst(StringRef DemangledName,
     BM->getErrorLog().checkError(
         BM->isAllowedToUseExtension(
             ExtensionID::SPV_INTEL_arbitrary_precision_fixed_point),
-        SPIRVEC_InvalidInstruction,
-        CI->getCalledOperand()->getName().str() +
-            "\nFixed point instructions can't be translated correctly without "
-            "enabled SPV_INTEL_arbitrary_precision_fixed_point extension!\n");
+        SPIRVEC_InvalidInstruction, [&] {
+          return CI->getCalledOperand()->getName().str() +
+                 "\nFixed point instructions can't be translated correctly "
+                 "without enabled SPV_INTEL_arbitrary_precision_fixed_point "
+                 "extension!\n";
+        });
 
   if ((OpArbitraryFloatSinCosPiINTEL <= OC &&
        OC <= OpArbitraryFloatCastToIntINTEL) ||
@@ -3410,11 +3478,12 @@ SPIRVInstruction *LLVMToSPIRVBase::transBuiltinToInst(StringRef DemangledName,
     BM->getErrorLog().checkError(
         BM->isAllowedToUseExtension(
             ExtensionID::SPV_INTEL_arbitrary_precision_floating_point),
-        SPIRVEC_InvalidInstruction,
-        CI->getCalledOperand()->getName().str() +
-            "\nFloating point instructions can't be translated correctly "
-            "without enabled SPV_INTEL_arbitrary_precision_floating_point "
-            "extension!\n");
+        SPIRVEC_InvalidInstruction, [&] {
+          return CI->getCalledOperand()->getName().str() +
+                 "\nFloating point instructions can't be translated correctly "
+                 "without enabled SPV_INTEL_arbitrary_precision_floating_point "
+                 "extension!\n";
+        });
 
   auto Inst = transBuiltinToInstWithoutDecoration(OC, CI, BB);
   addDecorations(Inst, Dec);
@@ -4017,20 +4086,112 @@ ModulePass *llvm::createLLVMToSPIRVLegacy(SPIRVModule *SMod) {
   return new LLVMToSPIRVLegacy(SMod);
 }
 
-void addPassesForSPIRV(legacy::PassManager &PassMgr,
-                       const SPIRV::TranslatorOpts &Opts) {
+namespace {
+// Adds the time elapsed since the previous marker of the same pass manager to
+// a phase of the active stats. Markers are only scheduled while stats are
+// collected and preserve everything, so they do not change what runs.
+class SPIRVPhaseMarkerLegacy : public ModulePass {
+public:
+  typedef std::chrono::steady_clock::time_point TimePoint;
+
+  // A marker without \p Phase only starts the clock.
+  SPIRVPhaseMarkerLegacy(std::shared_ptr<TimePoint> Last, const char *Phase)
+      : ModulePass(ID), Last(std::move(Last)), Phase(Phase) {}
+
+  bool runOnModule(Module &M) override {
+    TimePoint Now = std::chrono::steady_clock::now();
+    TranslationStats *Stats = getActiveTranslationStats();
+    if (Phase && Stats)
+      Stats->addPhase(Phase,
+                      std::chrono::duration<double>(Now - *Last).count());
+    *Last = Now;
+    return false;
+  }
+
+  void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.setPreservesAll();
+  }
+
+  StringRef getPassName() const override { return "SPIR-V phase marker"; }
+
+  static char ID;
+
+private:
+  std::shared_ptr<TimePoint> Last;
+  const char *Phase;
+};
+
+char SPIRVPhaseMarkerLegacy::ID = 0;
+
+// Adds passes to a pass manager, timing each of them as phase
+// "pass:<name>" if stats are collected on this thread. With
+// VerificationLevel::PerPass the passes are held back instead, to be run one
+// at a time by runVerified.
+class SPIRVPassAdder {
+public:
+  SPIRVPassAdder(legacy::PassManager &PassMgr,
+                 const SPIRV::TranslatorOpts &Opts)
+      : PassMgr(PassMgr), VerifyEach(Opts.getVerificationLevel() ==
+                                     VerificationLevel::PerPass) {
+    if (VerifyEach || !getActiveTranslationStats())
+      return;
+    Last = std::make_shared<SPIRVPhaseMarkerLegacy::TimePoint>();
+    PassMgr.add(new SPIRVPhaseMarkerLegacy(Last, nullptr));
+  }
+
+  void add(Pass *P, const char *Phase) {
+    if (VerifyEach) {
+      Pending.emplace_back(P, Phase);
+      return;
+    }
+    PassMgr.add(P);
+    if (Last)
+      PassMgr.add(new SPIRVPhaseMarkerLegacy(Last, Phase));
+  }
+
+  // Runs the passes held back, verifying the module after each of them.
+  // \returns false and sets \p ErrMsg at the first pass producing an invalid
+  // module, without running the rest.
+  bool runVerified(Module &M, std::string &ErrMsg) {
+    std::vector<std::pair<std::unique_ptr<Pass>, const char *>> Passes;
+    Passes.swap(Pending);
+    for (auto &P : Passes) {
+      {
+        TranslationPhaseTimer Timer(P.second);
+        legacy::PassManager SinglePassMgr;
+        SinglePassMgr.add(P.first.release());
+        SinglePassMgr.run(M);
+      }
+      if (!verifyModuleAfter(M, StringRef(P.second).split(':').second.str(),
+                             ErrMsg))
+        return false;
+    }
+    return true;
+  }
+
+private:
+  legacy::PassManager &PassMgr;
+  bool VerifyEach;
+  std::shared_ptr<SPIRVPhaseMarkerLegacy::TimePoint> Last;
+  std::vector<std::pair<std::unique_ptr<Pass>, const char *>> Pending;
+};
+} // namespace
+
+static void addPassesForSPIRV(SPIRVPassAdder &Adder,
+                              const SPIRV::TranslatorOpts &Opts) {
   if (Opts.isSPIRVMemToRegEnabled())
-    PassMgr.add(createPromoteMemoryToRegisterPass());
-  PassMgr.add(createPreprocessMetadataLegacy());
-  PassMgr.add(createSPIRVLowerSPIRBlocksLegacy());
-  PassMgr.add(createOCLTypeToSPIRVLegacy());
-  PassMgr.add(createSPIRVLowerOCLBlocksLegacy());
-  PassMgr.add(createOCLToSPIRVLegacy());
-  PassMgr.add(createSPIRVRegularizeLLVMLegacy());
-  PassMgr.add(createSPIRVLowerConstExprLegacy());
-  PassMgr.add(createSPIRVLowerBoolLegacy());
-  PassMgr.add(createSPIRVLowerMemmoveLegacy());
-  PassMgr.add(createSPIRVLowerSaddWithOverflowLegacy());
+    Adder.add(createPromoteMemoryToRegisterPass(), "pass:mem2reg");
+  Adder.add(createPreprocessMetadataLegacy(), "pass:preprocess-metadata");
+  Adder.add(createSPIRVLowerSPIRBlocksLegacy(), "pass:spv-lower-spir-blocks");
+  Adder.add(createOCLTypeToSPIRVLegacy(), "pass:cltytospv");
+  Adder.add(createSPIRVLowerOCLBlocksLegacy(), "pass:spv-lower-ocl-blocks");
+  Adder.add(createOCLToSPIRVLegacy(), "pass:ocl-to-spv");
+  Adder.add(createSPIRVRegularizeLLVMLegacy(), "pass:spvregular");
+  Adder.add(createSPIRVLowerConstExprLegacy(), "pass:spv-lower-const-expr");
+  Adder.add(createSPIRVLowerBoolLegacy(), "pass:spvbool");
+  Adder.add(createSPIRVLowerMemmoveLegacy(), "pass:spvmemmove");
+  Adder.add(createSPIRVLowerSaddWithOverflowLegacy(),
+            "pass:spv-lower-llvm_sadd_with_overflow");
 }
 
 bool isValidLLVMModule(Module *M, SPIRVErrorLog &ErrorLog) {
@@ -4058,16 +4219,42 @@ bool llvm::writeSpirv(Module *M, std::ostream &OS, std::string &ErrMsg) {
 
 bool llvm::writeSpirv(Module *M, const SPIRV::TranslatorOpts &Opts,
                       std::ostream &OS, std::string &ErrMsg) {
+  if (M && !Opts.getTranslationCacheDir().empty()) {
+    TranslationCache Cache(Opts, /*Reverse=*/false);
+    SmallString<0> Bitcode;
+    raw_svector_ostream BitcodeOS(Bitcode);
+    WriteBitcodeToFile(*M, BitcodeOS);
+    uint64_t Key = Cache.getKey(Bitcode);
+    std::string Result;
+    // A cache hit would skip the passes verified at PerPass.
+    bool Reuse = Opts.getVerificationLevel() != VerificationLevel::PerPass;
+    if (!Reuse || !Cache.lookup(Key, Result)) {
+      SPIRV::TranslatorOpts UncachedOpts(Opts);
+      UncachedOpts.setTranslationCacheDir("");
+      std::ostringstream SS;
+      if (!writeSpirv(M, UncachedOpts, SS, ErrMsg))
+        return false;
+      Result = SS.str();
+      Cache.store(Key, Result);
+    }
+    OS.write(Result.data(), Result.size());
+    return true;
+  }
+
   std::unique_ptr<SPIRVModule> BM(SPIRVModule::createSPIRVModule(Opts));
   if (!isValidLLVMModule(M, BM->getErrorLog()))
     return false;
 
+  ManagedVerificationScope Verification;
   legacy::PassManager PassMgr;
-  addPassesForSPIRV(PassMgr, Opts);
+  SPIRVPassAdder Adder(PassMgr, Opts);
+  addPassesForSPIRV(Adder, Opts);
   // Run loop simplify pass in order to avoid duplicate OpLoopMerge
   // instruction. It can happen in case of continue operand in the loop.
   if (hasLoopMetadata(M))
-    PassMgr.add(createLoopSimplifyPass());
+    Adder.add(createLoopSimplifyPass(), "pass:loop-simplify");
+  if (!Adder.runVerified(*M, ErrMsg))
+    return false;
   PassMgr.add(createLLVMToSPIRVLegacy(BM.get()));
   PassMgr.run(*M);
 
@@ -4077,6 +4264,351 @@ bool llvm::writeSpirv(Module *M, const SPIRV::TranslatorOpts &Opts,
   return true;
 }
 
+bool llvm::writeSpirv(Module *M, const SPIRV::TranslatorOpts &Opts,
+                      std::ostream &OS, std::string &ErrMsg,
+                      SPIRV::TranslationStats &Stats) {
+  std::ostringstream SS;
+  {
+    TranslationStatsScope Scope(&Stats);
+    if (!writeSpirv(M, Opts, SS, ErrMsg))
+      return false;
+  }
+  const std::string Result = SS.str();
+  Stats.BytesOut += Result.size();
+  OS.write(Result.data(), Result.size());
+  return true;
+}
+
+// Returns true if an instruction with opcode \p OC may precede
+// OpModuleProcessed in the module layout.
+static bool precedesModuleProcessed(Op OC) {
+  switch (OC) {
+  case OpCapability:
+  case OpExtension:
+  case OpExtInstImport:
+  case OpMemoryModel:
+  case OpEntryPoint:
+  case OpExecutionMode:
+  case OpExecutionModeId:
+  case OpString:
+  case OpSourceExtension:
+  case OpSource:
+  case OpSourceContinued:
+  case OpName:
+  case OpMemberName:
+  case OpModuleProcessed:
+    return true;
+  default:
+    return false;
+  }
+}
+
+// Copy SPIR-V binary \p In to \p Out dropping OpLine, OpNoLine,
+// OpSourceContinued and everything of the debug info extended instruction
+// sets. \p Marker is added as an OpModuleProcessed instruction.
+static void stripDebugInstructions(const std::vector<SPIRVWord> &In,
+                                   const std::string &Marker,
+                                   std::vector<SPIRVWord> &Out) {
+  const size_t HeaderSize = 5;
+  if (In.size() < HeaderSize) {
+    Out = In;
+    return;
+  }
+  std::set<SPIRVWord> DebugSets;
+  size_t MarkerPos = HeaderSize;
+  Out.reserve(In.size());
+  Out.insert(Out.end(), In.begin(), In.begin() + HeaderSize);
+  for (size_t I = HeaderSize; I < In.size();) {
+    SPIRVWord WordCount = In[I] >> WordCountShift;
+    Op OC = static_cast<Op>(In[I] & 0xFFFF);
+    assert(WordCount && I + WordCount <= In.size() && "Invalid SPIR-V");
+    if (!WordCount || I + WordCount > In.size())
+      break;
+    bool Skip = false;
+    switch (OC) {
+    case OpLine:
+    case OpNoLine:
+    case OpSourceContinued:
+      Skip = true;
+      break;
+    case OpExtInstImport: {
+      std::vector<SPIRVWord> Name(In.begin() + I + 2,
+                                  In.begin() + I + WordCount);
+      SPIRVExtInstSetKind Set = SPIRVEIS_Count;
+      SPIRVBuiltinSetNameMap::rfind(SPIRV::getString(Name), &Set);
+      if (Set == SPIRVEIS_Debug || Set == SPIRVEIS_OpenCL_DebugInfo_100) {
+        DebugSets.insert(In[I + 1]);
+        Skip = true;
+      }
+      break;
+    }
+    case OpExtInst:
+      Skip = WordCount > 3 && DebugSets.count(In[I + 3]);
+      break;
+    default:
+      break;
+    }
+    if (!Skip) {
+      Out.insert(Out.end(), In.begin() + I, In.begin() + I + WordCount);
+      if (precedesModuleProcessed(OC))
+        MarkerPos = Out.size();
+    }
+    I += WordCount;
+  }
+
+  std::vector<SPIRVWord> MarkerInst = getVec(Marker);
+  MarkerInst.insert(MarkerInst.begin(),
+                    ((MarkerInst.size() + 1) << WordCountShift) |
+                        OpModuleProcessed);
+  Out.insert(Out.begin() + MarkerPos, MarkerInst.begin(), MarkerInst.end());
+}
+
+bool llvm::writeSpirv(Module *M, const SPIRV::TranslatorOpts &Opts,
+                      std::ostream &OS, std::ostream &DebugOS,
+                      std::string &ErrMsg) {
+  if (Opts.isSPIRVTextFormat()) {
+    ErrMsg = "debug info sidecar module requires binary SPIR-V output";
+    return false;
+  }
+  std::ostringstream FullOS;
+  if (!llvm::writeSpirv(M, Opts, FullOS, ErrMsg))
+    return false;
+  const std::string Full = FullOS.str();
+  DebugOS << Full;
+
+  std::vector<SPIRVWord> In(Full.size() / sizeof(SPIRVWord));
+  std::memcpy(In.data(), Full.data(), In.size() * sizeof(SPIRVWord));
+  std::string Marker;
+  raw_string_ostream MarkerOS(Marker);
+  MarkerOS << "debug-sidecar:xxh64:"
+           << format_hex_no_prefix(xxHash64(Full), 16);
+  std::vector<SPIRVWord> Out;
+  stripDebugInstructions(In, MarkerOS.str(), Out);
+  OS.write(reinterpret_cast<const char *>(Out.data()),
+           Out.size() * sizeof(SPIRVWord));
+  return true;
+}
+
+namespace {
+// Collects the global values a set of kernels depends on: the functions
+// they call and the global variables and functions referenced by these,
+// directly or through constants.
+class SplitClosure {
+public:
+  void add(const GlobalValue *GV) {
+    if (Kept.insert(GV).second)
+      Worklist.push_back(GV);
+  }
+
+  void addReferences(const Value *V) {
+    if (auto *GV = dyn_cast<GlobalValue>(V)) {
+      add(GV);
+      return;
+    }
+    auto *C = dyn_cast<Constant>(V);
+    if (!C || !Visited.insert(C).second)
+      return;
+    for (const Value *Op : C->operands())
+      addReferences(Op);
+  }
+
+  void run() {
+    while (!Worklist.empty()) {
+      const GlobalValue *GV = Worklist.pop_back_val();
+      if (auto *F = dyn_cast<Function>(GV)) {
+        for (const Instruction &I : instructions(F))
+          for (const Value *Op : I.operands())
+            addReferences(Op);
+      } else if (auto *Var = dyn_cast<GlobalVariable>(GV)) {
+        if (Var->hasInitializer())
+          addReferences(Var->getInitializer());
+      } else if (auto *GA = dyn_cast<GlobalAlias>(GV)) {
+        addReferences(GA->getAliasee());
+      }
+    }
+  }
+
+  bool contains(const GlobalValue *GV) const { return Kept.count(GV); }
+
+private:
+  SmallPtrSet<const GlobalValue *, 32> Kept;
+  SmallPtrSet<const Constant *, 32> Visited;
+  SmallVector<const GlobalValue *, 32> Worklist;
+};
+} // namespace
+
+// Returns the global value an entry of an appending variable such as
+// llvm.global.annotations or llvm.used is about.
+static const GlobalValue *getAppendingEntryOwner(const Constant *Entry) {
+  if (auto *S = dyn_cast<ConstantStruct>(Entry))
+    Entry = S->getOperand(0);
+  return dyn_cast<GlobalValue>(Entry->stripPointerCasts());
+}
+
+// Copy the part of \p M which \p Kernels depend on into a new module.
+static std::unique_ptr<Module>
+extractKernels(const Module &M, ArrayRef<const Function *> Kernels) {
+  SplitClosure Closure;
+  for (const Function *F : Kernels)
+    Closure.add(F);
+  Closure.run();
+  for (const GlobalVariable &GV : M.globals()) {
+    if (!GV.hasAppendingLinkage() || !GV.hasInitializer())
+      continue;
+    for (const Value *Entry : GV.getInitializer()->operands()) {
+      const GlobalValue *Owner = getAppendingEntryOwner(cast<Constant>(Entry));
+      if (Owner && Closure.contains(Owner))
+        Closure.addReferences(Entry);
+    }
+  }
+  Closure.run();
+
+  ValueToValueMapTy VMap;
+  std::unique_ptr<Module> Split =
+      CloneModule(M, VMap, [&](const GlobalValue *GV) {
+        return Closure.contains(GV) || GV->hasAppendingLinkage();
+      });
+  SmallPtrSet<const GlobalValue *, 32> Kept;
+  SmallVector<GlobalValue *, 32> Dropped;
+  for (const GlobalValue &GV : M.global_values()) {
+    auto *Clone = cast<GlobalValue>(VMap[&GV]);
+    if (Closure.contains(&GV))
+      Kept.insert(Clone);
+    else if (!GV.hasAppendingLinkage())
+      Dropped.push_back(Clone);
+  }
+
+  // Keep only the entries of appending variables about kept globals.
+  for (GlobalVariable &GV : make_early_inc_range(Split->globals())) {
+    if (!GV.hasAppendingLinkage() || !GV.hasInitializer())
+      continue;
+    auto *Init = dyn_cast<ConstantArray>(GV.getInitializer());
+    if (!Init)
+      continue;
+    SmallVector<Constant *, 8> Entries;
+    for (Value *Entry : Init->operands())
+      if (Kept.count(getAppendingEntryOwner(cast<Constant>(Entry))))
+        Entries.push_back(cast<Constant>(Entry));
+    if (Entries.size() == Init->getNumOperands())
+      continue;
+    if (!Entries.empty()) {
+      ArrayType *Ty =
+          ArrayType::get(Init->getType()->getElementType(), Entries.size());
+      auto *NewGV =
+          new GlobalVariable(*Split, Ty, GV.isConstant(), GV.getLinkage(),
+                             ConstantArray::get(Ty, Entries), "", &GV);
+      NewGV->copyAttributesFrom(&GV);
+      NewGV->takeName(&GV);
+    }
+    GV.eraseFromParent();
+  }
+
+  // Drop metadata about the globals which are not kept, such as their
+  // execution modes and debug info.
+  auto IsDropped = [&](const MDOperand &Op) {
+    auto *VM = dyn_cast_or_null<ValueAsMetadata>(Op.get());
+    auto *GV =
+        VM ? dyn_cast<GlobalValue>(VM->getValue()->stripPointerCasts())
+           : nullptr;
+    return GV && !Kept.count(GV);
+  };
+  for (NamedMDNode &NMD : Split->named_metadata()) {
+    SmallVector<MDNode *, 8> Ops;
+    for (MDNode *Op : NMD.operands())
+      if (none_of(Op->operands(), IsDropped))
+        Ops.push_back(Op);
+    if (Ops.size() == NMD.getNumOperands())
+      continue;
+    NMD.clearOperands();
+    for (MDNode *Op : Ops)
+      NMD.addOperand(Op);
+  }
+  SmallPtrSet<const Metadata *, 8> DroppedDbgGlobals;
+  for (GlobalValue *GV : Dropped) {
+    SmallVector<DIGlobalVariableExpression *, 1> GVEs;
+    if (auto *Var = dyn_cast<GlobalVariable>(GV))
+      Var->getDebugInfo(GVEs);
+    DroppedDbgGlobals.insert(GVEs.begin(), GVEs.end());
+  }
+  if (!DroppedDbgGlobals.empty()) {
+    for (DICompileUnit *CU : Split->debug_compile_units()) {
+      SmallVector<Metadata *, 8> Globals;
+      for (DIGlobalVariableExpression *GVE : CU->getGlobalVariables())
+        if (!DroppedDbgGlobals.count(GVE))
+          Globals.push_back(GVE);
+      if (Globals.size() != CU->getGlobalVariables().size())
+        CU->replaceGlobalVariables(
+            MDTuple::get(Split->getContext(), Globals));
+    }
+  }
+
+  for (GlobalValue *GV : Dropped)
+    GV->removeDeadConstantUsers();
+  for (GlobalValue *GV : Dropped)
+    if (GV->use_empty())
+      GV->eraseFromParent();
+  return Split;
+}
+
+bool llvm::writeSpirvSplit(Module *M, const SPIRV::TranslatorOpts &Opts,
+                           SpirvSplitMode Mode, const std::string &Attribute,
+                           std::vector<SpirvSplit> &Splits,
+                           std::string &ErrMsg) {
+  std::unique_ptr<SPIRVModule> BM(SPIRVModule::createSPIRVModule(Opts));
+  if (!isValidLLVMModule(M, BM->getErrorLog()))
+    return false;
+
+  {
+    ManagedVerificationScope Verification;
+    legacy::PassManager PassMgr;
+    SPIRVPassAdder Adder(PassMgr, Opts);
+    addPassesForSPIRV(Adder, Opts);
+    if (hasLoopMetadata(M))
+      Adder.add(createLoopSimplifyPass(), "pass:loop-simplify");
+    if (!Adder.runVerified(*M, ErrMsg))
+      return false;
+    PassMgr.run(*M);
+  }
+
+  std::vector<SpirvSplit> Result;
+  std::vector<std::vector<const Function *>> Groups;
+  StringMap<size_t> GroupIndex;
+  for (const Function &F : *M) {
+    if (F.isDeclaration() || F.getCallingConv() != CallingConv::SPIR_KERNEL)
+      continue;
+    StringRef Name = Mode == SpirvSplitMode::PerKernel
+                         ? F.getName()
+                         : F.getFnAttribute(Attribute).getValueAsString();
+    auto It = GroupIndex.try_emplace(Name, Result.size());
+    if (It.second) {
+      Result.emplace_back();
+      Result.back().Name = Name.str();
+      Groups.emplace_back();
+    }
+    Result[It.first->second].Kernels.push_back(F.getName().str());
+    Groups[It.first->second].push_back(&F);
+  }
+
+  for (size_t I = 0; I < Result.size(); ++I) {
+    std::unique_ptr<Module> Split;
+    {
+      TranslationPhaseTimer Timer("split");
+      Split = extractKernels(*M, Groups[I]);
+    }
+    std::unique_ptr<SPIRVModule> SplitBM(SPIRVModule::createSPIRVModule(Opts));
+    legacy::PassManager PassMgr;
+    PassMgr.add(createLLVMToSPIRVLegacy(SplitBM.get()));
+    PassMgr.run(*Split);
+    if (SplitBM->getError(ErrMsg) != SPIRVEC_Success)
+      return false;
+    std::ostringstream OS;
+    OS << *SplitBM;
+    Result[I].Binary = OS.str();
+  }
+  Splits = std::move(Result);
+  return true;
+}
+
 bool llvm::regularizeLlvmForSpirv(Module *M, std::string &ErrMsg) {
   SPIRV::TranslatorOpts DefaultOpts;
   // To preserve old behavior of the translator, let's enable all extensions
@@ -4091,8 +4623,12 @@ bool llvm::regularizeLlvmForSpirv(Module *M, std::string &ErrMsg,
   if (!isValidLLVMModule(M, BM->getErrorLog()))
     return false;
 
+  ManagedVerificationScope Verification;
   legacy::PassManager PassMgr;
-  addPassesForSPIRV(PassMgr, Opts);
+  SPIRVPassAdder Adder(PassMgr, Opts);
+  addPassesForSPIRV(Adder, Opts);
+  if (!Adder.runVerified(*M, ErrMsg))
+    return false;
   PassMgr.run(*M);
   return true;
 }
@@ -116,6 +116,8 @@ public:
   bool transExecutionMode();
   void transFPContract();
   SPIRVValue *transConstant(Value *V);
+  SPIRVValue *transConstantDataSequential(ConstantDataSequential *CDS);
+  SPIRVValue *getLiteralConstant(SPIRVType *Ty, uint64_t Literal);
   SPIRVValue *transValue(Value *V, SPIRVBasicBlock *BB,
                          bool CreateForward = true,
                          FuncTransMode FuncTrans = FuncTransMode::Decl);
@@ -144,12 +146,18 @@ private:
   SPIRVModule *BM;
   LLVMToSPIRVTypeMap TypeMap;
   LLVMToSPIRVValueMap ValueMap;
+  // Scalar integer and floating-point constants keyed by their SPIR-V type and
+  // literal bits, so elements of data arrays and vectors can be translated
+  // without materializing an LLVM constant for each of them.
+  DenseMap<std::pair<SPIRVType *, uint64_t>, SPIRVValue *> LiteralConstMap;
   LLVMToSPIRVMetadataMap IndexGroupArrayMap;
   SPIRVWord SrcLang;
   SPIRVWord SrcLangVer;
   std::unique_ptr<LLVMToSPIRVDbgTran> DbgTran;
   std::unique_ptr<CallGraph> CG;
   OCLTypeToSPIRVBase *OCLTypeToSPIRVPtr;
+  // Whether each function is encoded and freed once it is translated.
+  bool StreamFunctionBodies = false;
 
   enum class FPContract { UNDEF, DISABLED, ENABLED };
   DenseMap<Function *, FPContract> FPContractMap;
@@ -192,9 +200,10 @@ private:
   bool isKernel(Function *F);
   bool transMetadata();
   bool transOCLMetadata();
-  SPIRVInstruction *transBuiltinToInst(StringRef DemangledName, CallInst *CI,
-                                       SPIRVBasicBlock *BB);
-  SPIRVValue *transBuiltinToConstant(StringRef DemangledName, CallInst *CI);
+  SPIRVInstruction *transBuiltinToInst(Op OC,
+                                       const SmallVectorImpl<std::string> &Dec,
+                                       CallInst *CI, SPIRVBasicBlock *BB);
+  SPIRVValue *transBuiltinToConstant(Op OC, CallInst *CI);
   SPIRVInstruction *transBuiltinToInstWithoutDecoration(Op OC, CallInst *CI,
                                                         SPIRVBasicBlock *BB);
   void mutateFuncArgType(const std::map<unsigned, Type *> &ChangedType,
@@ -80,7 +80,7 @@ SPIRVBasicBlock::addInstruction(SPIRVInstruction *I,
 }
 
 void SPIRVBasicBlock::encodeChildren(spv_ostream &O) const {
-  O << SPIRVNL();
+  getEncoder(O) << SPIRVNL();
   for (size_t I = 0, E = InstVec.size(); I != E; ++I)
     O << *InstVec[I];
 }
@@ -48,9 +48,6 @@
 using namespace SPIRV;
 
 bool SPIRV::SPIRVDbgEnable = false;
-SPIRV::SPIRVDbgErrorHandlingKinds SPIRV::SPIRVDbgError =
-    SPIRVDbgErrorHandlingKinds::Exit;
-bool SPIRV::SPIRVDbgErrorMsgIncludesSourceInfo = true;
 
 namespace SPIRV {
 llvm::cl::opt<bool> VerifyRegularizationPasses(
@@ -58,7 +55,11 @@ llvm::cl::opt<bool> VerifyRegularizationPasses(
     llvm::cl::desc(
         "Verify module after each pass in LLVM regularization phase"));
 
+static thread_local bool VerificationIsManaged = false;
+
 void verifyRegularizationPass(llvm::Module &M, const std::string &PassName) {
+  if (VerificationIsManaged && !VerifyRegularizationPasses.getNumOccurrences())
+    return;
   if (VerifyRegularizationPasses) {
     std::string Err;
     llvm::raw_string_ostream ErrorOS(Err);
@@ -69,4 +70,23 @@ void verifyRegularizationPass(llvm::Module &M, const std::string &PassName) {
     }
   }
 }
+
+bool verifyModuleAfter(llvm::Module &M, const std::string &Stage,
+                       std::string &ErrMsg) {
+  std::string Err;
+  llvm::raw_string_ostream ErrorOS(Err);
+  if (!llvm::verifyModule(M, &ErrorOS))
+    return true;
+  ErrMsg = "Fails to verify module after " + Stage + ": " + ErrorOS.str();
+  return false;
+}
+
+ManagedVerificationScope::ManagedVerificationScope()
+    : Saved(VerificationIsManaged) {
+  VerificationIsManaged = true;
+}
+
+ManagedVerificationScope::~ManagedVerificationScope() {
+  VerificationIsManaged = Saved;
+}
 } // namespace SPIRV
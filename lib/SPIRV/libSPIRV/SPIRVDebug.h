@@ -40,6 +40,7 @@
 #ifndef SPIRV_LIBSPIRV_SPIRVDEBUG_H
 #define SPIRV_LIBSPIRV_SPIRVDEBUG_H
 
+#include "LLVMSPIRVOpts.h"
 #include "SPIRVUtil.h"
 
 #include <iostream>
@@ -51,18 +52,28 @@ class Module;
 
 namespace SPIRV {
 
-// Include source file and line number in error message.
-extern bool SPIRVDbgErrorMsgIncludesSourceInfo;
-
-// Enable assert or exit on error
-enum class SPIRVDbgErrorHandlingKinds { Abort, Exit, Ignore };
-extern SPIRVDbgErrorHandlingKinds SPIRVDbgError;
-
 // Enable debug output.
 extern bool SPIRVDbgEnable;
 
 void verifyRegularizationPass(llvm::Module &, const std::string &);
 
+/// Verifies \p M after \p Stage of a translation.
+/// \returns false and sets \p ErrMsg if \p M is invalid.
+bool verifyModuleAfter(llvm::Module &M, const std::string &Stage,
+                       std::string &ErrMsg);
+
+/// While alive, the translation on the current thread verifies the module
+/// according to its VerificationLevel, so verifyRegularizationPass only
+/// verifies if -spirv-verify-regularize-passes is given explicitly.
+class ManagedVerificationScope {
+public:
+  ManagedVerificationScope();
+  ~ManagedVerificationScope();
+
+private:
+  bool Saved;
+};
+
 #ifndef _SPIRVDBG
 #if !defined(NDEBUG) || defined(_DEBUG)
 #define _SPIRVDBG true
@@ -257,7 +257,7 @@ public:
   static void encodeLiterals(SPIRVEncoder &Encoder,
                              const std::vector<SPIRVWord> &Literals) {
 #ifdef _SPIRV_SUPPORT_TEXT_FMT
-    if (SPIRVUseTextFormat) {
+    if (Encoder.UseTextFormat) {
       Encoder << getString(Literals.cbegin(), Literals.cend() - 1);
       Encoder.OS << " ";
       Encoder << (SPIRVLinkageTypeKind)Literals.back();
@@ -269,7 +269,7 @@ public:
   static void decodeLiterals(SPIRVDecoder &Decoder,
                              std::vector<SPIRVWord> &Literals) {
 #ifdef _SPIRV_SUPPORT_TEXT_FMT
-    if (SPIRVUseTextFormat) {
+    if (Decoder.UseTextFormat) {
       std::string Name;
       Decoder >> Name;
       SPIRVLinkageTypeKind Kind;
@@ -449,7 +449,7 @@ public:
   static void encodeLiterals(SPIRVEncoder &Encoder,
                              const std::vector<SPIRVWord> &Literals) {
 #ifdef _SPIRV_SUPPORT_TEXT_FMT
-    if (SPIRVUseTextFormat) {
+    if (Encoder.UseTextFormat) {
       Encoder << getString(Literals.cbegin(), Literals.cend());
     } else
 #endif
@@ -459,7 +459,7 @@ public:
   static void decodeLiterals(SPIRVDecoder &Decoder,
                              std::vector<SPIRVWord> &Literals) {
 #ifdef _SPIRV_SUPPORT_TEXT_FMT
-    if (SPIRVUseTextFormat) {
+    if (Decoder.UseTextFormat) {
       std::string Str;
       Decoder >> Str;
       std::copy_n(getVec(Str).begin(), Literals.size(), Literals.begin());
@@ -503,7 +503,7 @@ public:
   static void encodeLiterals(SPIRVEncoder &Encoder,
                              const std::vector<SPIRVWord> &Literals) {
 #ifdef _SPIRV_SUPPORT_TEXT_FMT
-    if (SPIRVUseTextFormat) {
+    if (Encoder.UseTextFormat) {
       std::string FirstString = getString(Literals.cbegin(), Literals.cend());
       Encoder << FirstString;
       Encoder.OS << " ";
@@ -517,7 +517,7 @@ public:
   static void decodeLiterals(SPIRVDecoder &Decoder,
                              std::vector<SPIRVWord> &Literals) {
 #ifdef _SPIRV_SUPPORT_TEXT_FMT
-    if (SPIRVUseTextFormat) {
+    if (Decoder.UseTextFormat) {
       std::string Name;
       Decoder >> Name;
       std::string Direction;
@@ -45,6 +45,7 @@
 #include "SPIRVFunction.h"
 #include "SPIRVInstruction.h"
 #include "SPIRVMemAliasingINTEL.h"
+#include "SPIRVStats.h"
 #include "SPIRVStream.h"
 #include "SPIRVType.h"
 
@@ -123,7 +124,7 @@ SPIRVType *SPIRVEntry::getValueType(SPIRVId TheId) const {
 }
 
 SPIRVEncoder SPIRVEntry::getEncoder(spv_ostream &O) const {
-  return SPIRVEncoder(O);
+  return SPIRVEncoder(O, Module && Module->isTextFormat());
 }
 
 SPIRVDecoder SPIRVEntry::getDecoder(std::istream &I) {
@@ -185,6 +186,11 @@ void SPIRVEntry::encodeLine(spv_ostream &O) const {
 
 void SPIRVEntry::encodeAll(spv_ostream &O) const {
   encodeLine(O);
+  SPIRV_TRACE(*Module, Encode, OpCode, hasId() ? Id : SPIRVID_INVALID,
+              Module->getTraceBuffer().advance(SPIRVTracePhase::Encode,
+                                               WordCount));
+  if (TranslationStats *Stats = getActiveTranslationStats())
+    ++Stats->Instructions;
   encodeWordCountOpCode(O);
   encode(O);
   encodeChildren(O);
@@ -193,15 +199,16 @@ void SPIRVEntry::encodeAll(spv_ostream &O) const {
 void SPIRVEntry::encodeChildren(spv_ostream &O) const {}
 
 void SPIRVEntry::encodeWordCountOpCode(spv_ostream &O) const {
+  SPIRVEncoder Encoder = getEncoder(O);
 #ifdef _SPIRV_SUPPORT_TEXT_FMT
-  if (SPIRVUseTextFormat) {
-    getEncoder(O) << WordCount << OpCode;
+  if (Encoder.UseTextFormat) {
+    Encoder << WordCount << OpCode;
     return;
   }
 #endif
   assert(WordCount < 65536 && "WordCount must fit into 16-bit value");
   SPIRVWord WordCountOpCode = (WordCount << WordCountShift) | OpCode;
-  getEncoder(O) << WordCountOpCode;
+  Encoder << WordCountOpCode;
 }
 // Read words from SPIRV binary and create members for SPIRVEntry.
 // The word count and op code has already been read before calling this
@@ -519,7 +526,7 @@ void SPIRVEntry::updateModuleVersion() const {
 spv_ostream &operator<<(spv_ostream &O, const SPIRVEntry &E) {
   E.validate();
   E.encodeAll(O);
-  O << SPIRVNL();
+  E.getEncoder(O) << SPIRVNL();
   return O;
 }
 
@@ -44,6 +44,7 @@
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <type_traits>
 
 namespace SPIRV {
 
@@ -52,27 +53,30 @@ namespace SPIRV {
 // Emit absolute path only in debug mode.
 #ifdef NDEBUG
 #define SPIRVCK(Condition, ErrCode, ErrMsg)                                    \
-  getErrorLog().checkError(Condition, SPIRVEC_##ErrCode,                       \
-                           std::string() + (ErrMsg), #Condition)
+  getErrorLog().checkError(                                                    \
+      Condition, SPIRVEC_##ErrCode,                                            \
+      [&] { return std::string() + (ErrMsg); }, #Condition)
 #else
 #define SPIRVCK(Condition, ErrCode, ErrMsg)                                    \
-  getErrorLog().checkError(Condition, SPIRVEC_##ErrCode,                       \
-                           std::string() + (ErrMsg), #Condition, __FILE__,     \
-                           __LINE__)
+  getErrorLog().checkError(                                                    \
+      Condition, SPIRVEC_##ErrCode,                                            \
+      [&] { return std::string() + (ErrMsg); }, #Condition, __FILE__, __LINE__)
 #endif // NDEBUG
 
 // Check condition and set error code and error msg. If fail returns false.
 // Emit absolute path only in debug mode.
 #ifdef NDEBUG
 #define SPIRVCKRT(Condition, ErrCode, ErrMsg)                                  \
-  if (!getErrorLog().checkError(Condition, SPIRVEC_##ErrCode,                  \
-                                std::string() + (ErrMsg), #Condition))         \
+  if (!getErrorLog().checkError(                                               \
+          Condition, SPIRVEC_##ErrCode,                                        \
+          [&] { return std::string() + (ErrMsg); }, #Condition))               \
     return false;
 #else
 #define SPIRVCKRT(Condition, ErrCode, ErrMsg)                                  \
-  if (!getErrorLog().checkError(Condition, SPIRVEC_##ErrCode,                  \
-                                std::string() + (ErrMsg), #Condition,          \
-                                __FILE__, __LINE__))                           \
+  if (!getErrorLog().checkError(                                               \
+          Condition, SPIRVEC_##ErrCode,                                        \
+          [&] { return std::string() + (ErrMsg); }, #Condition, __FILE__,      \
+          __LINE__))                                                           \
     return false;
 #endif // NDEBUG
 
@@ -94,7 +98,10 @@ typedef SPIRVMap<SPIRVErrorCode, std::string> SPIRVErrorMap;
 
 class SPIRVErrorLog {
 public:
-  SPIRVErrorLog() : ErrorCode(SPIRVEC_Success) {}
+  SPIRVErrorLog()
+      : ErrorCode(SPIRVEC_Success),
+        ErrorHandling(SPIRVDbgErrorHandlingKinds::Exit),
+        MsgIncludesSourceInfo(true) {}
   SPIRVErrorCode getError(std::string &ErrMsg) {
     ErrMsg = ErrorMsg;
     return ErrorCode;
@@ -103,33 +110,57 @@ public:
     ErrorCode = ErrCode;
     ErrorMsg = ErrMsg;
   }
+  void setErrorHandling(SPIRVDbgErrorHandlingKinds Kind) {
+    ErrorHandling = Kind;
+  }
+  void setMsgIncludesSourceInfo(bool Include) {
+    MsgIncludesSourceInfo = Include;
+  }
   // Check if Condition is satisfied and set ErrCode and DetailedMsg
   // if not. Returns true if no error.
   bool checkError(bool Condition, SPIRVErrorCode ErrCode,
                   const std::string &DetailedMsg = "",
                   const char *CondString = nullptr,
                   const char *FileName = nullptr, unsigned LineNumber = 0);
+  // Same as above, but the detailed message is built by calling MsgBuilder
+  // only if Condition is not satisfied. Use it on hot paths to avoid
+  // formatting messages which are thrown away.
+  template <typename MsgBuilderTy,
+            typename = typename std::enable_if<
+                !std::is_convertible<MsgBuilderTy, std::string>::value>::type>
+  bool checkError(bool Condition, SPIRVErrorCode ErrCode,
+                  MsgBuilderTy &&MsgBuilder, const char *CondString = nullptr,
+                  const char *FileName = nullptr, unsigned LineNumber = 0) {
+    if (Condition)
+      return Condition;
+    return checkError(Condition, ErrCode, std::string(MsgBuilder()),
+                      CondString, FileName, LineNumber);
+  }
 
 protected:
   SPIRVErrorCode ErrorCode;
   std::string ErrorMsg;
+  // Enable assert or exit on error
+  SPIRVDbgErrorHandlingKinds ErrorHandling;
+  // Include source file and line number in error message.
+  bool MsgIncludesSourceInfo;
 };
 
 inline bool SPIRVErrorLog::checkError(bool Cond, SPIRVErrorCode ErrCode,
                                       const std::string &Msg,
                                       const char *CondString,
                                       const char *FileName, unsigned LineNo) {
-  std::stringstream SS;
   if (Cond)
     return Cond;
   // Do not overwrite previous failure.
   if (ErrorCode != SPIRVEC_Success)
     return Cond;
+  std::stringstream SS;
   SS << SPIRVErrorMap::map(ErrCode) << " " << Msg;
-  if (SPIRVDbgErrorMsgIncludesSourceInfo && FileName)
+  if (MsgIncludesSourceInfo && FileName)
     SS << " [Src: " << FileName << ":" << LineNo << " " << CondString << " ]";
   setError(ErrCode, SS.str());
-  switch (SPIRVDbgError) {
+  switch (ErrorHandling) {
   case SPIRVDbgErrorHandlingKinds::Abort:
     std::cerr << SS.str() << std::endl;
     abort();
@@ -40,6 +40,7 @@
 #include "SPIRVBasicBlock.h"
 #include "SPIRVEntry.h"
 #include "SPIRVInstruction.h"
+#include "SPIRVStats.h"
 #include "SPIRVStream.h"
 
 #include <algorithm>
@@ -75,13 +76,16 @@ void SPIRVFunction::encode(spv_ostream &O) const {
 }
 
 void SPIRVFunction::encodeChildren(spv_ostream &O) const {
-  O << SPIRVNL();
+  getEncoder(O) << SPIRVNL();
   for (auto &I : Parameters)
     O << *I;
-  O << SPIRVNL();
+  getEncoder(O) << SPIRVNL();
   for (auto &I : BBVec)
     O << *I;
-  O << SPIRVFunctionEnd();
+  // The module decides whether the instruction is written as text.
+  SPIRVFunctionEnd End;
+  End.setModule(Module);
+  O << End;
 }
 
 void SPIRVFunction::encodeExecutionModes(spv_ostream &O) const {
@@ -97,8 +101,12 @@ void SPIRVFunction::decode(std::istream &I) {
 
   Decoder.getWordCountAndOpCode();
   while (!I.eof()) {
-    if (Decoder.OpCode == OpFunctionEnd)
+    if (Decoder.OpCode == OpFunctionEnd) {
+      // OpFunctionEnd has no entry, so the decoder does not count it.
+      if (TranslationStats *Stats = getActiveTranslationStats())
+        ++Stats->Instructions;
       break;
+    }
 
     switch (Decoder.OpCode) {
     case OpFunctionParameter: {
@@ -141,15 +149,18 @@ bool SPIRVFunction::decodeBB(SPIRVDecoder &Decoder) {
     }
 
     SPIRVEntry *Entry = Decoder.getEntry();
+    // Debug instructions are skipped if the module doesn't read debug info.
+    if (!Entry)
+      continue;
 
     if (Decoder.OpCode == OpLine) {
       Module->add(Entry);
       continue;
     }
 
-    if (!Module->getErrorLog().checkError(Entry->isImplemented(),
-                                          SPIRVEC_UnimplementedOpCode,
-                                          std::to_string(Entry->getOpCode()))) {
+    if (!Module->getErrorLog().checkError(
+            Entry->isImplemented(), SPIRVEC_UnimplementedOpCode,
+            [&] { return std::to_string(Entry->getOpCode()); })) {
       // Bail out if the opcode is not implemented.
       Module->setInvalid();
       return false;
@@ -136,6 +136,9 @@ public:
     return BB;
   }
 
+  // Forget the basic blocks once the module has encoded and freed them.
+  void clearBasicBlocks() { BBVec.clear(); }
+
   void encodeChildren(spv_ostream &) const override;
   void encodeExecutionModes(spv_ostream &) const;
   _SPIRV_DCL_ENCDEC
@@ -46,6 +46,7 @@
 #include "SPIRVInstruction.h"
 #include "SPIRVMemAliasingINTEL.h"
 #include "SPIRVNameMapEnum.h"
+#include "SPIRVStats.h"
 #include "SPIRVStream.h"
 #include "SPIRVType.h"
 #include "SPIRVValue.h"
@@ -53,6 +54,7 @@
 #include "llvm/ADT/APInt.h"
 
 #include <set>
+#include <sstream>
 #include <unordered_map>
 #include <unordered_set>
 
@@ -79,6 +81,8 @@ public:
 
   SPIRVModuleImpl(const SPIRV::TranslatorOpts &Opts) : SPIRVModuleImpl() {
     TranslationOpts = Opts;
+    ErrLog.setErrorHandling(Opts.getErrorHandling());
+    ErrLog.setMsgIncludesSourceInfo(Opts.isErrorMsgSourceInfoEnabled());
   }
 
   ~SPIRVModuleImpl() override;
@@ -98,6 +102,7 @@ public:
   SPIRVErrorCode getError(std::string &ErrMsg) override {
     return ErrLog.getError(ErrMsg);
   }
+  SPIRVTraceBuffer &getTraceBuffer() override { return TraceBuffer; }
   bool checkExtension(ExtensionID Ext, SPIRVErrorCode ErrCode,
                       const std::string &Msg) override {
     if (ErrLog.checkError(isAllowedToUseExtension(Ext), ErrCode, Msg))
@@ -222,6 +227,7 @@ public:
   SPIRVFunction *addFunction(SPIRVTypeFunction *, SPIRVId) override;
   SPIRVEntry *replaceForward(SPIRVForward *, SPIRVEntry *) override;
   void eraseInstruction(SPIRVInstruction *, SPIRVBasicBlock *) override;
+  void streamFunction(SPIRVFunction *) override;
 
   // Type creation functions
   template <class T> T *addType(T *Ty);
@@ -458,12 +464,16 @@ public:
 
   virtual SPIRVId getExtInstSetId(SPIRVExtInstSetKind Kind) const override;
 
+  // Write the words of \p F if it was encoded by streamFunction.
+  bool writeStreamedFunction(spv_ostream &O, const SPIRVFunction *F) const;
+
   // I/O functions
   friend spv_ostream &operator<<(spv_ostream &O, SPIRVModule &M);
   friend std::istream &operator>>(std::istream &I, SPIRVModule &M);
 
 private:
   SPIRVErrorLog ErrLog;
+  SPIRVTraceBuffer TraceBuffer;
   SPIRVId NextId;
   SPIRVWord SPIRVVersion;
   unsigned short GeneratorId;
@@ -531,11 +541,21 @@ private:
   std::vector<SPIRVModuleProcessed *> ModuleProcessedVec;
   SPIRVAliasInstMDVec AliasInstMDVec;
   SPIRVAliasInstMDMap AliasInstMDMap;
+  // Words of the functions encoded by streamFunction, and of the OpName
+  // instructions of the entries it freed.
+  std::unordered_map<const SPIRVFunction *, std::string> StreamedFuncMap;
+  std::unordered_map<SPIRVId, std::string> StreamedNameMap;
 
   void layoutEntry(SPIRVEntry *Entry);
 };
 
 SPIRVModuleImpl::~SPIRVModuleImpl() {
+#ifdef LLVM_SPIRV_ENABLE_TRACE
+  if (std::ostream *OS = getSpirvTraceStream())
+    if (TraceBuffer.getNumRecorded())
+      TraceBuffer.dumpJSON(*OS);
+#endif
+
   for (auto I : EntryNoId)
     delete I;
 
@@ -1048,6 +1068,48 @@ void SPIRVModuleImpl::eraseInstruction(SPIRVInstruction *I,
   delete I;
 }
 
+void SPIRVModuleImpl::streamFunction(SPIRVFunction *F) {
+  // The function is encoded starting with no current line, like the first
+  // function of the module.
+  std::shared_ptr<const SPIRVLine> Line = std::move(CurrentLine);
+  std::ostringstream OS;
+  OS << *F;
+  CurrentLine = std::move(Line);
+  StreamedFuncMap[F] = OS.str();
+
+  auto Free = [&](SPIRVEntry *E) {
+    if (!E->hasId()) {
+      EntryNoId.erase(E);
+      delete E;
+      return;
+    }
+    SPIRVId Id = E->getId();
+    if (NamedId.count(Id)) {
+      std::ostringstream NameOS;
+      E->encodeName(NameOS);
+      StreamedNameMap[Id] = NameOS.str();
+    }
+    IdEntryMap.erase(Id);
+    delete E;
+  };
+  for (size_t I = 0, E = F->getNumBasicBlock(); I != E; ++I) {
+    SPIRVBasicBlock *BB = F->getBasicBlock(I);
+    for (size_t J = 0, JE = BB->getNumInst(); J != JE; ++J)
+      Free(BB->getInst(J));
+    Free(BB);
+  }
+  F->clearBasicBlocks();
+}
+
+bool SPIRVModuleImpl::writeStreamedFunction(spv_ostream &O,
+                                            const SPIRVFunction *F) const {
+  auto Loc = StreamedFuncMap.find(F);
+  if (Loc == StreamedFuncMap.end())
+    return false;
+  O.write(Loc->second.data(), Loc->second.size());
+  return true;
+}
+
 SPIRVValue *SPIRVModuleImpl::addConstant(SPIRVValue *C) { return add(C); }
 
 SPIRVValue *SPIRVModuleImpl::addConstant(SPIRVType *Ty, uint64_t V) {
@@ -1769,17 +1831,33 @@ spv_ostream &operator<<(spv_ostream &O, const TopologicalSort &S) {
   return O;
 }
 
+// Add the sizes of a module to the stats collected on this thread, if any.
+static void addModuleCounters(SPIRVId Bound, size_t NumTypes,
+                              size_t NumConstants) {
+  TranslationStats *Stats = getActiveTranslationStats();
+  if (!Stats)
+    return;
+  Stats->Ids += Bound;
+  Stats->Types += NumTypes;
+  Stats->Constants += NumConstants;
+}
+
 spv_ostream &operator<<(spv_ostream &O, SPIRVModule &M) {
+  TranslationPhaseTimer Timer("encode");
   SPIRVModuleImpl &MI = *static_cast<SPIRVModuleImpl *>(&M);
+  addModuleCounters(MI.NextId, MI.TypeVec.size(), MI.ConstVec.size());
   // Start tracking of the current line with no line
   MI.CurrentLine.reset();
+#ifdef LLVM_SPIRV_ENABLE_TRACE
+  MI.TraceBuffer.rewind(SPIRVTracePhase::Encode, SPIRVTraceBuffer::HeaderWords);
+#endif
 
-  SPIRVEncoder Encoder(O);
+  SPIRVEncoder Encoder(O, M.isTextFormat());
   Encoder << MagicNumber << MI.SPIRVVersion
           << (((SPIRVWord)MI.GeneratorId << 16) | MI.GeneratorVer)
           << MI.NextId /* Bound for Id */
           << MI.InstSchema;
-  O << SPIRVNL();
+  Encoder << SPIRVNL();
 
   for (auto &I : MI.CapMap)
     O << *I.second;
@@ -1820,25 +1898,43 @@ spv_ostream &operator<<(spv_ostream &O, SPIRVModule &M) {
         IsEntryPoint = true;
         break;
       }
-    if (!IsEntryPoint)
+    if (IsEntryPoint)
+      continue;
+    auto Streamed = MI.StreamedNameMap.find(I);
+    if (Streamed != MI.StreamedNameMap.end())
+      O.write(Streamed->second.data(), Streamed->second.size());
+    else
       M.getEntry(I)->encodeName(O);
   }
 
   if (M.isAllowedToUseExtension(
         ExtensionID::SPV_INTEL_memory_access_aliasing)) {
-    O << SPIRVNL() << MI.AliasInstMDVec;
+    Encoder << SPIRVNL();
+    O << MI.AliasInstMDVec;
   }
 
   O << MI.MemberNameVec << MI.ModuleProcessedVec << MI.DecGroupVec
-    << MI.DecorateSet << MI.GroupDecVec << MI.ForwardPointerVec
-    << TopologicalSort(MI.TypeVec, MI.ConstVec, MI.VariableVec,
-                       MI.ForwardPointerVec);
+    << MI.DecorateSet << MI.GroupDecVec << MI.ForwardPointerVec;
+
+  std::unique_ptr<TopologicalSort> Sorted;
+  {
+    TranslationPhaseTimer SortTimer("topological-sort");
+    Sorted.reset(new TopologicalSort(MI.TypeVec, MI.ConstVec, MI.VariableVec,
+                                     MI.ForwardPointerVec));
+  }
+  O << *Sorted;
 
   if (M.isAllowedToUseExtension(ExtensionID::SPV_INTEL_inline_assembly)) {
-    O << SPIRVNL() << MI.AsmTargetVec << MI.AsmVec;
+    Encoder << SPIRVNL();
+    O << MI.AsmTargetVec << MI.AsmVec;
   }
 
-  O << SPIRVNL() << MI.DebugInstVec << SPIRVNL() << MI.FuncVec;
+  Encoder << SPIRVNL();
+  O << MI.DebugInstVec;
+  Encoder << SPIRVNL();
+  for (SPIRVFunction *F : MI.FuncVec)
+    if (!MI.writeStreamedFunction(O, F))
+      O << *F;
   return O;
 }
 
@@ -1935,6 +2031,7 @@ static std::string to_string(VersionNumber Version) {
 }
 
 std::istream &operator>>(std::istream &I, SPIRVModule &M) {
+  TranslationPhaseTimer Timer("decode");
   SPIRVDecoder Decoder(I, M);
   SPIRVModuleImpl &MI = *static_cast<SPIRVModuleImpl *>(&M);
   // Disable automatic capability filling.
@@ -1990,6 +2087,9 @@ std::istream &operator>>(std::istream &I, SPIRVModule &M) {
     return I;
   }
 
+#ifdef LLVM_SPIRV_ENABLE_TRACE
+  MI.TraceBuffer.rewind(SPIRVTracePhase::Decode, SPIRVTraceBuffer::HeaderWords);
+#endif
   while (Decoder.getWordCountAndOpCode() && M.isModuleValid()) {
     SPIRVEntry *Entry = Decoder.getEntry();
     if (Entry != nullptr)
@@ -1998,6 +2098,7 @@ std::istream &operator>>(std::istream &I, SPIRVModule &M) {
 
   MI.resolveUnknownStructFields();
   MI.createForwardPointers();
+  addModuleCounters(MI.NextId, MI.TypeVec.size(), MI.ConstVec.size());
   return I;
 }
 
@@ -2084,8 +2185,6 @@ bool isSpirvBinary(const std::string &Img) {
 
 bool convertSpirv(std::istream &IS, std::ostream &OS, std::string &ErrMsg,
                   bool FromText, bool ToText) {
-  auto SaveOpt = SPIRVUseTextFormat;
-  SPIRVUseTextFormat = FromText;
   // Conversion from/to SPIR-V text representation is a side feature of the
   // translator which is mostly intended for debug usage. So, this step cannot
   // be customized to enable/disable particular extensions or restrict/allow
@@ -2093,19 +2192,15 @@ bool convertSpirv(std::istream &IS, std::ostream &OS, std::string &ErrMsg,
   // known SPIR-V extensions are enabled during this conversion
   SPIRV::TranslatorOpts DefaultOpts;
   DefaultOpts.enableAllExtensions();
+  DefaultOpts.setSPIRVTextFormat(FromText);
   SPIRVModuleImpl M(DefaultOpts);
   IS >> M;
-  if (M.getError(ErrMsg) != SPIRVEC_Success) {
-    SPIRVUseTextFormat = SaveOpt;
+  if (M.getError(ErrMsg) != SPIRVEC_Success)
     return false;
-  }
-  SPIRVUseTextFormat = ToText;
+  M.setTextFormat(ToText);
   OS << M;
-  if (M.getError(ErrMsg) != SPIRVEC_Success) {
-    SPIRVUseTextFormat = SaveOpt;
+  if (M.getError(ErrMsg) != SPIRVEC_Success)
     return false;
-  }
-  SPIRVUseTextFormat = SaveOpt;
   return true;
 }
 
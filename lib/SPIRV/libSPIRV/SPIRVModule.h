@@ -42,6 +42,7 @@
 
 #include "LLVMSPIRVOpts.h"
 #include "SPIRVEntry.h"
+#include "SPIRVTrace.h"
 
 #include "llvm/IR/Metadata.h"
 
@@ -126,6 +127,11 @@ public:
   void setInvalid() { IsValid = false; }
   bool isModuleValid() { return IsValid; }
 
+  // Tracing functions
+  // Events are recorded only if the library is built with
+  // LLVM_SPIRV_ENABLE_TRACE, otherwise the buffer stays empty.
+  virtual SPIRVTraceBuffer &getTraceBuffer() = 0;
+
   // Module query functions
   virtual SPIRVAddressingModelKind getAddressingModel() = 0;
   virtual const SPIRVCapMap &getCapability() const = 0;
@@ -218,6 +224,10 @@ public:
                                      SPIRVId Id = SPIRVID_INVALID) = 0;
   virtual SPIRVEntry *replaceForward(SPIRVForward *, SPIRVEntry *) = 0;
   virtual void eraseInstruction(SPIRVInstruction *, SPIRVBasicBlock *) = 0;
+  // Encode a complete function for the function section of the module and
+  // free its basic blocks and instructions. The function must not change
+  // afterwards.
+  virtual void streamFunction(SPIRVFunction *) = 0;
 
   // Type creation functions
   virtual SPIRVTypeArray *addArrayType(SPIRVType *, SPIRVConstant *) = 0;
@@ -528,6 +538,19 @@ public:
     return TranslationOpts.getDesiredBIsRepresentation();
   }
 
+  bool shouldSkipDebugInfo() const {
+    return TranslationOpts.shouldSkipDebugInfo();
+  }
+
+  bool shouldStreamFunctionBodies() const {
+    return TranslationOpts.shouldStreamFunctionBodies();
+  }
+
+  // Whether the module is read and written in the internal textual format.
+  bool isTextFormat() const { return TranslationOpts.isSPIRVTextFormat(); }
+
+  void setTextFormat(bool Text) { TranslationOpts.setSPIRVTextFormat(Text); }
+
   // I/O functions
   friend spv_ostream &operator<<(spv_ostream &O, SPIRVModule &M);
   friend std::istream &operator>>(std::istream &I, SPIRVModule &M);
@@ -546,14 +569,10 @@ private:
 #ifdef _SPIRV_SUPPORT_TEXT_FMT
 
 /// Convert SPIR-V between binary and internel text formats.
-/// This function is not thread safe and should not be used in multi-thread
-/// applications unless guarded by a critical section.
 bool ConvertSPIRV(std::istream &IS, spv_ostream &OS, std::string &ErrMsg,
                   bool FromText, bool ToText);
 
 /// Convert SPIR-V between binary and internel text formats.
-/// This function is not thread safe and should not be used in multi-thread
-/// applications unless guarded by a critical section.
 bool ConvertSPIRV(std::string &Input, std::string &Out, std::string &ErrMsg,
                   bool ToText);
 #endif
@@ -0,0 +1,108 @@
+//===- SPIRVStats.cpp - SPIR-V Translation Statistics -----------*- C++ -*-===//
+//
+//                     The LLVM/SPIRV Translator
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+// Copyright (c) 2021 Intel Corporation. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal with the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimers.
+// Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimers in the documentation
+// and/or other materials provided with the distribution.
+// Neither the names of Advanced Micro Devices, Inc., nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// Software without specific prior written permission.
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH
+// THE SOFTWARE.
+//
+//===----------------------------------------------------------------------===//
+/// \file
+///
+/// This file implements TranslationStats and the helpers collecting them.
+///
+//===----------------------------------------------------------------------===//
+
+#include "SPIRVStats.h"
+
+#include <algorithm>
+
+namespace SPIRV {
+
+// Stats of the translation running on this thread, if any.
+static thread_local TranslationStats *ActiveStats = nullptr;
+
+TranslationStats *getActiveTranslationStats() { return ActiveStats; }
+
+TranslationStatsScope::TranslationStatsScope(TranslationStats *Stats)
+    : Saved(ActiveStats) {
+  ActiveStats = Stats;
+}
+
+TranslationStatsScope::~TranslationStatsScope() { ActiveStats = Saved; }
+
+TranslationPhaseTimer::TranslationPhaseTimer(const char *Name)
+    : Stats(ActiveStats), Name(Name) {
+  if (Stats)
+    Start = std::chrono::steady_clock::now();
+}
+
+TranslationPhaseTimer::~TranslationPhaseTimer() {
+  if (!Stats)
+    return;
+  std::chrono::duration<double> Elapsed =
+      std::chrono::steady_clock::now() - Start;
+  Stats->addPhase(Name, Elapsed.count());
+}
+
+void TranslationStats::addPhase(const std::string &Name, double Seconds) {
+  auto Loc = std::find_if(
+      PhaseSeconds.begin(), PhaseSeconds.end(),
+      [&](const std::pair<std::string, double> &P) { return P.first == Name; });
+  if (Loc != PhaseSeconds.end())
+    Loc->second += Seconds;
+  else
+    PhaseSeconds.emplace_back(Name, Seconds);
+}
+
+double TranslationStats::getPhaseSeconds(const std::string &Name) const {
+  for (const auto &P : PhaseSeconds)
+    if (P.first == Name)
+      return P.second;
+  return 0;
+}
+
+void TranslationStats::dumpJSON(std::ostream &OS) const {
+  OS << "{\"phases\":{";
+  bool First = true;
+  for (const auto &P : PhaseSeconds) {
+    if (!First)
+      OS << ',';
+    First = false;
+    // Phase names are fixed identifiers, so they need no escaping.
+    OS << '"' << P.first << "\":" << P.second;
+  }
+  OS << "},\"counters\":{\"instructions\":" << Instructions
+     << ",\"ids\":" << Ids << ",\"types\":" << Types
+     << ",\"constants\":" << Constants
+     << ",\"builtin_name_hits\":" << BuiltinNameHits
+     << ",\"builtin_name_misses\":" << BuiltinNameMisses
+     << ",\"bytes_in\":" << BytesIn << ",\"bytes_out\":" << BytesOut
+     << "}}\n";
+}
+
+} // namespace SPIRV
@@ -0,0 +1,78 @@
+//===- SPIRVStats.h - SPIR-V Translation Statistics -------------*- C++ -*-===//
+//
+//                     The LLVM/SPIRV Translator
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+// Copyright (c) 2021 Intel Corporation. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal with the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimers.
+// Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimers in the documentation
+// and/or other materials provided with the distribution.
+// Neither the names of Advanced Micro Devices, Inc., nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// Software without specific prior written permission.
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH
+// THE SOFTWARE.
+//
+//===----------------------------------------------------------------------===//
+/// \file
+///
+/// This file declares helpers collecting TranslationStats for the
+/// translation running on the current thread.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef SPIRV_LIBSPIRV_SPIRVSTATS_H
+#define SPIRV_LIBSPIRV_SPIRVSTATS_H
+
+#include "LLVMSPIRVLib.h"
+
+#include <chrono>
+
+namespace SPIRV {
+
+/// \returns stats collected on the current thread, null if there are none.
+TranslationStats *getActiveTranslationStats();
+
+/// While alive, makes translations on the current thread add to \p Stats.
+class TranslationStatsScope {
+public:
+  explicit TranslationStatsScope(TranslationStats *Stats);
+  ~TranslationStatsScope();
+
+private:
+  TranslationStats *Saved;
+};
+
+/// Adds the time from construction to destruction to phase \p Name of the
+/// active stats. Does nothing if no stats are collected.
+class TranslationPhaseTimer {
+public:
+  explicit TranslationPhaseTimer(const char *Name);
+  ~TranslationPhaseTimer();
+
+private:
+  TranslationStats *Stats;
+  const char *Name;
+  std::chrono::steady_clock::time_point Start;
+};
+
+} // namespace SPIRV
+
+#endif // SPIRV_LIBSPIRV_SPIRVSTATS_H
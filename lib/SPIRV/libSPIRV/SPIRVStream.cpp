@@ -41,6 +41,7 @@
 #include "SPIRVFunction.h"
 #include "SPIRVNameMapEnum.h"
 #include "SPIRVOpCode.h"
+#include "SPIRVStats.h"
 
 #include <limits> // std::numeric_limits
 
@@ -80,17 +81,17 @@ static void readQuotedString(std::istream &IS, std::string &Str) {
   }
 }
 
-#ifdef _SPIRV_SUPPORT_TEXT_FMT
-bool SPIRVUseTextFormat = false;
-#endif
+SPIRVDecoder::SPIRVDecoder(std::istream &InputStream, SPIRVModule &Module)
+    : IS(InputStream), M(Module), WordCount(0), OpCode(OpNop), Scope(NULL),
+      WordOffset(0), UseTextFormat(Module.isTextFormat()) {}
 
 SPIRVDecoder::SPIRVDecoder(std::istream &InputStream, SPIRVFunction &F)
     : IS(InputStream), M(*F.getModule()), WordCount(0), OpCode(OpNop),
-      Scope(&F) {}
+      Scope(&F), WordOffset(0), UseTextFormat(M.isTextFormat()) {}
 
 SPIRVDecoder::SPIRVDecoder(std::istream &InputStream, SPIRVBasicBlock &BB)
     : IS(InputStream), M(*BB.getModule()), WordCount(0), OpCode(OpNop),
-      Scope(&BB) {}
+      Scope(&BB), WordOffset(0), UseTextFormat(M.isTextFormat()) {}
 
 void SPIRVDecoder::setScope(SPIRVEntry *TheScope) {
   assert(TheScope && (TheScope->getOpCode() == OpFunction ||
@@ -100,7 +101,7 @@ void SPIRVDecoder::setScope(SPIRVEntry *TheScope) {
 
 template <class T> const SPIRVDecoder &decode(const SPIRVDecoder &I, T &V) {
 #ifdef _SPIRV_SUPPORT_TEXT_FMT
-  if (SPIRVUseTextFormat) {
+  if (I.UseTextFormat) {
     std::string W;
     I.IS >> W;
     V = getNameMap(V).rmap(W);
@@ -113,7 +114,7 @@ template <class T> const SPIRVDecoder &decode(const SPIRVDecoder &I, T &V) {
 
 template <class T> const SPIRVEncoder &encode(const SPIRVEncoder &O, T V) {
 #ifdef _SPIRV_SUPPORT_TEXT_FMT
-  if (SPIRVUseTextFormat) {
+  if (O.UseTextFormat) {
     O.OS << getNameMap(V).map(V) << " ";
     return O;
   }
@@ -140,7 +141,7 @@ SPIRV_DEF_ENCDEC(LinkageType)
 // words.
 const SPIRVDecoder &operator>>(const SPIRVDecoder &I, std::string &Str) {
 #ifdef _SPIRV_SUPPORT_TEXT_FMT
-  if (SPIRVUseTextFormat) {
+  if (I.UseTextFormat) {
     readQuotedString(I.IS, Str);
     SPIRVDBG(spvdbgs() << "Read string: \"" << Str << "\"\n");
     return I;
@@ -167,7 +168,7 @@ const SPIRVDecoder &operator>>(const SPIRVDecoder &I, std::string &Str) {
 // words.
 const SPIRVEncoder &operator<<(const SPIRVEncoder &O, const std::string &Str) {
 #ifdef _SPIRV_SUPPORT_TEXT_FMT
-  if (SPIRVUseTextFormat) {
+  if (O.UseTextFormat) {
     writeQuotedString(O.OS, Str);
     return O;
   }
@@ -189,7 +190,7 @@ bool SPIRVDecoder::getWordCountAndOpCode() {
     return false;
   }
 #ifdef _SPIRV_SUPPORT_TEXT_FMT
-  if (SPIRVUseTextFormat) {
+  if (UseTextFormat) {
     *this >> WordCount;
     assert(!IS.bad() && "SPIRV stream is bad");
     if (IS.fail()) {
@@ -217,6 +218,9 @@ bool SPIRVDecoder::getWordCountAndOpCode() {
                        << WordCount << " " << OpCode << '\n');
     return false;
   }
+#ifdef LLVM_SPIRV_ENABLE_TRACE
+  WordOffset = M.getTraceBuffer().advance(SPIRVTracePhase::Decode, WordCount);
+#endif
   SPIRVDBG(spvdbgs() << "[SPIRVDecoder] getWordCountAndOpCode " << WordCount
                      << " " << OpCodeNameMap::map(OpCode) << '\n');
   return true;
@@ -225,6 +229,8 @@ bool SPIRVDecoder::getWordCountAndOpCode() {
 SPIRVEntry *SPIRVDecoder::getEntry() {
   if (WordCount == 0 || OpCode == OpNop)
     return nullptr;
+  if (M.shouldSkipDebugInfo() && skipDebugInstruction())
+    return nullptr;
   SPIRVEntry *Entry = SPIRVEntry::create(OpCode);
   assert(Entry);
   Entry->setModule(&M);
@@ -235,6 +241,10 @@ SPIRVEntry *SPIRVDecoder::getEntry() {
   if (OpCode != OpLine)
     Entry->setLine(M.getCurrentLine());
   IS >> *Entry;
+  SPIRV_TRACE(M, Decode, OpCode,
+              Entry->hasId() ? Entry->getId() : SPIRVID_INVALID, WordOffset);
+  if (TranslationStats *Stats = getActiveTranslationStats())
+    ++Stats->Instructions;
   if (Entry->isEndOfBlock() || OpCode == OpNoLine)
     M.setCurrentLine(nullptr);
 
@@ -243,24 +253,26 @@ SPIRVEntry *SPIRVDecoder::getEntry() {
     ExtensionID ExtID = {};
     bool ExtIsKnown = SPIRVMap<ExtensionID, std::string>::rfind(
         OpExt->getExtensionName(), &ExtID);
-    if (!M.getErrorLog().checkError(
-            ExtIsKnown, SPIRVEC_InvalidModule,
-            "input SPIR-V module uses unknown extension '" +
-                OpExt->getExtensionName() + "'")) {
+    if (!M.getErrorLog().checkError(ExtIsKnown, SPIRVEC_InvalidModule, [&] {
+          return "input SPIR-V module uses unknown extension '" +
+                 OpExt->getExtensionName() + "'";
+        })) {
       M.setInvalid();
     }
 
     if (!M.getErrorLog().checkError(
-            M.isAllowedToUseExtension(ExtID), SPIRVEC_InvalidModule,
-            "input SPIR-V module uses extension '" + OpExt->getExtensionName() +
-                "' which were disabled by --spirv-ext option")) {
+            M.isAllowedToUseExtension(ExtID), SPIRVEC_InvalidModule, [&] {
+              return "input SPIR-V module uses extension '" +
+                     OpExt->getExtensionName() +
+                     "' which were disabled by --spirv-ext option";
+            })) {
       M.setInvalid();
     }
   }
 
-  if (!M.getErrorLog().checkError(Entry->isImplemented(),
-                                  SPIRVEC_UnimplementedOpCode,
-                                  std::to_string(Entry->getOpCode()))) {
+  if (!M.getErrorLog().checkError(
+          Entry->isImplemented(), SPIRVEC_UnimplementedOpCode,
+          [&] { return std::to_string(Entry->getOpCode()); })) {
     M.setInvalid();
   }
 
@@ -278,7 +290,7 @@ void SPIRVDecoder::validate() const {
 // In case of SPIR-V text format always skip until the end of the line.
 void SPIRVDecoder::ignore(size_t N) {
 #ifdef _SPIRV_SUPPORT_TEXT_FMT
-  if (SPIRVUseTextFormat) {
+  if (UseTextFormat) {
     IS.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
     return;
   }
@@ -288,10 +300,44 @@ void SPIRVDecoder::ignore(size_t N) {
 
 void SPIRVDecoder::ignoreInstruction() { ignore(WordCount - 1); }
 
-spv_ostream &operator<<(spv_ostream &O, const SPIRVNL &E) {
+// Skip the current instruction without creating an entry for it if it only
+// carries debug information. Returns true if the instruction was skipped.
+bool SPIRVDecoder::skipDebugInstruction() {
+  switch (OpCode) {
+  case OpLine:
+  case OpNoLine:
+  case OpSourceContinued:
+    ignoreInstruction();
+    return true;
+  case OpExtInst:
+    break;
+  default:
+    return false;
+  }
+  // Peek at the instruction set operand of
+  // OpExtInst <result type> <result id> <set> ...
+  // If the stream can't be rewound the instruction is decoded as usual.
+  if (UseTextFormat || WordCount < 4)
+    return false;
+  std::streampos Start = IS.tellg();
+  if (Start == std::streampos(-1))
+    return false;
+  SPIRVWord Words[3];
+  for (auto &W : Words)
+    decodeBinary(*this, W);
+  SPIRVExtInstSetKind Set = M.getBuiltinSet(Words[2]);
+  if (Set == SPIRVEIS_Debug || Set == SPIRVEIS_OpenCL_DebugInfo_100) {
+    ignore(WordCount - 4);
+    return true;
+  }
+  IS.seekg(Start);
+  return false;
+}
+
+const SPIRVEncoder &operator<<(const SPIRVEncoder &O, const SPIRVNL &E) {
 #ifdef _SPIRV_SUPPORT_TEXT_FMT
-  if (SPIRVUseTextFormat)
-    O << '\n';
+  if (O.UseTextFormat)
+    O.OS << '\n';
 #endif
   return O;
 }
@@ -308,6 +354,9 @@ std::vector<SPIRVEntry *>
 SPIRVDecoder::getContinuedInstructions(const spv::Op ContinuedOpCode) {
   std::vector<SPIRVEntry *> ContinuedInst;
   std::streampos Pos = IS.tellg(); // remember position
+#ifdef LLVM_SPIRV_ENABLE_TRACE
+  uint64_t TracePos = M.getTraceBuffer().getNextOffset(SPIRVTracePhase::Decode);
+#endif
   getWordCountAndOpCode();
   while (OpCode == ContinuedOpCode) {
     SPIRVEntry *Entry = getEntry();
@@ -315,9 +364,15 @@ SPIRVDecoder::getContinuedInstructions(const spv::Op ContinuedOpCode) {
     M.add(Entry);
     ContinuedInst.push_back(Entry);
     Pos = IS.tellg();
+#ifdef LLVM_SPIRV_ENABLE_TRACE
+    TracePos = M.getTraceBuffer().getNextOffset(SPIRVTracePhase::Decode);
+#endif
     getWordCountAndOpCode();
   }
   IS.seekg(Pos); // restore position
+#ifdef LLVM_SPIRV_ENABLE_TRACE
+  M.getTraceBuffer().rewind(SPIRVTracePhase::Decode, TracePos);
+#endif
   return ContinuedInst;
 }
 
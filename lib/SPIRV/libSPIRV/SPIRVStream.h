@@ -55,18 +55,12 @@ namespace SPIRV {
 #define _SPIRV_SUPPORT_TEXT_FMT
 #endif
 
-#ifdef _SPIRV_SUPPORT_TEXT_FMT
-// Use textual format for SPIRV.
-extern bool SPIRVUseTextFormat;
-#endif
-
 class SPIRVFunction;
 class SPIRVBasicBlock;
 
 class SPIRVDecoder {
 public:
-  SPIRVDecoder(std::istream &InputStream, SPIRVModule &Module)
-      : IS(InputStream), M(Module), WordCount(0), OpCode(OpNop), Scope(NULL) {}
+  SPIRVDecoder(std::istream &InputStream, SPIRVModule &Module);
   SPIRVDecoder(std::istream &InputStream, SPIRVFunction &F);
   SPIRVDecoder(std::istream &InputStream, SPIRVBasicBlock &BB);
 
@@ -76,6 +70,7 @@ public:
   void validate() const;
   void ignore(size_t N);
   void ignoreInstruction();
+  bool skipDebugInstruction();
   std::vector<SPIRVEntry *>
   getContinuedInstructions(const spv::Op ContinuedOpCode);
 
@@ -84,17 +79,26 @@ public:
   SPIRVWord WordCount;
   Op OpCode;
   SPIRVEntry *Scope; // A function or basic block
+  // Offset of the current instruction from the start of the module. Only
+  // tracked if tracing is enabled.
+  uint64_t WordOffset;
+  // Use textual format for SPIRV.
+  bool UseTextFormat;
 };
 
 class SPIRVEncoder {
 public:
-  explicit SPIRVEncoder(spv_ostream &OutputStream) : OS(OutputStream) {}
+  SPIRVEncoder(spv_ostream &OutputStream, bool TextFormat)
+      : OS(OutputStream), UseTextFormat(TextFormat) {}
   spv_ostream &OS;
+  // Use textual format for SPIRV.
+  bool UseTextFormat;
 };
 
 /// Output a new line in text mode. Do nothing in binary mode.
 class SPIRVNL {
-  friend spv_ostream &operator<<(spv_ostream &O, const SPIRVNL &E);
+  friend const SPIRVEncoder &operator<<(const SPIRVEncoder &O,
+                                        const SPIRVNL &E);
 };
 
 template <typename T>
@@ -135,7 +139,7 @@ inline std::istream &skipcomment(std::istream &IS) {
 template <typename T>
 const SPIRVDecoder &operator>>(const SPIRVDecoder &I, T &V) {
 #ifdef _SPIRV_SUPPORT_TEXT_FMT
-  if (SPIRVUseTextFormat) {
+  if (I.UseTextFormat) {
     uint32_t W;
     I.IS >> skipcomment >> W;
     V = static_cast<T>(W);
@@ -179,7 +183,7 @@ const SPIRVDecoder &operator>>(const SPIRVDecoder &I, llvm::Optional<T> &V) {
 template <typename T>
 const SPIRVEncoder &operator<<(const SPIRVEncoder &O, T V) {
 #ifdef _SPIRV_SUPPORT_TEXT_FMT
-  if (SPIRVUseTextFormat) {
+  if (O.UseTextFormat) {
     O.OS << V << " ";
     return O;
   }
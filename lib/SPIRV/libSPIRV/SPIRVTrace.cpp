@@ -0,0 +1,91 @@
+//===- SPIRVTrace.cpp - SPIR-V Translation Tracing --------------*- C++ -*-===//
+//
+//                     The LLVM/SPIR-V Translator
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+// Copyright (c) 2021 Intel Corporation. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal with the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimers.
+// Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimers in the documentation
+// and/or other materials provided with the distribution.
+// Neither the names of Advanced Micro Devices, Inc., nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// Software without specific prior written permission.
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH
+// THE SOFTWARE.
+//
+//===----------------------------------------------------------------------===//
+/// \file
+///
+/// This file implements the ring buffer of translation trace events.
+///
+//===----------------------------------------------------------------------===//
+
+#include "SPIRVTrace.h"
+#include "LLVMSPIRVLib.h"
+#include "SPIRVNameMapEnum.h"
+
+namespace SPIRV {
+
+static thread_local std::ostream *TraceStream = nullptr;
+
+bool isSpirvTraceEnabled() {
+#ifdef LLVM_SPIRV_ENABLE_TRACE
+  return true;
+#else
+  return false;
+#endif
+}
+
+void setSpirvTraceStream(std::ostream *OS) { TraceStream = OS; }
+
+std::ostream *getSpirvTraceStream() { return TraceStream; }
+
+std::vector<SPIRVTraceEvent> SPIRVTraceBuffer::getEvents() const {
+  if (Events.size() < Capacity)
+    return Events;
+  std::vector<SPIRVTraceEvent> Ordered;
+  Ordered.reserve(Capacity);
+  size_t Oldest = NumRecorded % Capacity;
+  Ordered.insert(Ordered.end(), Events.begin() + Oldest, Events.end());
+  Ordered.insert(Ordered.end(), Events.begin(), Events.begin() + Oldest);
+  return Ordered;
+}
+
+void SPIRVTraceBuffer::dumpJSON(std::ostream &OS) const {
+  OS << "{\"capacity\":" << Capacity << ",\"recorded\":" << NumRecorded
+     << ",\"events\":[";
+  bool First = true;
+  for (const auto &E : getEvents()) {
+    if (!First)
+      OS << ',';
+    First = false;
+    OS << "{\"phase\":\""
+       << (E.Phase == SPIRVTracePhase::Decode ? "decode" : "encode")
+       << "\",\"opcode\":\"" << OpCodeNameMap::map(E.OpCode) << "\",\"id\":";
+    if (E.Id == SPIRVID_INVALID)
+      OS << "null";
+    else
+      OS << E.Id;
+    OS << ",\"offset\":" << E.WordOffset << '}';
+  }
+  OS << "]}\n";
+}
+
+} // namespace SPIRV
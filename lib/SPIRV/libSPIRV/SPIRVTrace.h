@@ -0,0 +1,142 @@
+//===- SPIRVTrace.h - SPIR-V Translation Tracing ----------------*- C++ -*-===//
+//
+//                     The LLVM/SPIR-V Translator
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+// Copyright (c) 2021 Intel Corporation. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal with the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimers.
+// Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimers in the documentation
+// and/or other materials provided with the distribution.
+// Neither the names of Advanced Micro Devices, Inc., nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// Software without specific prior written permission.
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH
+// THE SOFTWARE.
+//
+//===----------------------------------------------------------------------===//
+/// \file
+///
+/// This file declares the tracing facility of the translator. When the library
+/// is built with LLVM_SPIRV_ENABLE_TRACE, the decoder and the encoder record
+/// one event per instruction into a fixed size ring buffer owned by the
+/// SPIR-V module. Otherwise SPIRV_TRACE expands to nothing.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef SPIRV_LIBSPIRV_SPIRVTRACE_H
+#define SPIRV_LIBSPIRV_SPIRVTRACE_H
+
+#include "SPIRVEnum.h"
+#include "SPIRVOpCode.h"
+
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+namespace SPIRV {
+
+enum class SPIRVTracePhase : uint8_t { Decode, Encode };
+
+struct SPIRVTraceEvent {
+  SPIRVTracePhase Phase;
+  Op OpCode;
+  SPIRVId Id;
+  // Offset of the first word of the instruction from the start of the module.
+  uint64_t WordOffset;
+};
+
+class SPIRVTraceBuffer {
+public:
+  static const size_t DefaultCapacity = 4096;
+  // Number of words of the module header preceding the first instruction.
+  static const uint64_t HeaderWords = 5;
+
+  explicit SPIRVTraceBuffer(size_t Capacity = DefaultCapacity)
+      : Capacity(Capacity ? Capacity : 1) {}
+
+  void record(SPIRVTracePhase Phase, Op OpCode, SPIRVId Id,
+              uint64_t WordOffset) {
+    if (Events.size() < Capacity)
+      Events.push_back({Phase, OpCode, Id, WordOffset});
+    else
+      Events[NumRecorded % Capacity] = {Phase, OpCode, Id, WordOffset};
+    ++NumRecorded;
+  }
+
+  /// Offsets are counted by adding up the word counts of the instructions
+  /// seen in \p Phase rather than asking the stream for its position, so they
+  /// are the same for the binary and the text format and for streams which
+  /// cannot seek.
+  /// \returns offset of an instruction of \p WordCount words following the
+  /// previous one.
+  uint64_t advance(SPIRVTracePhase Phase, SPIRVWord WordCount) {
+    uint64_t &Next = NextWord[static_cast<size_t>(Phase)];
+    uint64_t Offset = Next;
+    Next += WordCount;
+    return Offset;
+  }
+
+  /// Make \p WordOffset the offset of the next instruction of \p Phase, e.g.
+  /// when the decoder steps back over an instruction it has peeked at.
+  void rewind(SPIRVTracePhase Phase, uint64_t WordOffset) {
+    NextWord[static_cast<size_t>(Phase)] = WordOffset;
+  }
+
+  /// \returns offset the next instruction of \p Phase would get.
+  uint64_t getNextOffset(SPIRVTracePhase Phase) const {
+    return NextWord[static_cast<size_t>(Phase)];
+  }
+
+  void clear() {
+    Events.clear();
+    NumRecorded = 0;
+    NextWord[0] = NextWord[1] = HeaderWords;
+  }
+
+  /// \returns number of events recorded since the last clear, including the
+  /// ones which have been overwritten.
+  uint64_t getNumRecorded() const { return NumRecorded; }
+
+  /// \returns events kept in the buffer from the oldest to the newest.
+  std::vector<SPIRVTraceEvent> getEvents() const;
+
+  /// Write the buffer as a JSON object.
+  void dumpJSON(std::ostream &OS) const;
+
+private:
+  size_t Capacity;
+  uint64_t NumRecorded = 0;
+  uint64_t NextWord[2] = {HeaderWords, HeaderWords};
+  std::vector<SPIRVTraceEvent> Events;
+};
+
+/// \returns stream set by setSpirvTraceStream on the current thread.
+std::ostream *getSpirvTraceStream();
+
+#ifdef LLVM_SPIRV_ENABLE_TRACE
+#define SPIRV_TRACE(Module, Phase, OpCode, Id, WordOffset)                     \
+  (Module).getTraceBuffer().record(SPIRVTracePhase::Phase, OpCode, Id,         \
+                                   WordOffset)
+#else
+#define SPIRV_TRACE(Module, Phase, OpCode, Id, WordOffset)
+#endif
+
+} // namespace SPIRV
+#endif // SPIRV_LIBSPIRV_SPIRVTRACE_H
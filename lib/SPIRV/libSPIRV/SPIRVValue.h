@@ -324,7 +324,7 @@ public:
   }
 
   void encodeChildren(spv_ostream &O) const override {
-    O << SPIRVNL();
+    getEncoder(O) << SPIRVNL();
     for (auto &I : ContinuedInstructions)
       O << *I;
   }
@@ -0,0 +1,56 @@
+; RUN: llvm-as %s -o %t.bc
+; RUN: llvm-spirv %t.bc -o %t.spv -spirv-debug-sidecar=%t.dbg.spv
+; RUN: llvm-spirv %t.spv -to-text -o - | FileCheck %s --check-prefix=CHECK-STRIPPED
+; RUN: llvm-spirv %t.dbg.spv -to-text -o - | FileCheck %s --check-prefix=CHECK-FULL
+
+; RUN: llvm-spirv -r %t.spv -o - | llvm-dis -o - | FileCheck %s --check-prefix=CHECK-NODBG
+; RUN: llvm-spirv -r -spirv-skip-debug-info %t.dbg.spv -o - | llvm-dis -o - | FileCheck %s --check-prefix=CHECK-NODBG
+; RUN: llvm-spirv -r %t.dbg.spv -o - | llvm-dis -o - | FileCheck %s --check-prefix=CHECK-DBG
+
+; CHECK-STRIPPED-NOT: ExtInstImport {{[0-9]+}} "OpenCL.DebugInfo.100"
+; CHECK-STRIPPED: ModuleProcessed "debug-sidecar:xxh64:{{[0-9a-f]+}}"
+; CHECK-STRIPPED-NOT: Line
+; CHECK-STRIPPED-NOT: ExtInst
+
+; CHECK-FULL: ExtInstImport {{[0-9]+}} "OpenCL.DebugInfo.100"
+; CHECK-FULL-NOT: ModuleProcessed "debug-sidecar
+; CHECK-FULL: Line
+
+; CHECK-NODBG: define spir_func i32 @foo
+; CHECK-NODBG-NOT: !dbg
+; CHECK-NODBG-NOT: DISubprogram
+
+; CHECK-DBG: define spir_func i32 @foo{{.*}} !dbg
+; CHECK-DBG: DISubprogram(name: "foo"
+
+target datalayout = "e-i64:64-v16:16-v24:32-v32:32-v48:64-v96:128-v192:256-v256:256-v512:512-v1024:1024"
+target triple = "spir64-unknown-unknown"
+
+define spir_func i32 @foo(i32 %x, i32 %y) !dbg !8 {
+entry:
+  call void @llvm.dbg.value(metadata i32 %x, metadata !13, metadata !DIExpression()), !dbg !15
+  %add = add nsw i32 %y, %x, !dbg !16
+  ret i32 %add, !dbg !17
+}
+
+declare void @llvm.dbg.value(metadata, metadata, metadata)
+
+!llvm.dbg.cu = !{!0}
+!llvm.module.flags = !{!3, !4}
+!opencl.ocl.version = !{!5}
+
+!0 = distinct !DICompileUnit(language: DW_LANG_C99, file: !1, producer: "clang", isOptimized: true, runtimeVersion: 0, emissionKind: FullDebug, enums: !2)
+!1 = !DIFile(filename: "test.cl", directory: "/tmp")
+!2 = !{}
+!3 = !{i32 7, !"Dwarf Version", i32 4}
+!4 = !{i32 2, !"Debug Info Version", i32 3}
+!5 = !{i32 1, i32 0}
+!8 = distinct !DISubprogram(name: "foo", scope: !1, file: !1, line: 1, type: !9, scopeLine: 2, flags: DIFlagPrototyped, spFlags: DISPFlagDefinition | DISPFlagOptimized, unit: !0, retainedNodes: !12)
+!9 = !DISubroutineType(types: !10)
+!10 = !{!11, !11, !11}
+!11 = !DIBasicType(name: "int", size: 32, encoding: DW_ATE_signed)
+!12 = !{!13}
+!13 = !DILocalVariable(name: "x", arg: 1, scope: !8, file: !1, line: 1, type: !11)
+!15 = !DILocation(line: 0, scope: !8)
+!16 = !DILocation(line: 3, column: 11, scope: !8)
+!17 = !DILocation(line: 3, column: 3, scope: !8)
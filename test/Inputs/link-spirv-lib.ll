@@ -0,0 +1,39 @@
+; Library module for link-spirv.ll.
+
+target datalayout = "e-i64:64-v16:16-v24:32-v32:32-v48:64-v96:128-v192:256-v256:256-v512:512-v1024:1024"
+target triple = "spir64-unknown-unknown"
+
+%struct.A = type { i32 }
+%struct.B = type { i32 }
+
+@lib_scale = addrspace(1) global float 2.000000e+00, align 4
+
+define spir_func float @lib_square(float %x) {
+entry:
+  %s = load float, float addrspace(1)* @lib_scale, align 4
+  %m = fmul float %x, %x
+  %r = fmul float %m, %s
+  ret float %r
+}
+
+define linkonce_odr spir_func i32 @shared_helper(i32 %x) {
+entry:
+  %r = add i32 %x, 1
+  ret i32 %r
+}
+
+define spir_kernel void @lib_k(%struct.A addrspace(1)* %a,
+                               %struct.B addrspace(1)* %b) {
+entry:
+  %pa = getelementptr %struct.A, %struct.A addrspace(1)* %a, i64 0, i32 0
+  %pb = getelementptr %struct.B, %struct.B addrspace(1)* %b, i64 0, i32 0
+  %v = load i32, i32 addrspace(1)* %pa, align 4
+  store i32 %v, i32 addrspace(1)* %pb, align 4
+  ret void
+}
+
+!opencl.spir.version = !{!0}
+!spirv.Source = !{!1}
+
+!0 = !{i32 1, i32 2}
+!1 = !{i32 3, i32 102000}
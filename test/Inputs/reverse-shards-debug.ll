@@ -0,0 +1,37 @@
+; Module with debug info for reverse-shards.ll.
+
+target datalayout = "e-i64:64-v16:16-v24:32-v32:32-v48:64-v96:128-v192:256-v256:256-v512:512-v1024:1024"
+target triple = "spir64-unknown-unknown"
+
+define spir_kernel void @k0(i32 addrspace(1)* %a) !dbg !6 {
+entry:
+  store i32 0, i32 addrspace(1)* %a, align 4, !dbg !9
+  ret void, !dbg !10
+}
+
+define spir_kernel void @k1(i32 addrspace(1)* %a) !dbg !11 {
+entry:
+  store i32 1, i32 addrspace(1)* %a, align 4, !dbg !12
+  ret void, !dbg !13
+}
+
+!llvm.dbg.cu = !{!0}
+!llvm.module.flags = !{!3, !4}
+!opencl.spir.version = !{!5}
+!spirv.Source = !{!14}
+
+!0 = distinct !DICompileUnit(language: DW_LANG_OpenCL, file: !1, producer: "clang", isOptimized: false, runtimeVersion: 0, emissionKind: FullDebug, enums: !2)
+!1 = !DIFile(filename: "shards.cl", directory: "/tmp")
+!2 = !{}
+!3 = !{i32 2, !"Dwarf Version", i32 4}
+!4 = !{i32 2, !"Debug Info Version", i32 3}
+!5 = !{i32 1, i32 2}
+!6 = distinct !DISubprogram(name: "k0", scope: !1, file: !1, line: 1, type: !7, scopeLine: 1, flags: DIFlagPrototyped, spFlags: DISPFlagDefinition, unit: !0, retainedNodes: !2)
+!7 = !DISubroutineType(types: !8)
+!8 = !{null}
+!9 = !DILocation(line: 2, column: 3, scope: !6)
+!10 = !DILocation(line: 3, column: 1, scope: !6)
+!11 = distinct !DISubprogram(name: "k1", scope: !1, file: !1, line: 5, type: !7, scopeLine: 5, flags: DIFlagPrototyped, spFlags: DISPFlagDefinition, unit: !0, retainedNodes: !2)
+!12 = !DILocation(line: 6, column: 3, scope: !11)
+!13 = !DILocation(line: 7, column: 1, scope: !11)
+!14 = !{i32 3, i32 102000}
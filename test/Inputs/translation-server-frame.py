@@ -0,0 +1,51 @@
+# Send a malformed request to the translation server listening on the unix
+# domain socket given by the first argument and print its response.
+#   oversized: a frame whose size exceeds the limit of the server
+#   garbage:   a frame which does not hold a translation request
+
+import socket
+import struct
+import sys
+import time
+
+
+def connect(path):
+    # The server may not listen yet.
+    for _ in range(200):
+        s = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        try:
+            s.connect(path)
+            return s
+        except OSError:
+            s.close()
+            time.sleep(0.01)
+    sys.exit("cannot connect to " + path)
+
+
+def receive(s, size):
+    data = b''
+    while len(data) < size:
+        chunk = s.recv(size - len(data))
+        if not chunk:
+            sys.exit("truncated response")
+        data += chunk
+    return data
+
+
+def main():
+    path, kind = sys.argv[1:3]
+    s = connect(path)
+    if kind == 'oversized':
+        s.sendall(struct.pack('=Q', 1 << 40))
+    else:
+        payload = b'garbage'
+        s.sendall(struct.pack('=Q', len(payload)) + payload)
+    (size,) = struct.unpack('=Q', receive(s, 8))
+    response = receive(s, size)
+    (ret, diag_size) = struct.unpack('=qQ', response[:16])
+    sys.stdout.write(response[16:16 + diag_size].decode())
+    print("exit code %d" % ret)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,18 @@
+; Invalid module for verification-level.ll: %v is used before it is defined.
+; It is assembled with llvm-as -disable-verify.
+
+target datalayout = "e-i64:64-v16:16-v24:32-v32:32-v48:64-v96:128-v192:256-v256:256-v512:512-v1024:1024"
+target triple = "spir64-unknown-unknown"
+
+define spir_kernel void @broken(i32 addrspace(1)* %a) {
+entry:
+  store i32 %v, i32 addrspace(1)* %a, align 4
+  %v = add i32 1, 2
+  ret void
+}
+
+!opencl.spir.version = !{!0}
+!spirv.Source = !{!1}
+
+!0 = !{i32 1, i32 2}
+!1 = !{i32 3, i32 102000}
@@ -0,0 +1,75 @@
+; Check that several input files are translated independently and that the
+; results match single-file translation.
+; RUN: rm -rf %t.dir && mkdir -p %t.dir
+; RUN: llvm-as %s -o %t.dir/a.bc
+; RUN: cp %t.dir/a.bc %t.dir/b.bc
+; RUN: cp %t.dir/a.bc %t.dir/c.bc
+; RUN: llvm-spirv %t.dir/a.bc -o %t.ref.spv
+; RUN: llvm-spirv -j 2 %t.dir/a.bc %t.dir/b.bc 2>&1 | FileCheck %s --check-prefix=CHECK-OK
+; RUN: cmp %t.ref.spv %t.dir/a.spv
+; RUN: cmp %t.ref.spv %t.dir/b.spv
+
+; Files listed in -input-list are translated after the positional ones.
+; RUN: echo "%t.dir/c.bc" > %t.list
+; RUN: llvm-spirv -input-list=%t.list %t.dir/b.bc 2>&1 | FileCheck %s --check-prefix=CHECK-LIST
+; RUN: cmp %t.ref.spv %t.dir/c.spv
+
+; Standard input is translated to standard output rather than to a file
+; named "-".
+; RUN: echo "-" > %t.stdin.list
+; RUN: cd %t.dir && llvm-spirv -input-list=%t.stdin.list < a.bc > %t.stdout.spv
+; RUN: cmp %t.ref.spv %t.stdout.spv
+; RUN: not ls %t.dir/-
+
+; RUN: llvm-spirv -r %t.ref.spv -o %t.ref.bc
+; RUN: llvm-spirv -r -j 2 %t.dir/a.spv %t.dir/b.spv
+; RUN: llvm-dis < %t.ref.bc > %t.ref.ll
+; RUN: llvm-dis < %t.dir/b.bc > %t.b.ll
+; RUN: diff %t.ref.ll %t.b.ll
+
+; A failing file does not stop the others, and the status is reported in
+; input order.
+; RUN: touch %t.dir/empty.bc
+; RUN: rm %t.dir/c.spv
+; RUN: not llvm-spirv -j 3 %t.dir/a.bc %t.dir/empty.bc %t.dir/c.bc 2>&1 | FileCheck %s --check-prefix=CHECK-FAIL
+; RUN: cmp %t.ref.spv %t.dir/c.spv
+
+; RUN: cp %s %t.dir/bad.spv
+; RUN: not llvm-spirv -r %t.dir/bad.spv %t.dir/a.spv 2>&1 | FileCheck %s --check-prefix=CHECK-BAD
+
+; RUN: not llvm-spirv %t.dir/a.bc %t.dir/b.bc -o %t.out.spv 2>&1 | FileCheck %s --check-prefix=CHECK-OUT
+
+; CHECK-OK: a.bc: ok
+; CHECK-OK-NEXT: b.bc: ok
+
+; CHECK-LIST: b.bc: ok
+; CHECK-LIST-NEXT: c.bc: ok
+
+; CHECK-FAIL: a.bc: ok
+; CHECK-FAIL-NEXT: empty.bc: failed
+; CHECK-FAIL-NEXT: Can't translate, file is empty
+; CHECK-FAIL-NEXT: c.bc: ok
+; CHECK-FAIL-NEXT: 1 of 3 input files failed to translate
+
+; CHECK-BAD: bad.spv: failed
+; CHECK-BAD-NEXT: Fails to load SPIR-V as LLVM Module: {{.*}}
+; CHECK-BAD-NEXT: a.spv: ok
+; CHECK-BAD-NEXT: 1 of 2 input files failed to translate
+
+; CHECK-OUT: Cannot use -o, -spirv-debug-sidecar with more than one input file
+
+target datalayout = "e-i64:64-v16:16-v24:32-v32:32-v48:64-v96:128-v192:256-v256:256-v512:512-v1024:1024"
+target triple = "spir64-unknown-unknown"
+
+define spir_kernel void @k(i32 addrspace(1)* %a, i32 %n) {
+entry:
+  %m = mul i32 %n, %n
+  store i32 %m, i32 addrspace(1)* %a, align 4
+  ret void
+}
+
+!opencl.spir.version = !{!0}
+!spirv.Source = !{!1}
+
+!0 = !{i32 1, i32 2}
+!1 = !{i32 3, i32 102000}
@@ -0,0 +1,29 @@
+; Check that a function whose name only consists of substitutions is not
+; taken for a builtin with a last parameter.
+; RUN: llvm-as %s -o %t.bc
+; RUN: llvm-spirv %t.bc -o %t.spv
+; RUN: llvm-spirv -r %t.spv -o - | llvm-dis | FileCheck %s
+
+; CHECK: call spir_func void @S_S_(
+; CHECK: define spir_func void @S_S_(
+
+target datalayout = "e-i64:64-v16:16-v24:32-v32:32-v48:64-v96:128-v192:256-v256:256-v512:512-v1024:1024"
+target triple = "spir64-unknown-unknown"
+
+define spir_kernel void @k(i32 addrspace(1)* %a) {
+entry:
+  call spir_func void @S_S_(i32 addrspace(1)* %a)
+  ret void
+}
+
+define spir_func void @S_S_(i32 addrspace(1)* %a) {
+entry:
+  store i32 0, i32 addrspace(1)* %a, align 4
+  ret void
+}
+
+!opencl.spir.version = !{!0}
+!spirv.Source = !{!1}
+
+!0 = !{i32 1, i32 2}
+!1 = !{i32 3, i32 102000}
@@ -0,0 +1,78 @@
+; Check that -link combines separately translated SPIR-V modules, resolving
+; imports against exports and unifying identical types and constants.
+; RUN: llvm-as %s -o %t.main.bc
+; RUN: llvm-as %S/Inputs/link-spirv-lib.ll -o %t.lib.bc
+; RUN: llvm-spirv %t.main.bc --spirv-ext=+SPV_KHR_linkonce_odr -o %t.main.spv
+; RUN: llvm-spirv %t.lib.bc --spirv-ext=+SPV_KHR_linkonce_odr -o %t.lib.spv
+; RUN: llvm-spirv -link %t.main.spv %t.lib.spv -o %t.linked.spv
+; RUN: llvm-spirv %t.linked.spv -to-text -o - | FileCheck %s --check-prefix=CHECK-SPIRV
+; RUN: llvm-spirv %t.linked.spv -to-text -o - | FileCheck %s --check-prefix=CHECK-STRUCT
+; RUN: llvm-spirv %t.linked.spv -to-text -o - | grep -w TypeStruct | count 2
+; RUN: llvm-spirv -r %t.linked.spv -o - | llvm-dis | FileCheck %s --check-prefix=CHECK-LLVM
+
+; RUN: not llvm-spirv -link %t.lib.spv %t.lib.spv -o %t.dup.spv 2>&1 | FileCheck %s --check-prefix=CHECK-DUP
+; RUN: not llvm-spirv -link -r %t.main.spv %t.lib.spv 2>&1 | FileCheck %s --check-prefix=CHECK-OPT
+; RUN: not llvm-spirv -to-text %t.main.spv %t.lib.spv 2>&1 | FileCheck %s --check-prefix=CHECK-INPUTS
+
+; CHECK-SPIRV-NOT: LinkageAttributes {{.*}} 1{{$}}
+; CHECK-SPIRV: TypeInt
+; CHECK-SPIRV-NOT: TypeInt
+; CHECK-SPIRV: TypeFloat
+; CHECK-SPIRV-NOT: TypeFloat
+; CHECK-SPIRV-NOT: LinkageAttributes {{.*}} 1{{$}}
+
+; Structs with the same members are only unified when their names match.
+; CHECK-STRUCT-DAG: Name [[#A:]] "struct.A"
+; CHECK-STRUCT-DAG: Name [[#B:]] "struct.B"
+; CHECK-STRUCT-DAG: TypeStruct [[#A]] [[#]]
+; CHECK-STRUCT-DAG: TypeStruct [[#B]] [[#]]
+; CHECK-STRUCT-NOT: Name [[#]] "struct.A"
+
+; CHECK-LLVM-DAG: %struct.A = type { i32 }
+; CHECK-LLVM-DAG: %struct.B = type { i32 }
+; CHECK-LLVM: @lib_scale = addrspace(1) global float 2.000000e+00
+; CHECK-LLVM: define linkonce_odr spir_func i32 @shared_helper(i32
+; CHECK-LLVM: define spir_kernel void @k(
+; CHECK-LLVM: call spir_func float @lib_square(
+; CHECK-LLVM: call spir_func i32 @shared_helper(
+; CHECK-LLVM: define spir_func float @lib_square(float
+; CHECK-LLVM-NOT: define {{.*}}@shared_helper(
+
+; CHECK-DUP: Fails to link SPIR-V modules: Symbol lib_square is defined in more than one module
+; CHECK-OPT: Cannot use -link with -r, -s, -specialize, -spec-const-info
+; CHECK-INPUTS: Only translation and -link accept more than one input file
+
+target datalayout = "e-i64:64-v16:16-v24:32-v32:32-v48:64-v96:128-v192:256-v256:256-v512:512-v1024:1024"
+target triple = "spir64-unknown-unknown"
+
+%struct.A = type { i32 }
+
+declare spir_func float @lib_square(float)
+
+define linkonce_odr spir_func i32 @shared_helper(i32 %x) {
+entry:
+  %r = add i32 %x, 1
+  ret i32 %r
+}
+
+define spir_kernel void @k(float addrspace(1)* %out, i32 addrspace(1)* %iout) {
+entry:
+  %v = call spir_func float @lib_square(float 3.000000e+00)
+  store float %v, float addrspace(1)* %out, align 4
+  %i = call spir_func i32 @shared_helper(i32 41)
+  store i32 %i, i32 addrspace(1)* %iout, align 4
+  ret void
+}
+
+define spir_kernel void @k_struct(%struct.A addrspace(1)* %a) {
+entry:
+  %p = getelementptr %struct.A, %struct.A addrspace(1)* %a, i64 0, i32 0
+  store i32 0, i32 addrspace(1)* %p, align 4
+  ret void
+}
+
+!opencl.spir.version = !{!0}
+!spirv.Source = !{!1}
+
+!0 = !{i32 1, i32 2}
+!1 = !{i32 3, i32 102000}
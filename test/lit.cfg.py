@@ -19,7 +19,7 @@ config.test_format = lit.formats.ShTest(not llvm_config.use_lit_shell)
 config.suffixes = ['.cl', '.ll', '.spt', '.spvasm']
 
 # excludes: A list of directories  and fles to exclude from the testsuite.
-config.excludes = ['CMakeLists.txt']
+config.excludes = ['CMakeLists.txt', 'Inputs']
 
 if not config.spirv_skip_debug_info_tests:
     # Direct object generation.
@@ -33,6 +33,9 @@ if not config.spirv_skip_debug_info_tests:
     # Ask llvm-config about asserts.
     llvm_config.feature_config([('--assertion-mode', {'ON': 'asserts'})])
 
+if config.spirv_enable_trace:
+    config.available_features.add('spirv-trace')
+
 # test_source_root: The root path where tests are located.
 config.test_source_root = os.path.dirname(__file__)
 
@@ -45,9 +48,9 @@ llvm_config.use_clang()
 
 config.substitutions.append(('%PATH%', config.environment['PATH']))
 
-tool_dirs = [config.llvm_tools_dir, config.llvm_spirv_dir]
+tool_dirs = [config.llvm_tools_dir, config.llvm_spirv_dir, config.llvm_spirv_bench_dir]
 
-tools = ['llvm-as', 'llvm-dis', 'llvm-spirv', 'not']
+tools = ['llvm-as', 'llvm-dis', 'llvm-spirv', 'llvm-spirv-bench', 'not']
 if not config.spirv_skip_debug_info_tests:
     tools.extend(['llc', 'llvm-dwarfdump', 'llvm-objdump', 'llvm-readelf', 'llvm-readobj'])
 
@@ -0,0 +1,32 @@
+; Check that the benchmark generates a valid module and reports every
+; benchmark. The generated module must survive a round trip through the
+; translator.
+; RUN: llvm-spirv-bench -kernels=2 -instructions=200 -struct-depth=3 -constant-table=16 -g -iterations=2 -emit-module=%t.bc -o %t.json
+; RUN: FileCheck %s < %t.json
+; RUN: llvm-spirv %t.bc -o %t.spv
+; RUN: spirv-val %t.spv
+; RUN: llvm-spirv -r %t.spv -o - | llvm-dis | FileCheck %s --check-prefix=CHECK-LLVM
+
+; RUN: llvm-spirv-bench -kernels=1 -instructions=10 -iterations=1 -benchmarks=text | FileCheck %s --check-prefix=CHECK-TEXT
+; RUN: not llvm-spirv-bench -benchmarks=foo 2>&1 | FileCheck %s --check-prefix=CHECK-ERR
+
+; CHECK: {"config":{"kernels":2,"instructions":200,"struct_depth":3,"constant_table":16,"builtin_percent":25,"debug_info":true,"seed":1,"iterations":2}
+; CHECK-SAME: "module":{"llvm_instructions":{{[1-9][0-9]*}},"bitcode_bytes":{{[1-9][0-9]*}},"spirv_bytes":{{[1-9][0-9]*}}
+; CHECK-SAME: "benchmarks":[{"name":"forward","seconds":[{{[^,]+}},{{[^,]+}}],"min_seconds":
+; CHECK-SAME: "instructions_per_second":
+; CHECK-SAME: "peak_rss_bytes":
+; CHECK-SAME: "stats":{"phases":{
+; CHECK-SAME: "encode":
+; CHECK-SAME: {"name":"reverse",
+; CHECK-SAME: "decode":
+; CHECK-SAME: {"name":"text",
+; CHECK-SAME: "instructions_per_second":
+; CHECK-SAME: ]}
+
+; CHECK-LLVM: define spir_kernel void @kernel0(
+; CHECK-LLVM: define spir_kernel void @kernel1(
+
+; CHECK-TEXT: "benchmarks":[{"name":"text",
+; CHECK-TEXT-NOT: "name":
+
+; CHECK-ERR: Unknown benchmark: foo
@@ -0,0 +1,47 @@
+; Check that builtins returning a struct and builtins with array arguments
+; are still rewritten after the other builtins of their function are lowered:
+; the struct is returned through a pointer to the caller's temporary and
+; arrays are passed as a pointer to their first element, as before builtins
+; were lowered per function.
+; RUN: llvm-as %s -o %t.bc
+; RUN: llvm-spirv %t.bc -o %t.spv
+; RUN: llvm-spirv -r %t.spv -spirv-target-env=CL2.0 -o - | llvm-dis | FileCheck %s
+
+; CHECK-NOT: __spirv
+; CHECK-LABEL: define spir_func void @test_ndrange_2D3D(
+; CHECK: alloca [2 x i64]
+; CHECK: alloca [3 x i64]
+; CHECK: call spir_func void @_Z10ndrange_2D{{[^(]*}}(%struct.ndrange_t* %{{[^,]+}}, i64* %{{[^)]+}})
+; CHECK: %old = call spir_func i32 @_Z25atomic_fetch_add_explicitPU3AS4VU7_Atomicii12memory_order12memory_scope(
+; CHECK: call spir_func void @_Z10ndrange_3D{{[^(]*}}(%struct.ndrange_t* %{{[^,]+}}, i64* %{{[^)]+}})
+; CHECK: ret void
+; CHECK-NOT: .old
+; CHECK-NOT: __spirv
+
+target datalayout = "e-i64:64-v16:16-v24:32-v32:32-v48:64-v96:128-v192:256-v256:256-v512:512-v1024:1024"
+target triple = "spir64-unknown-unknown"
+
+%struct.ndrange_t = type { i32, [3 x i64], [3 x i64], [3 x i64] }
+
+define spir_func void @test_ndrange_2D3D(i32 addrspace(1)* %p) {
+entry:
+  %lsize2 = alloca [2 x i64], align 8
+  %tmp = alloca %struct.ndrange_t, align 8
+  %lsize3 = alloca [3 x i64], align 8
+  %tmp3 = alloca %struct.ndrange_t, align 8
+  %arraydecay = getelementptr inbounds [2 x i64], [2 x i64]* %lsize2, i64 0, i64 0
+  call spir_func void @_Z10ndrange_2DPKm(%struct.ndrange_t* sret(%struct.ndrange_t) %tmp, i64* %arraydecay)
+  %old = call spir_func i32 @_Z10atomic_incPU3AS1Vi(i32 addrspace(1)* %p)
+  %arraydecay2 = getelementptr inbounds [3 x i64], [3 x i64]* %lsize3, i64 0, i64 0
+  call spir_func void @_Z10ndrange_3DPKm(%struct.ndrange_t* sret(%struct.ndrange_t) %tmp3, i64* %arraydecay2)
+  ret void
+}
+
+declare spir_func void @_Z10ndrange_2DPKm(%struct.ndrange_t* sret(%struct.ndrange_t), i64*)
+declare spir_func void @_Z10ndrange_3DPKm(%struct.ndrange_t* sret(%struct.ndrange_t), i64*)
+declare spir_func i32 @_Z10atomic_incPU3AS1Vi(i32 addrspace(1)*)
+
+!opencl.spir.version = !{!0}
+!spirv.Source = !{!1}
+!0 = !{i32 2, i32 0}
+!1 = !{i32 3, i32 200000}
@@ -0,0 +1,65 @@
+; Check that builtins are lowered to OpenCL as each function is translated:
+; the builtins the desired representation only renames are called by their
+; OpenCL name, the others are lowered as soon as the body of their function is
+; complete, and no SPIR-V builtin is left behind. The kernel calls @f, whose
+; body is translated in the middle of the kernel's.
+; RUN: llvm-as %s -o %t.bc
+; RUN: llvm-spirv %t.bc -o %t.spv
+; RUN: llvm-spirv -r %t.spv -spirv-target-env=CL1.2 -o - | llvm-dis | FileCheck %s --check-prefixes=CHECK,CHECK-CL12
+; RUN: llvm-spirv -r %t.spv -spirv-target-env=CL2.0 -o - | llvm-dis | FileCheck %s --check-prefixes=CHECK,CHECK-CL20
+; RUN: llvm-spirv -r %t.spv -spirv-target-env=SPV-IR -o - | llvm-dis | FileCheck %s --check-prefix=CHECK-SPV-IR
+
+; CHECK-NOT: __spirv
+; CHECK-LABEL: define spir_kernel void @k(
+; CHECK: %n11 = call spir_func <4 x i32> @_Z5isnanDv4_f(<4 x float> %x)
+; CHECK-NEXT: %n1 = trunc <4 x i32> %n11 to <4 x i1>
+; CHECK: %a22 = call spir_func i32 @_Z3anyDv4_i(<4 x i32> %{{[0-9]+}})
+; CHECK-NEXT: %a2 = trunc i32 %a22 to i1
+; CHECK-CL12: %old = call spir_func i32 @_Z10atomic_incPU3AS1Vi(i32 addrspace(1)* %p)
+; CHECK-CL20: %old = call spir_func i32 @_Z25atomic_fetch_add_explicitPU3AS4VU7_Atomicii12memory_order12memory_scope(
+; CHECK-CL12: call spir_func void @_Z7barrierj(i32 1)
+; CHECK-CL20: call spir_func void @_Z18work_group_barrierj12memory_scope(i32 1, i32 1)
+; CHECK: call spir_func <4 x i32> @_Z12convert_int4Dv4_f(<4 x float> %x)
+; CHECK-LABEL: define spir_func void @f(
+; CHECK: call spir_func i32 @_Z5isinff(float %y)
+; CHECK-NOT: __spirv
+
+; CHECK-SPV-IR: call spir_func <4 x i32> @_Z13__spirv_IsNanDv4_f(
+; CHECK-SPV-IR: call spir_func i32 @_Z11__spirv_AnyDv4_i(
+; CHECK-SPV-IR: call spir_func i32 @_Z24__spirv_AtomicIIncrementPU3AS1iii(
+; CHECK-SPV-IR: call spir_func void @_Z22__spirv_ControlBarrieriii(
+
+target datalayout = "e-i64:64-v16:16-v24:32-v32:32-v48:64-v96:128-v192:256-v256:256-v512:512-v1024:1024"
+target triple = "spir64-unknown-unknown"
+
+define spir_kernel void @k(<4 x float> %x, i32 addrspace(1)* %p, <4 x i32> addrspace(1)* %q) {
+entry:
+  %n = call spir_func <4 x i32> @_Z5isnanDv4_f(<4 x float> %x)
+  %a = call spir_func i32 @_Z3anyDv4_i(<4 x i32> %n)
+  %old = call spir_func i32 @_Z10atomic_incPU3AS1Vi(i32 addrspace(1)* %p)
+  %s = add i32 %a, %old
+  call spir_func void @_Z7barrierj(i32 1)
+  store i32 %s, i32 addrspace(1)* %p, align 4
+  %c = call spir_func <4 x i32> @_Z12convert_int4Dv4_f(<4 x float> %x)
+  store <4 x i32> %c, <4 x i32> addrspace(1)* %q, align 16
+  call spir_func void @f(float 1.0)
+  ret void
+}
+
+define spir_func void @f(float %y) {
+entry:
+  %n = call spir_func i32 @_Z5isinff(float %y)
+  ret void
+}
+
+declare spir_func <4 x i32> @_Z5isnanDv4_f(<4 x float>)
+declare spir_func i32 @_Z3anyDv4_i(<4 x i32>)
+declare spir_func i32 @_Z10atomic_incPU3AS1Vi(i32 addrspace(1)*)
+declare spir_func void @_Z7barrierj(i32)
+declare spir_func <4 x i32> @_Z12convert_int4Dv4_f(<4 x float>)
+declare spir_func i32 @_Z5isinff(float)
+
+!opencl.spir.version = !{!0}
+!spirv.Source = !{!1}
+!0 = !{i32 1, i32 2}
+!1 = !{i32 3, i32 102000}
@@ -0,0 +1,114 @@
+; Check that -shards translates every function definition into one shard,
+; keeps functions and variables with internal linkage next to their users,
+; and that the linked shards define everything the module defines.
+; RUN: llvm-as %s -o %t.bc
+; RUN: llvm-spirv %t.bc -o %t.spv
+; RUN: llvm-spirv -r %t.spv -shards=2 -o %t.table
+; RUN: FileCheck %s --check-prefix=CHECK-TABLE < %t.table
+; RUN: llvm-dis %t_0.bc -o - | FileCheck %s --check-prefix=CHECK-SHARD0
+; RUN: llvm-dis %t_1.bc -o - | FileCheck %s --check-prefix=CHECK-SHARD1
+; RUN: llvm-link %t_0.bc %t_1.bc -o - | llvm-dis | FileCheck %s --check-prefix=CHECK-LINKED
+
+; A single shard is the whole module.
+; RUN: llvm-spirv -r %t.spv -shards=1 -o %t.one.table
+; RUN: llvm-spirv -r %t.spv -o %t.ref.bc
+; RUN: llvm-dis < %t.ref.bc > %t.ref.ll
+; RUN: llvm-dis < %t.one_0.bc > %t.one.ll
+; RUN: diff %t.ref.ll %t.one.ll
+
+; RUN: not llvm-spirv %t.bc -shards=2 2>&1 | FileCheck %s --check-prefix=CHECK-ERR
+
+; Modules with debug info are not split.
+; RUN: llvm-as %S/Inputs/reverse-shards-debug.ll -o %t.debug.bc
+; RUN: llvm-spirv %t.debug.bc -o %t.debug.spv
+; RUN: not llvm-spirv -r %t.debug.spv -shards=2 -o %t.debug.table 2>&1 | FileCheck %s --check-prefix=CHECK-DEBUG
+; RUN: llvm-spirv -r %t.debug.spv -shards=1 -o %t.debug.table
+; RUN: llvm-dis %t.debug_0.bc -o - | FileCheck %s --check-prefix=CHECK-DEBUG-ONE
+; RUN: not llvm-spirv -r %t.spv -shards=2 -o - 2>&1 | FileCheck %s --check-prefix=CHECK-ERR-STDOUT
+
+; CHECK-DEBUG: Fails to load SPIR-V as LLVM Module: Modules with debug info cannot be translated to more than one shard
+; CHECK-DEBUG-ONE: define spir_kernel void @k0({{.*}} !dbg
+; CHECK-DEBUG-ONE: define spir_kernel void @k1({{.*}} !dbg
+
+; CHECK-TABLE: {{.*}}_0.bc k1 helper2
+; CHECK-TABLE-NEXT: {{.*}}_1.bc shared k0 helper
+
+; CHECK-SHARD0-NOT: @g =
+; CHECK-SHARD0: @counter = internal addrspace(1) global i32 0
+; CHECK-SHARD0: define spir_kernel void @k1(
+; CHECK-SHARD0: declare spir_func i32 @shared(i32)
+; CHECK-SHARD0: define internal spir_func void @helper2(
+; CHECK-SHARD0-NOT: define
+
+; CHECK-SHARD1-NOT: @counter
+; CHECK-SHARD1: @g = addrspace(1) global i32 7
+; CHECK-SHARD1: define spir_func i32 @shared(i32
+; CHECK-SHARD1: define spir_kernel void @k0(
+; CHECK-SHARD1: define internal spir_func i32 @helper(
+; CHECK-SHARD1-NOT: define
+
+; CHECK-LINKED-DAG: define spir_func i32 @shared(
+; CHECK-LINKED-DAG: define spir_kernel void @k0(
+; CHECK-LINKED-DAG: define spir_kernel void @k1(
+; CHECK-LINKED-DAG: define internal spir_func i32 @helper(
+; CHECK-LINKED-DAG: define internal spir_func void @helper2(
+
+; CHECK-ERR: -shards is only supported for translation of a single SPIR-V file with -r
+; CHECK-ERR-STDOUT: -shards cannot write to standard output
+
+target datalayout = "e-i64:64-v16:16-v24:32-v32:32-v48:64-v96:128-v192:256-v256:256-v512:512-v1024:1024"
+target triple = "spir64-unknown-unknown"
+
+@g = addrspace(1) global i32 7, align 4
+@counter = internal addrspace(1) global i32 0, align 4
+
+define spir_func i32 @shared(i32 %x) {
+entry:
+  %v = load i32, i32 addrspace(1)* @g, align 4
+  %r = add i32 %x, %v
+  ret i32 %r
+}
+
+define spir_kernel void @k0(i32 addrspace(1)* %p) {
+entry:
+  %a = call spir_func i32 @shared(i32 1)
+  %b = call spir_func i32 @helper(i32 %a)
+  store i32 %b, i32 addrspace(1)* %p, align 4
+  ret void
+}
+
+define internal spir_func i32 @helper(i32 %x) {
+entry:
+  %r = mul i32 %x, 3
+  ret i32 %r
+}
+
+define spir_kernel void @k1(i32 addrspace(1)* %p) {
+entry:
+  %id = call spir_func i64 @_Z13get_global_idj(i32 0)
+  %v = trunc i64 %id to i32
+  %a = call spir_func i32 @shared(i32 %v)
+  %c = load i32, i32 addrspace(1)* @counter, align 4
+  %s = add i32 %a, %c
+  %t = mul i32 %s, %v
+  %u = xor i32 %t, %s
+  store i32 %u, i32 addrspace(1)* %p, align 4
+  call spir_func void @helper2(i32 %u)
+  ret void
+}
+
+define internal spir_func void @helper2(i32 %x) {
+entry:
+  %c = load i32, i32 addrspace(1)* @counter, align 4
+  %n = add i32 %c, %x
+  store i32 %n, i32 addrspace(1)* @counter, align 4
+  ret void
+}
+
+declare spir_func i64 @_Z13get_global_idj(i32)
+
+!opencl.spir.version = !{!0}
+!spirv.Source = !{!1}
+
+!0 = !{i32 1, i32 2}
+!1 = !{i32 3, i32 102000}
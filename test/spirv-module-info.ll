@@ -0,0 +1,57 @@
+; RUN: llvm-as %s -o %t.bc
+; RUN: llvm-spirv %t.bc -o %t.spv
+; RUN: llvm-spirv -spirv-module-info %t.spv | FileCheck %s
+; RUN: not llvm-spirv -spirv-module-info %s 2>&1 >/dev/null | FileCheck %s --check-prefix=CHECK-INVALID
+; An OpExecutionMode and an OpGroupDecorate too short for their operands.
+; RUN: %python -c "import struct, sys; sys.stdout.buffer.write(struct.pack('<7I', 0x07230203, 0x10000, 0, 10, 0, 0x20010, 1))" > %t.short-mode.spv
+; RUN: not llvm-spirv -spirv-module-info %t.short-mode.spv 2>&1 >/dev/null | FileCheck %s --check-prefix=CHECK-INVALID
+; RUN: %python -c "import struct, sys; sys.stdout.buffer.write(struct.pack('<6I', 0x07230203, 0x10000, 0, 10, 0, 0x1004a))" > %t.short-group.spv
+; RUN: not llvm-spirv -spirv-module-info %t.short-group.spv 2>&1 >/dev/null | FileCheck %s --check-prefix=CHECK-INVALID
+
+; CHECK-INVALID: Invalid SPIR-V binary{{$}}
+
+; CHECK: Capabilities:{{.*}} 6{{ |$}}
+; CHECK: Number of kernels in the module = 2
+; CHECK: Kernel k1
+; CHECK-NEXT: reqd_work_group_size = 8 4 1
+; CHECK-NEXT: subgroup size = 16
+; CHECK: execution mode 17: 8 4 1
+; CHECK: execution mode 35: 16
+; CHECK: arg 0: name = "a", type = "uint*", type opcode = 32, storage class = 5, attribute = 4
+; CHECK-NEXT: arg 1: name = "img", type = "image2d_t", type opcode = 25, access qualifier = 0
+; CHECK-NEXT: arg 2: name = "n", type = "uint", type opcode = 21
+; CHECK-NEXT: Kernel k2
+; CHECK-NOT: arg
+
+target datalayout = "e-i64:64-v16:16-v24:32-v32:32-v48:64-v96:128-v192:256-v256:256-v512:512-v1024:1024"
+target triple = "spir64-unknown-unknown"
+
+%opencl.image2d_ro_t = type opaque
+
+define spir_func void @helper(i32 addrspace(1)* %p) {
+entry:
+  store i32 0, i32 addrspace(1)* %p, align 4
+  ret void
+}
+
+define spir_kernel void @k1(i32 addrspace(1)* noalias %a, %opencl.image2d_ro_t addrspace(1)* %img, i32 %n) !kernel_arg_addr_space !1 !kernel_arg_access_qual !2 !kernel_arg_type !3 !kernel_arg_base_type !3 !kernel_arg_type_qual !4 !reqd_work_group_size !5 !intel_reqd_sub_group_size !6 {
+entry:
+  call spir_func void @helper(i32 addrspace(1)* %a)
+  ret void
+}
+
+define spir_kernel void @k2() {
+entry:
+  ret void
+}
+
+!opencl.spir.version = !{!0}
+!opencl.ocl.version = !{!0}
+
+!0 = !{i32 1, i32 2}
+!1 = !{i32 1, i32 1, i32 0}
+!2 = !{!"none", !"read_only", !"none"}
+!3 = !{!"uint*", !"image2d_t", !"uint"}
+!4 = !{!"restrict", !"", !""}
+!5 = !{i32 8, i32 4, i32 1}
+!6 = !{i32 16}
@@ -0,0 +1,39 @@
+; Check that -spirv-trace writes one event per instruction with offsets
+; counted in words from the start of the module, for the binary and the text
+; format alike.
+; REQUIRES: spirv-trace
+; RUN: llvm-as %s -o %t.bc
+; RUN: llvm-spirv %t.bc -o %t.spv -spirv-trace=%t.fwd.json
+; RUN: FileCheck %s --check-prefixes=CHECK,CHECK-FWD < %t.fwd.json
+; RUN: llvm-spirv %t.bc -o %t.spt -spirv-text -spirv-trace=%t.txt.json
+; RUN: FileCheck %s --check-prefixes=CHECK,CHECK-FWD < %t.txt.json
+; RUN: llvm-spirv -r %t.spv -o %t.rev.bc -spirv-trace=%t.rev.json
+; RUN: FileCheck %s --check-prefixes=CHECK,CHECK-REV < %t.rev.json
+; RUN: llvm-spirv -to-binary %t.spt -o %t.conv.spv -spirv-trace=%t.conv.json
+; RUN: cmp %t.conv.spv %t.spv
+; RUN: FileCheck %s --check-prefixes=CHECK,CHECK-REV,CHECK-FWD < %t.conv.json
+
+; CHECK: {"capacity":4096,"recorded":[[#]],"events":[
+; CHECK-REV-SAME: {"phase":"decode","opcode":"Capability","id":null,"offset":5},
+; CHECK-REV-SAME: {"phase":"decode","opcode":"Capability","id":null,"offset":7},
+; CHECK-REV-SAME: {"phase":"decode","opcode":"Function","id":[[#]],"offset":[[#]]},
+; CHECK-REV-SAME: {"phase":"decode","opcode":"Return","id":null,"offset":[[#]]}
+; CHECK-FWD-SAME: {"phase":"encode","opcode":"Capability","id":null,"offset":5},
+; CHECK-FWD-SAME: {"phase":"encode","opcode":"Capability","id":null,"offset":7},
+; CHECK-FWD-SAME: {"phase":"encode","opcode":"Function","id":[[#]],"offset":[[#]]},
+; CHECK-FWD-SAME: {"phase":"encode","opcode":"FunctionEnd","id":null,"offset":[[#]]}]}
+
+target datalayout = "e-i64:64-v16:16-v24:32-v32:32-v48:64-v96:128-v192:256-v256:256-v512:512-v1024:1024"
+target triple = "spir64-unknown-unknown"
+
+define spir_kernel void @k(i32 addrspace(1)* %a) {
+entry:
+  store i32 1, i32 addrspace(1)* %a, align 4
+  ret void
+}
+
+!opencl.spir.version = !{!0}
+!spirv.Source = !{!1}
+
+!0 = !{i32 1, i32 2}
+!1 = !{i32 3, i32 102000}
@@ -0,0 +1,96 @@
+; Check that -split translates each kernel, or each group of kernels sharing
+; an attribute value, to its own SPIR-V module holding only what the kernels
+; depend on.
+; RUN: llvm-as %s -o %t.bc
+; RUN: llvm-spirv %t.bc -split=per-kernel -o %t.table
+; RUN: FileCheck %s --check-prefix=CHECK-TABLE < %t.table
+; RUN: spirv-val %t_0.spv
+; RUN: spirv-val %t_1.spv
+; RUN: spirv-val %t_2.spv
+; RUN: llvm-spirv -r %t_0.spv -o - | llvm-dis | FileCheck %s --check-prefix=CHECK-K1
+; RUN: llvm-spirv -r %t_1.spv -o - | llvm-dis | FileCheck %s --check-prefix=CHECK-K2
+; RUN: llvm-spirv -r %t_2.spv -o - | llvm-dis | FileCheck %s --check-prefix=CHECK-K3
+
+; RUN: llvm-spirv %t.bc -split=by-attribute -o %t.group.table
+; RUN: FileCheck %s --check-prefix=CHECK-GROUP < %t.group.table
+; RUN: llvm-spirv -r %t.group_0.spv -o - | llvm-dis | FileCheck %s --check-prefix=CHECK-G0
+; RUN: not llvm-spirv %t.bc -split=per-kernel -r 2>&1 | FileCheck %s --check-prefix=CHECK-ERR
+
+; CHECK-TABLE: {{.*}}_0.spv k1{{$}}
+; CHECK-TABLE-NEXT: {{.*}}_1.spv k2{{$}}
+; CHECK-TABLE-NEXT: {{.*}}_2.spv k3{{$}}
+; CHECK-TABLE-NOT: spv
+
+; CHECK-K1: @g1 = addrspace(1) global i32 1
+; CHECK-K1-NOT: @g2
+; CHECK-K1: define spir_func i32 @helper(
+; CHECK-K1: define spir_kernel void @k1(
+; CHECK-K1-NOT: define
+
+; CHECK-K2-NOT: @g1
+; CHECK-K2: @g2 = addrspace(1) global i32 2
+; CHECK-K2-NOT: @helper
+; CHECK-K2: define spir_kernel void @k2(
+; CHECK-K2-SAME: !reqd_work_group_size
+; CHECK-K2-NOT: define
+
+; CHECK-K3-NOT: @g2
+; CHECK-K3: define spir_func i32 @helper(
+; CHECK-K3: define spir_kernel void @k3(
+; CHECK-K3-NOT: define
+
+; CHECK-GROUP: {{.*}}_0.spv k1 k3{{$}}
+; CHECK-GROUP-NEXT: {{.*}}_1.spv k2{{$}}
+; CHECK-GROUP-NOT: spv
+
+; CHECK-G0-NOT: @g2
+; CHECK-G0: define spir_func i32 @helper(
+; CHECK-G0: define spir_kernel void @k1(
+; CHECK-G0: define spir_kernel void @k3(
+; CHECK-G0-NOT: define
+
+; CHECK-ERR: -split is only supported for translation of a single LLVM bitcode file
+
+target datalayout = "e-i64:64-v16:16-v24:32-v32:32-v48:64-v96:128-v192:256-v256:256-v512:512-v1024:1024"
+target triple = "spir64-unknown-unknown"
+
+@g1 = addrspace(1) global i32 1, align 4
+@g2 = addrspace(1) global i32 2, align 4
+
+define spir_func i32 @helper() {
+entry:
+  %v = load i32, i32 addrspace(1)* @g1, align 4
+  ret i32 %v
+}
+
+define spir_kernel void @k1(i32 addrspace(1)* %a) #0 {
+entry:
+  %v = call spir_func i32 @helper()
+  store i32 %v, i32 addrspace(1)* %a, align 4
+  ret void
+}
+
+define spir_kernel void @k2(i32 addrspace(1)* %a) #1 !reqd_work_group_size !2 {
+entry:
+  %v = load i32, i32 addrspace(1)* @g2, align 4
+  store i32 %v, i32 addrspace(1)* %a, align 4
+  ret void
+}
+
+define spir_kernel void @k3(i32 addrspace(1)* %a) #0 {
+entry:
+  %v = call spir_func i32 @helper()
+  %w = add i32 %v, 1
+  store i32 %w, i32 addrspace(1)* %a, align 4
+  ret void
+}
+
+attributes #0 = { "sycl-module-id"="a.cpp" }
+attributes #1 = { "sycl-module-id"="b.cpp" }
+
+!opencl.spir.version = !{!0}
+!spirv.Source = !{!1}
+
+!0 = !{i32 1, i32 2}
+!1 = !{i32 3, i32 102000}
+!2 = !{i32 8, i32 1, i32 1}
@@ -0,0 +1,72 @@
+; Check that encoding function bodies as soon as they are translated doesn't
+; change the SPIR-V module, in both the binary and the textual format. The
+; kernel is translated first but calls functions defined after it, so bodies
+; are finished in a different order than they are written.
+; RUN: llvm-as %s -o %t.bc
+; RUN: llvm-spirv %t.bc -o %t.ref.spv
+; RUN: llvm-spirv %t.bc -o %t.spv -spirv-stream-functions
+; RUN: cmp %t.ref.spv %t.spv
+; RUN: llvm-spirv %t.bc -spirv-text -o %t.ref.spt
+; RUN: llvm-spirv %t.bc -spirv-text -o %t.spt -spirv-stream-functions
+; RUN: cmp %t.ref.spt %t.spt
+; RUN: llvm-spirv %t.bc -o %t.stats.spv -spirv-stream-functions -translation-stats-json=%t.json
+; RUN: llvm-spirv %t.bc -o %t.stats.ref.spv -translation-stats-json=%t.ref.json
+; RUN: cat %t.ref.json %t.json | FileCheck %s
+; RUN: spirv-val %t.spv
+; RUN: llvm-spirv -r %t.spv -o - | llvm-dis | FileCheck %s --check-prefix=CHECK-LLVM
+
+; CHECK: "counters":{"instructions":[[#INSTS:]],
+; CHECK: "counters":{"instructions":[[#INSTS]],
+
+; CHECK-LLVM: define spir_kernel void @k(
+; CHECK-LLVM: %tmp = alloca float, align 16
+; CHECK-LLVM: call spir_func float @sum(
+; CHECK-LLVM: define spir_func float @sum(
+; CHECK-LLVM: %acc = phi float
+; CHECK-LLVM: fadd fast float
+; CHECK-LLVM: define spir_func float @scale(
+
+target datalayout = "e-i64:64-v16:16-v24:32-v32:32-v48:64-v96:128-v192:256-v256:256-v512:512-v1024:1024"
+target triple = "spir64-unknown-unknown"
+
+define spir_kernel void @k(float addrspace(1)* %p, i32 %n) {
+entry:
+  %tmp = alloca float, align 16
+  %s = call spir_func float @sum(float addrspace(1)* %p, i32 %n)
+  store float %s, float* %tmp, align 16
+  %v = load float, float* %tmp, align 16
+  %r = call spir_func float @scale(float %v)
+  store float %r, float addrspace(1)* %p, align 4
+  ret void
+}
+
+define spir_func float @sum(float addrspace(1)* %p, i32 %n) {
+entry:
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %loop ]
+  %acc = phi float [ 0.0, %entry ], [ %acc.next, %loop ]
+  %idx = sext i32 %i to i64
+  %ptr = getelementptr inbounds float, float addrspace(1)* %p, i64 %idx
+  %x = load float, float addrspace(1)* %ptr, align 4
+  %acc.next = fadd fast float %acc, %x
+  %i.next = add nsw i32 %i, 1
+  %cmp = icmp slt i32 %i.next, %n
+  br i1 %cmp, label %loop, label %exit
+
+exit:
+  ret float %acc.next
+}
+
+define spir_func float @scale(float %x) {
+entry:
+  %y = fmul float %x, 2.0
+  ret float %y
+}
+
+!opencl.spir.version = !{!0}
+!spirv.Source = !{!1}
+
+!0 = !{i32 1, i32 2}
+!1 = !{i32 3, i32 102000}
@@ -0,0 +1,42 @@
+; Check that repeated elements of data arrays and vectors share a single
+; OpConstant, also with scalar uses of the same value.
+; RUN: llvm-as %s -o %t.bc
+; RUN: llvm-spirv %t.bc -o %t.spv
+; RUN: llvm-spirv %t.spv -to-text -o - | FileCheck %s --check-prefix=CHECK-SPIRV
+; RUN: llvm-spirv -r %t.spv -o %t.rev.bc
+; RUN: llvm-dis < %t.rev.bc | FileCheck %s --check-prefix=CHECK-LLVM
+
+; CHECK-SPIRV-DAG: TypeInt [[i16:[0-9]+]] 16 0
+; CHECK-SPIRV-DAG: TypeFloat [[f32:[0-9]+]] 32
+; CHECK-SPIRV-DAG: Constant [[i16]] [[One:[0-9]+]] 1
+; CHECK-SPIRV-DAG: Constant [[i16]] [[Two:[0-9]+]] 2
+; CHECK-SPIRV-DAG: Constant [[f32]] [[Half:[0-9]+]] 1056964608
+; CHECK-SPIRV-NOT: Constant [[i16]] {{[0-9]+}} 1{{$}}
+; CHECK-SPIRV-NOT: Constant [[i16]] {{[0-9]+}} 2{{$}}
+; CHECK-SPIRV-NOT: Constant [[f32]] {{[0-9]+}} 1056964608
+; CHECK-SPIRV: ConstantComposite {{[0-9]+}} {{[0-9]+}} [[One]] [[Two]] [[One]] [[Two]]
+; CHECK-SPIRV: ConstantComposite {{[0-9]+}} {{[0-9]+}} [[Half]] [[Half]]
+
+; CHECK-LLVM: @i16_arr = {{.*}}constant [4 x i16] [i16 1, i16 2, i16 1, i16 2]
+; CHECK-LLVM: @f32_vec = {{.*}}constant <2 x float> <float 5.000000e-01, float 5.000000e-01>
+; CHECK-LLVM: store i16 2,
+; CHECK-LLVM: store float 5.000000e-01,
+
+target datalayout = "e-i64:64-v16:16-v24:32-v32:32-v48:64-v96:128-v192:256-v256:256-v512:512-v1024:1024"
+target triple = "spir64-unknown-unknown"
+
+@i16_arr = addrspace(1) constant [4 x i16] [i16 1, i16 2, i16 1, i16 2]
+@f32_vec = addrspace(1) constant <2 x float> <float 0.5, float 0.5>
+
+define spir_kernel void @test(i16 addrspace(1)* %a, float addrspace(1)* %b) {
+entry:
+  store i16 2, i16 addrspace(1)* %a, align 2
+  store float 0.5, float addrspace(1)* %b, align 4
+  ret void
+}
+
+!opencl.spir.version = !{!0}
+!spirv.Source = !{!1}
+
+!0 = !{i32 1, i32 2}
+!1 = !{i32 3, i32 102000}
@@ -0,0 +1,33 @@
+; Check that arrays and vectors of scalar constants survive the round trip,
+; both when all elements are plain constants and when some are not.
+; RUN: llvm-as %s -o %t.bc
+; RUN: llvm-spirv %t.bc -o %t.spv
+; RUN: llvm-spirv -r %t.spv -o %t.rev.bc
+; RUN: llvm-dis < %t.rev.bc | FileCheck %s --check-prefix=CHECK-LLVM
+
+; CHECK-LLVM: @i16_arr = {{.*}}addrspace(1) constant [4 x i16] [i16 1, i16 -2, i16 3, i16 -4]
+; CHECK-LLVM: @i64_arr = {{.*}}addrspace(1) constant [3 x i64] [i64 1, i64 -1, i64 4294967296]
+; CHECK-LLVM: @f32_arr = {{.*}}addrspace(1) constant [3 x float] [float 1.000000e+00, float -2.500000e+00, float 0.000000e+00]
+; CHECK-LLVM: @f64_arr = {{.*}}addrspace(1) constant [2 x double] [double 1.000000e-01, double 2.000000e+00]
+; CHECK-LLVM: @f16_vec = {{.*}}addrspace(1) constant <4 x half> <half 0xH3C00, half 0xH4000, half 0xH0000, half 0xHBC00>
+; CHECK-LLVM: @i8_vec = {{.*}}addrspace(1) constant <2 x i8> <i8 -1, i8 7>
+; CHECK-LLVM: @zero_arr = {{.*}}addrspace(1) constant [2 x i32] zeroinitializer
+; CHECK-LLVM: @mixed_arr = {{.*}}addrspace(1) constant [3 x i32] [i32 1, i32 undef, i32 3]
+
+target datalayout = "e-i64:64-v16:16-v24:32-v32:32-v48:64-v96:128-v192:256-v256:256-v512:512-v1024:1024"
+target triple = "spir64-unknown-unknown"
+
+@i16_arr = addrspace(1) constant [4 x i16] [i16 1, i16 -2, i16 3, i16 -4]
+@i64_arr = addrspace(1) constant [3 x i64] [i64 1, i64 -1, i64 4294967296]
+@f32_arr = addrspace(1) constant [3 x float] [float 1.0, float -2.5, float 0.0]
+@f64_arr = addrspace(1) constant [2 x double] [double 0.1, double 2.0]
+@f16_vec = addrspace(1) constant <4 x half> <half 1.0, half 2.0, half 0.0, half -1.0>
+@i8_vec = addrspace(1) constant <2 x i8> <i8 -1, i8 7>
+@zero_arr = addrspace(1) constant [2 x i32] zeroinitializer
+@mixed_arr = addrspace(1) constant [3 x i32] [i32 1, i32 undef, i32 3]
+
+!opencl.spir.version = !{!0}
+!spirv.Source = !{!1}
+
+!0 = !{i32 1, i32 2}
+!1 = !{i32 3, i32 102000}
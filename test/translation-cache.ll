@@ -0,0 +1,47 @@
+; Check that the translation cache reuses results in both directions and that
+; cached results are identical to fresh ones. Results to SPIR-V are stored at
+; every verification level but not reused with -spirv-verify=per-pass, which
+; verifies the passes of the translation. Cached LLVM modules are verified.
+; RUN: rm -rf %t.cache
+; RUN: llvm-as %s -o %t.bc
+; RUN: llvm-spirv %t.bc -o %t.ref.spv
+; RUN: llvm-spirv %t.bc -o %t.1.spv -translation-cache=%t.cache -translation-cache-stats 2>&1 | FileCheck %s --check-prefix=CHECK-MISS
+; RUN: llvm-spirv %t.bc -o %t.2.spv -translation-cache=%t.cache -translation-cache-stats 2>&1 | FileCheck %s --check-prefix=CHECK-HIT
+; RUN: llvm-spirv %t.bc -o %t.3.spv -spirv-verify=none -translation-cache=%t.cache -translation-cache-stats 2>&1 | FileCheck %s --check-prefix=CHECK-HIT
+; RUN: llvm-spirv %t.bc -o %t.4.spv -spirv-verify=per-pass -translation-cache=%t.cache -translation-cache-stats 2>&1 | FileCheck %s --check-prefix=CHECK-BYPASS
+; RUN: cmp %t.ref.spv %t.1.spv
+; RUN: cmp %t.ref.spv %t.2.spv
+; RUN: cmp %t.ref.spv %t.3.spv
+; RUN: cmp %t.ref.spv %t.4.spv
+
+; Options that change the result must not share cache entries, including
+; command line options of the library that are not translator options.
+; RUN: llvm-spirv %t.bc -o %t.5.spv -spirv-max-version=1.0 -translation-cache=%t.cache -translation-cache-stats 2>&1 | FileCheck %s --check-prefix=CHECK-MISS
+; RUN: llvm-spirv %t.bc -o %t.6.spv -spirv-lower-const-expr=false -translation-cache=%t.cache -translation-cache-stats 2>&1 | FileCheck %s --check-prefix=CHECK-MISS
+
+; RUN: llvm-spirv -r %t.ref.spv -o %t.ref.rev.bc
+; RUN: llvm-spirv -r %t.ref.spv -o %t.1.rev.bc -translation-cache=%t.cache -translation-cache-stats 2>&1 | FileCheck %s --check-prefix=CHECK-MISS
+; RUN: llvm-spirv -r %t.ref.spv -o %t.2.rev.bc -translation-cache=%t.cache -translation-cache-stats 2>&1 | FileCheck %s --check-prefix=CHECK-HIT
+; RUN: llvm-spirv -r %t.ref.spv -o %t.3.rev.bc -spirv-verify=none -translation-cache=%t.cache -translation-cache-stats 2>&1 | FileCheck %s --check-prefix=CHECK-HIT
+; RUN: llvm-spirv -r %t.ref.spv -o %t.4.rev.bc -spirv-expand-step=false -translation-cache=%t.cache -translation-cache-stats 2>&1 | FileCheck %s --check-prefix=CHECK-MISS
+; RUN: cmp %t.ref.rev.bc %t.2.rev.bc
+; RUN: cmp %t.ref.rev.bc %t.3.rev.bc
+
+; CHECK-MISS: Translation cache: 0 hits, 1 misses
+; CHECK-HIT: Translation cache: 1 hits, 0 misses
+; CHECK-BYPASS: Translation cache: 0 hits, 0 misses
+
+target datalayout = "e-i64:64-v16:16-v24:32-v32:32-v48:64-v96:128-v192:256-v256:256-v512:512-v1024:1024"
+target triple = "spir64-unknown-unknown"
+
+define spir_kernel void @k(i32 addrspace(1)* %a, i32 %n) {
+entry:
+  store i32 %n, i32 addrspace(1)* %a, align 4
+  ret void
+}
+
+!opencl.spir.version = !{!0}
+!spirv.Source = !{!1}
+
+!0 = !{i32 1, i32 2}
+!1 = !{i32 3, i32 102000}
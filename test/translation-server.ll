@@ -0,0 +1,64 @@
+; Check that a translation server produces the same results as translation
+; in the client process, and that failing or malformed requests do not stop
+; it.
+; UNSUPPORTED: system-windows
+; RUN: llvm-as %s -o %t.bc
+; RUN: llvm-spirv %t.bc -o %t.ref.spv
+; RUN: llvm-spirv -r %t.ref.spv -o %t.ref.rev.bc
+; RUN: llvm-spirv %t.bc -spirv-text -o %t.ref.spt
+; RUN: cp %s %t.bad.spv
+; RUN: rm -rf %t.dir && mkdir %t.dir
+; The server is always shut down, so failures are detected by the checks of
+; the results below.
+; RUN: cd %t.dir && llvm-spirv -serve=server.sock & \
+; RUN: cd %t.dir; %python %S/Inputs/translation-server-frame.py server.sock \
+; RUN:     oversized > %t.frame.txt; \
+; RUN:   %python %S/Inputs/translation-server-frame.py server.sock \
+; RUN:     garbage >> %t.frame.txt; \
+; RUN:   llvm-spirv -client=server.sock %t.bc -o %t.spv; \
+; RUN:   llvm-spirv -client=server.sock %t.bc -spirv-text -o %t.spt; \
+; RUN:   llvm-spirv -client=server.sock -r %t.spv -o %t.rev.bc; \
+; RUN:   llvm-spirv -client=server.sock -r %t.bad.spv 2> %t.bad.txt; \
+; RUN:   echo "exit code $?" >> %t.bad.txt; \
+; RUN:   llvm-spirv -client=server.sock -spirv-lower-const-expr=false %t.bc \
+; RUN:     -o %t.flags.spv 2> %t.flags.txt; \
+; RUN:   echo "exit code $?" >> %t.flags.txt; \
+; RUN:   llvm-spirv -client=server.sock -serve-shutdown; wait
+; RUN: cmp %t.ref.spv %t.spv
+; RUN: cmp %t.ref.spt %t.spt
+; RUN: llvm-dis < %t.ref.rev.bc > %t.ref.rev.ll
+; RUN: llvm-dis < %t.rev.bc > %t.rev.ll
+; RUN: diff %t.ref.rev.ll %t.rev.ll
+; RUN: FileCheck %s --check-prefix=CHECK-BAD < %t.bad.txt
+; RUN: FileCheck %s --check-prefix=CHECK-FRAME < %t.frame.txt
+; RUN: FileCheck %s --check-prefix=CHECK-FLAGS < %t.flags.txt
+
+; RUN: not llvm-spirv -client=server.sock -s %t.bc 2>&1 | FileCheck %s --check-prefix=CHECK-MODE
+
+; CHECK-BAD: Fails to load SPIR-V as LLVM Module: InvalidModule: Invalid SPIR-V module: invalid magic number
+; CHECK-BAD-NEXT: exit code 255
+; Malformed frames are answered with an error, and the server keeps serving
+; the requests which follow.
+; CHECK-FRAME: Translation server request exceeds 1073741824 bytes
+; CHECK-FRAME-NEXT: exit code -1
+; CHECK-FRAME-NEXT: Invalid translation server request
+; CHECK-FRAME-NEXT: exit code -1
+; CHECK-FLAGS: Translation flags of the client (-spirv-lower-const-expr=false) differ from those of the translation server (none)
+; CHECK-FLAGS-NEXT: exit code 255
+; CHECK-MODE: Only translation of a single input file can be done by a translation server
+
+target datalayout = "e-i64:64-v16:16-v24:32-v32:32-v48:64-v96:128-v192:256-v256:256-v512:512-v1024:1024"
+target triple = "spir64-unknown-unknown"
+
+define spir_kernel void @k(float addrspace(1)* %a, float %x) {
+entry:
+  %m = fmul float %x, %x
+  store float %m, float addrspace(1)* %a, align 4
+  ret void
+}
+
+!opencl.spir.version = !{!0}
+!spirv.Source = !{!1}
+
+!0 = !{i32 1, i32 2}
+!1 = !{i32 3, i32 102000}
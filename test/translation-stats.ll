@@ -0,0 +1,58 @@
+; Check that -translation-stats-json reports translation phases and module
+; counters in both directions without changing the result.
+; RUN: llvm-as %s -o %t.bc
+; RUN: llvm-spirv %t.bc -o %t.ref.spv
+; RUN: llvm-spirv %t.bc -o %t.spv -translation-stats-json=%t.fwd.json
+; RUN: cmp %t.ref.spv %t.spv
+; RUN: FileCheck %s --check-prefix=CHECK-FWD < %t.fwd.json
+
+; RUN: llvm-spirv -r %t.spv -o %t.ref.rev.bc
+; RUN: llvm-spirv -r %t.spv -o %t.rev.bc -translation-stats-json=%t.rev.json
+; RUN: cmp %t.ref.rev.bc %t.rev.bc
+; RUN: FileCheck %s --check-prefix=CHECK-REV < %t.rev.json
+
+; RUN: not llvm-spirv -s %t.bc -translation-stats-json=%t.json 2>&1 | FileCheck %s --check-prefix=CHECK-ERR
+; RUN: not llvm-spirv %t.bc -spirv-debug-sidecar=%t.dbg.spv -translation-stats-json=%t.json 2>&1 | FileCheck %s --check-prefix=CHECK-ERR-SIDECAR
+
+; CHECK-FWD: {"phases":{"read-bitcode":{{[0-9.e+-]+}},
+; CHECK-FWD-SAME: "pass:preprocess-metadata":
+; CHECK-FWD-SAME: "pass:ocl-to-spv":
+; CHECK-FWD-SAME: "pass:spv-lower-llvm_sadd_with_overflow":
+; CHECK-FWD-SAME: "llvm-to-spirv":
+; CHECK-FWD-SAME: "topological-sort":
+; CHECK-FWD-SAME: "encode":
+; CHECK-FWD-SAME: "counters":{"instructions":{{[1-9][0-9]*}},"ids":{{[1-9][0-9]*}},"types":{{[1-9][0-9]*}},"constants":{{[0-9]+}},
+; CHECK-FWD-SAME: "builtin_name_misses":{{[1-9][0-9]*}},"bytes_in":{{[1-9][0-9]*}},"bytes_out":{{[1-9][0-9]*}}}}
+
+; CHECK-REV: {"phases":{"decode":
+; CHECK-REV-SAME: "variables":
+; CHECK-REV-SAME: "debug-info":
+; CHECK-REV-SAME: "functions":
+; CHECK-REV-SAME: "metadata":
+; CHECK-REV-SAME: "post-process-ocl":
+; CHECK-REV-SAME: "verify":
+; CHECK-REV-SAME: "write-bitcode":
+; CHECK-REV-SAME: "counters":{"instructions":{{[1-9][0-9]*}},"ids":{{[1-9][0-9]*}},"types":{{[1-9][0-9]*}},"constants":{{[0-9]+}},
+; CHECK-REV-SAME: "bytes_in":{{[1-9][0-9]*}},"bytes_out":{{[1-9][0-9]*}}}}
+
+; CHECK-ERR: -translation-stats-json is only supported for translation of a single input file
+; CHECK-ERR-SIDECAR: Cannot use -translation-stats-json with -client, -spirv-debug-sidecar
+
+target datalayout = "e-i64:64-v16:16-v24:32-v32:32-v48:64-v96:128-v192:256-v256:256-v512:512-v1024:1024"
+target triple = "spir64-unknown-unknown"
+
+define spir_kernel void @k(i32 addrspace(1)* %a) {
+entry:
+  %id = call spir_func i64 @_Z13get_global_idj(i32 0)
+  %v = trunc i64 %id to i32
+  store i32 %v, i32 addrspace(1)* %a, align 4
+  ret void
+}
+
+declare spir_func i64 @_Z13get_global_idj(i32)
+
+!opencl.spir.version = !{!0}
+!spirv.Source = !{!1}
+
+!0 = !{i32 1, i32 2}
+!1 = !{i32 3, i32 102000}
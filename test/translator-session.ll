@@ -0,0 +1,49 @@
+; Check that files translated by one session give the same result as
+; translated one by one, and that the builtin names seen in the first file
+; are not demangled again for the others, on both translation paths.
+; RUN: rm -rf %t.dir && mkdir -p %t.dir
+; RUN: llvm-as %s -o %t.dir/a.bc
+; RUN: cp %t.dir/a.bc %t.dir/b.bc
+; RUN: llvm-spirv %t.dir/a.bc -o %t.ref.spv
+; RUN: echo "%t.dir/a.bc" > %t.one.list
+; RUN: llvm-spirv -j 1 -input-list=%t.one.list -translation-cache-stats 2>&1 | FileCheck %s
+; RUN: llvm-spirv -j 1 -input-list=%t.one.list -translation-cache-stats 2>&1 | sed -n 's/.* hits, \(.*\) misses/\1/p' > %t.one.misses
+; RUN: llvm-spirv -j 1 %t.dir/a.bc %t.dir/b.bc -translation-cache-stats 2>&1 | sed -n 's/.* hits, \(.*\) misses/\1/p' > %t.two.misses
+; RUN: cmp %t.one.misses %t.two.misses
+; RUN: cmp %t.ref.spv %t.dir/a.spv
+; RUN: cmp %t.ref.spv %t.dir/b.spv
+
+; RUN: cp %t.ref.spv %t.dir/b.spv
+; RUN: llvm-spirv -r %t.ref.spv -o %t.ref.bc
+; RUN: echo "%t.dir/a.spv" > %t.one.rev.list
+; RUN: llvm-spirv -r -j 1 -input-list=%t.one.rev.list -translation-cache-stats 2>&1 | FileCheck %s
+; RUN: llvm-spirv -r -j 1 -input-list=%t.one.rev.list -translation-cache-stats 2>&1 | sed -n 's/.* hits, \(.*\) misses/\1/p' > %t.one.rev.misses
+; RUN: llvm-spirv -r -j 1 %t.dir/a.spv %t.dir/b.spv -translation-cache-stats 2>&1 | sed -n 's/.* hits, \(.*\) misses/\1/p' > %t.two.rev.misses
+; RUN: cmp %t.one.rev.misses %t.two.rev.misses
+; RUN: llvm-dis < %t.ref.bc > %t.ref.ll
+; RUN: llvm-dis < %t.dir/a.bc > %t.a.ll
+; RUN: llvm-dis < %t.dir/b.bc > %t.b.ll
+; RUN: diff %t.ref.ll %t.a.ll
+; RUN: diff %t.ref.ll %t.b.ll
+
+; CHECK: Builtin name cache: {{[0-9]+}} hits, {{[1-9][0-9]*}} misses
+
+target datalayout = "e-i64:64-v16:16-v24:32-v32:32-v48:64-v96:128-v192:256-v256:256-v512:512-v1024:1024"
+target triple = "spir64-unknown-unknown"
+
+define spir_kernel void @k(i32 addrspace(1)* %a, i32 %n) {
+entry:
+  %m = call spir_func i32 @_Z3minii(i32 %n, i32 7)
+  call spir_func void @_Z7barrierj(i32 1)
+  store i32 %m, i32 addrspace(1)* %a, align 4
+  ret void
+}
+
+declare spir_func i32 @_Z3minii(i32, i32)
+declare spir_func void @_Z7barrierj(i32)
+
+!opencl.spir.version = !{!0}
+!spirv.Source = !{!1}
+
+!0 = !{i32 1, i32 2}
+!1 = !{i32 3, i32 102000}
@@ -0,0 +1,67 @@
+; Check that the verification level does not change the result of the
+; translation, that -spirv-verify=none skips verification of the result and
+; that -spirv-verify=per-pass reports the pass after which verification fails.
+; RUN: llvm-as %s -o %t.bc
+; RUN: llvm-spirv %t.bc -o %t.ref.spv
+; RUN: llvm-spirv %t.bc -o %t.none.spv -spirv-verify=none
+; RUN: llvm-spirv %t.bc -o %t.pp.spv -spirv-verify=per-pass -translation-stats-json=%t.fwd.json
+; RUN: cmp %t.ref.spv %t.none.spv
+; RUN: cmp %t.ref.spv %t.pp.spv
+; RUN: FileCheck %s --check-prefix=CHECK-FWD < %t.fwd.json
+
+; RUN: llvm-spirv -r %t.ref.spv -o %t.ref.bc
+; RUN: llvm-spirv -r %t.ref.spv -o %t.none.bc -spirv-verify=none -translation-stats-json=%t.none.json
+; RUN: llvm-spirv -r %t.ref.spv -o %t.pp.bc -spirv-verify=per-pass
+; RUN: cmp %t.ref.bc %t.none.bc
+; RUN: cmp %t.ref.bc %t.pp.bc
+; RUN: FileCheck %s --check-prefix=CHECK-NONE < %t.none.json
+
+; RUN: llvm-spirv -s %t.bc -o %t.reg.bc -spirv-verify=per-pass
+; RUN: llvm-dis %t.reg.bc -o - | FileCheck %s --check-prefix=CHECK-REG
+
+; A broken module fails with -spirv-verify=per-pass at the first verified
+; pass.
+; RUN: llvm-as -disable-verify %S/Inputs/verification-level-broken.ll -o %t.broken.bc
+; RUN: not llvm-spirv %t.broken.bc -o %t.broken.spv -spirv-verify=per-pass 2>&1 \
+; RUN:   | FileCheck %s --check-prefix=CHECK-BROKEN
+
+; CHECK-BROKEN: Fails to save LLVM as SPIR-V: Fails to verify module after preprocess-metadata: Instruction does not dominate all uses!
+
+; CHECK-FWD: "pass:preprocess-metadata":
+; CHECK-FWD-SAME: "pass:spvbool":
+; CHECK-FWD-SAME: "pass:loop-simplify":
+; CHECK-FWD-SAME: "llvm-to-spirv":
+
+; CHECK-NONE: "debug-info-finalize":
+; CHECK-NONE-NOT: "verify":
+; CHECK-NONE: "write-bitcode":
+
+; CHECK-REG: define spir_kernel void @k(
+
+target datalayout = "e-i64:64-v16:16-v24:32-v32:32-v48:64-v96:128-v192:256-v256:256-v512:512-v1024:1024"
+target triple = "spir64-unknown-unknown"
+
+define spir_kernel void @k(i32 addrspace(1)* %a, i32 %n) {
+entry:
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %next, %loop ]
+  %c = icmp slt i32 %i, %n
+  %v = select i1 %c, i32 %i, i32 %n
+  store i32 %v, i32 addrspace(1)* %a, align 4
+  %next = add nsw i32 %i, 1
+  %done = icmp eq i32 %next, %n
+  br i1 %done, label %exit, label %loop, !llvm.loop !2
+
+exit:
+  ret void
+}
+
+!opencl.spir.version = !{!0}
+!spirv.Source = !{!1}
+
+!0 = !{i32 1, i32 2}
+!1 = !{i32 3, i32 102000}
+!2 = distinct !{!2, !3}
+!3 = !{!"llvm.loop.unroll.enable"}
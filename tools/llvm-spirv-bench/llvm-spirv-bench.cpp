@@ -0,0 +1,839 @@
+//===-- llvm-spirv-bench.cpp - LLVM/SPIR-V translator benchmark -*- C++ -*-===//
+//
+//                     The LLVM/SPIRV Translator
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+// Copyright (c) 2021 Intel Corporation. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal with the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimers.
+// Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimers in the documentation
+// and/or other materials provided with the distribution.
+// Neither the names of Advanced Micro Devices, Inc., nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// Software without specific prior written permission.
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH
+// THE SOFTWARE.
+//
+//===----------------------------------------------------------------------===//
+/// \file
+///
+///  Measures the throughput of the translator on generated modules.
+///
+///  llvm-spirv-bench builds a synthetic OpenCL module of -kernels kernels with
+///  at least -instructions instructions each. The kernels work on a struct type
+///  nested -struct-depth levels deep, read constant tables of
+///  -constant-table elements and call OpenCL builtins for about
+///  -builtin-percent of the instructions. -g adds debug info.
+///
+///  Forward translation, reverse translation and conversion of SPIR-V to the
+///  internal text format and back are each run -iterations times. The report
+///  is a JSON object with the wall time of every run, instructions per second
+///  of the fastest run and the peak resident set size of each benchmark.
+///
+///  Common Usage:
+///  llvm-spirv-bench -kernels=64 -instructions=5000 -g -o report.json
+///  llvm-spirv-bench -emit-module=big.bc - Also save the generated module
+///
+//===----------------------------------------------------------------------===//
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Bitcode/BitcodeReader.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
+#include "llvm/IR/CallingConv.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/DIBuilder.h"
+#include "llvm/IR/DerivedTypes.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IR/Verifier.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/PrettyStackTrace.h"
+#include "llvm/Support/Signals.h"
+#include "llvm/Support/raw_ostream.h"
+
+#ifndef _SPIRV_SUPPORT_TEXT_FMT
+#define _SPIRV_SUPPORT_TEXT_FMT
+#endif
+
+#include "LLVMSPIRVLib.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef LLVM_ON_UNIX
+#include <sys/resource.h>
+#endif
+
+using namespace llvm;
+
+static cl::opt<unsigned> NumKernels("kernels", cl::init(8),
+                                    cl::desc("Number of kernels to generate"));
+
+static cl::opt<unsigned>
+    NumInstructions("instructions", cl::init(2000),
+                    cl::desc("Minimum number of instructions per kernel"));
+
+static cl::opt<unsigned>
+    StructDepth("struct-depth", cl::init(8),
+                cl::desc("Nesting depth of the struct type used by kernels"));
+
+static cl::opt<unsigned> ConstantTableSize(
+    "constant-table", cl::init(1024),
+    cl::desc("Number of elements of each of the constant tables"));
+
+static cl::opt<unsigned> BuiltinPercent(
+    "builtin-percent", cl::init(25),
+    cl::desc("Percentage of instructions which are builtin calls"));
+
+static cl::opt<bool> GenerateDebugInfo("g", cl::init(false),
+                                       cl::desc("Generate debug info"));
+
+static cl::opt<unsigned> Seed("seed", cl::init(1),
+                              cl::desc("Seed of the module generator"));
+
+static cl::opt<unsigned> Iterations("iterations", cl::init(3),
+                                    cl::desc("Number of runs of each "
+                                             "benchmark"));
+
+static cl::list<std::string>
+    Benchmarks("benchmarks", cl::CommaSeparated,
+               cl::desc("Benchmarks to run: forward, reverse, text. All of "
+                        "them by default"),
+               cl::value_desc("name,..."));
+
+static cl::opt<std::string>
+    EmitModuleFile("emit-module",
+                   cl::desc("Write the generated module to the file"),
+                   cl::value_desc("file"));
+
+static cl::opt<std::string> OutputFile("o", cl::init("-"),
+                                       cl::desc("Write the report to the file"),
+                                       cl::value_desc("file"));
+
+namespace {
+
+// Builds the synthetic module described by the command line options. The
+// module only depends on the options, so runs with the same options measure
+// the same input on every host.
+class SyntheticModuleBuilder {
+public:
+  explicit SyntheticModuleBuilder(LLVMContext &C)
+      : C(C), Rng(Seed), M(new Module("synthetic", C)) {}
+
+  std::unique_ptr<Module> build();
+
+private:
+  typedef IRBuilder<ConstantFolder, IRBuilderCallbackInserter> BuilderTy;
+
+  // Values a kernel has computed so far and the arguments it works on.
+  struct KernelState {
+    Value *Out = nullptr;
+    Value *FloatOut = nullptr;
+    Value *StructPtr = nullptr;
+    Value *Size = nullptr;
+    Value *StructVal = nullptr;
+    std::vector<Value *> Ints;
+    std::vector<Value *> Floats;
+    DILocalVariable *IntVar = nullptr;
+    DILocalVariable *FloatVar = nullptr;
+  };
+
+  void buildTypes();
+  void buildConstantTables();
+  void buildKernel(unsigned Index);
+  void emitStep(BuilderTy &B, KernelState &S);
+  void emitBuiltinCall(BuilderTy &B, KernelState &S);
+  void emitBranch(BuilderTy &B, KernelState &S);
+  Value *emitTableLoad(BuilderTy &B, KernelState &S, GlobalVariable *Table);
+  Value *emitIndex(BuilderTy &B, KernelState &S, unsigned Bound);
+  FunctionCallee getBuiltin(StringRef Name, Type *RetTy,
+                            ArrayRef<Type *> ArgTys);
+  CallInst *emitCall(BuilderTy &B, FunctionCallee F, ArrayRef<Value *> Args);
+  SmallVector<unsigned, 8> getFieldPath(unsigned Depth, bool IsFloat) const;
+
+  unsigned random(unsigned Bound) { return Rng() % Bound; }
+  Value *pickInt(const KernelState &S) {
+    return S.Ints[random(S.Ints.size())];
+  }
+  Value *pickFloat(const KernelState &S) {
+    return S.Floats[random(S.Floats.size())];
+  }
+  void addValue(std::vector<Value *> &Pool, Value *V);
+
+  LLVMContext &C;
+  // std::mt19937 produces the same sequence everywhere, unlike the standard
+  // distributions, so values are reduced with plain modulo.
+  std::mt19937 Rng;
+  std::unique_ptr<Module> M;
+  Type *Int32Ty = nullptr;
+  Type *Int64Ty = nullptr;
+  Type *FloatTy = nullptr;
+  // Structs[I] nests Structs[I - 1].
+  std::vector<StructType *> Structs;
+  GlobalVariable *IntTable = nullptr;
+  GlobalVariable *FloatTable = nullptr;
+  std::unique_ptr<DIBuilder> DIB;
+  DIFile *File = nullptr;
+  DIType *DIIntTy = nullptr;
+  DIType *DIFloatTy = nullptr;
+  DISubprogram *SP = nullptr;
+  unsigned Line = 1;
+};
+
+} // namespace
+
+std::unique_ptr<Module> SyntheticModuleBuilder::build() {
+  M->setTargetTriple("spir64-unknown-unknown");
+  M->setDataLayout("e-i64:64-v16:16-v24:32-v32:32-v48:64-v96:128-v192:256-"
+                   "v256:256-v512:512-v1024:1024");
+  Int32Ty = Type::getInt32Ty(C);
+  Int64Ty = Type::getInt64Ty(C);
+  FloatTy = Type::getFloatTy(C);
+
+  if (GenerateDebugInfo) {
+    DIB.reset(new DIBuilder(*M));
+    File = DIB->createFile("synthetic.cl", "/llvm-spirv-bench");
+    DIB->createCompileUnit(dwarf::DW_LANG_OpenCL, File, "llvm-spirv-bench",
+                           /*isOptimized=*/false, "", 0);
+    DIIntTy = DIB->createBasicType("int", 32, dwarf::DW_ATE_signed);
+    DIFloatTy = DIB->createBasicType("float", 32, dwarf::DW_ATE_float);
+    M->addModuleFlag(Module::Warning, "Dwarf Version", 4);
+    M->addModuleFlag(Module::Warning, "Debug Info Version",
+                     DEBUG_METADATA_VERSION);
+  }
+
+  buildTypes();
+  buildConstantTables();
+  for (unsigned I = 0; I < NumKernels; ++I)
+    buildKernel(I);
+  if (DIB)
+    DIB->finalize();
+
+  auto *OCLVersion = MDNode::get(
+      C, {ConstantAsMetadata::get(ConstantInt::get(Int32Ty, 1)),
+          ConstantAsMetadata::get(ConstantInt::get(Int32Ty, 2))});
+  M->getOrInsertNamedMetadata("opencl.spir.version")->addOperand(OCLVersion);
+  M->getOrInsertNamedMetadata("opencl.ocl.version")->addOperand(OCLVersion);
+  // OpenCL C 1.2 as the source language.
+  M->getOrInsertNamedMetadata("spirv.Source")
+      ->addOperand(MDNode::get(
+          C, {ConstantAsMetadata::get(ConstantInt::get(Int32Ty, 3)),
+              ConstantAsMetadata::get(ConstantInt::get(Int32Ty, 102000))}));
+  return std::move(M);
+}
+
+void SyntheticModuleBuilder::buildTypes() {
+  Structs.push_back(StructType::create(C, {Int32Ty, FloatTy}, "struct.S0"));
+  for (unsigned I = 1; I <= StructDepth; ++I)
+    Structs.push_back(StructType::create(C, {Structs.back(), Int32Ty, FloatTy},
+                                         "struct.S" + std::to_string(I)));
+}
+
+void SyntheticModuleBuilder::buildConstantTables() {
+  if (!ConstantTableSize)
+    return;
+  std::vector<uint32_t> Ints(ConstantTableSize);
+  std::vector<float> Floats(ConstantTableSize);
+  for (unsigned I = 0; I < ConstantTableSize; ++I) {
+    Ints[I] = Rng();
+    Floats[I] = static_cast<float>(Rng() % 100000) / 100.0f;
+  }
+  auto AddTable = [&](Constant *Init, StringRef Name) {
+    auto *GV = new GlobalVariable(*M, Init->getType(), /*isConstant=*/true,
+                                  GlobalValue::InternalLinkage, Init, Name,
+                                  nullptr, GlobalValue::NotThreadLocal,
+                                  /*AddressSpace=*/2);
+    GV->setAlignment(Align(4));
+    return GV;
+  };
+  IntTable = AddTable(ConstantDataArray::get(C, Ints), "int_table");
+  FloatTable = AddTable(ConstantDataArray::get(C, Floats), "float_table");
+}
+
+void SyntheticModuleBuilder::addValue(std::vector<Value *> &Pool, Value *V) {
+  // Operands are picked among the most recent values, so the generated code
+  // has short live ranges like real kernels do.
+  const size_t PoolSize = 16;
+  if (Pool.size() == PoolSize)
+    Pool.erase(Pool.begin());
+  Pool.push_back(V);
+}
+
+SmallVector<unsigned, 8>
+SyntheticModuleBuilder::getFieldPath(unsigned Depth, bool IsFloat) const {
+  // Struct S0 is {i32, float}, the others are {S<I - 1>, i32, float}.
+  unsigned Levels = Structs.size() - 1;
+  Depth = std::min(Depth, Levels);
+  SmallVector<unsigned, 8> Path(Depth, 0);
+  unsigned FirstScalar = Depth == Levels ? 0 : 1;
+  Path.push_back(FirstScalar + (IsFloat ? 1 : 0));
+  return Path;
+}
+
+FunctionCallee SyntheticModuleBuilder::getBuiltin(StringRef Name, Type *RetTy,
+                                                  ArrayRef<Type *> ArgTys) {
+  FunctionCallee F =
+      M->getOrInsertFunction(Name, FunctionType::get(RetTy, ArgTys, false));
+  cast<Function>(F.getCallee())->setCallingConv(CallingConv::SPIR_FUNC);
+  return F;
+}
+
+CallInst *SyntheticModuleBuilder::emitCall(BuilderTy &B, FunctionCallee F,
+                                           ArrayRef<Value *> Args) {
+  CallInst *Call = B.CreateCall(F, Args);
+  Call->setCallingConv(CallingConv::SPIR_FUNC);
+  return Call;
+}
+
+Value *SyntheticModuleBuilder::emitIndex(BuilderTy &B, KernelState &S,
+                                         unsigned Bound) {
+  return B.CreateZExt(B.CreateURem(pickInt(S), B.getInt32(Bound)), Int64Ty);
+}
+
+Value *SyntheticModuleBuilder::emitTableLoad(BuilderTy &B, KernelState &S,
+                                             GlobalVariable *Table) {
+  Type *TableTy = Table->getValueType();
+  Value *Ptr = B.CreateInBoundsGEP(
+      TableTy, Table, {B.getInt64(0), emitIndex(B, S, ConstantTableSize)});
+  return B.CreateLoad(TableTy->getArrayElementType(), Ptr);
+}
+
+void SyntheticModuleBuilder::emitBuiltinCall(BuilderTy &B, KernelState &S) {
+  switch (random(10)) {
+  case 0:
+  case 1: {
+    FunctionCallee F =
+        getBuiltin(random(2) ? "_Z13get_global_idj" : "_Z12get_local_idj",
+                   Int64Ty, {Int32Ty});
+    Value *Id = emitCall(B, F, {B.getInt32(random(3))});
+    addValue(S.Ints, B.CreateTrunc(Id, Int32Ty));
+    break;
+  }
+  case 2: {
+    FunctionCallee F = getBuiltin(random(2) ? "_Z3maxii" : "_Z3minii",
+                                  Int32Ty, {Int32Ty, Int32Ty});
+    addValue(S.Ints, emitCall(B, F, {pickInt(S), pickInt(S)}));
+    break;
+  }
+  case 3: {
+    FunctionCallee F =
+        getBuiltin("_Z5clampiii", Int32Ty, {Int32Ty, Int32Ty, Int32Ty});
+    addValue(S.Ints, emitCall(B, F, {pickInt(S), pickInt(S), pickInt(S)}));
+    break;
+  }
+  case 4: {
+    FunctionCallee F =
+        getBuiltin(random(2) ? "_Z4sqrtf" : "_Z10native_sinf", FloatTy,
+                   {FloatTy});
+    addValue(S.Floats, emitCall(B, F, {pickFloat(S)}));
+    break;
+  }
+  case 5: {
+    FunctionCallee F =
+        getBuiltin("_Z3madfff", FloatTy, {FloatTy, FloatTy, FloatTy});
+    addValue(S.Floats,
+             emitCall(B, F, {pickFloat(S), pickFloat(S), pickFloat(S)}));
+    break;
+  }
+  case 6: {
+    FunctionCallee F =
+        getBuiltin("_Z4fmaxff", FloatTy, {FloatTy, FloatTy});
+    addValue(S.Floats, emitCall(B, F, {pickFloat(S), pickFloat(S)}));
+    break;
+  }
+  case 7:
+  case 8: {
+    FunctionCallee F = getBuiltin("_Z10atomic_addPU3AS1Vii", Int32Ty,
+                                  {S.Out->getType(), Int32Ty});
+    addValue(S.Ints, emitCall(B, F, {S.Out, pickInt(S)}));
+    break;
+  }
+  default: {
+    // CLK_GLOBAL_MEM_FENCE
+    FunctionCallee F =
+        getBuiltin("_Z7barrierj", Type::getVoidTy(C), {Int32Ty});
+    emitCall(B, F, {B.getInt32(2)});
+    break;
+  }
+  }
+}
+
+void SyntheticModuleBuilder::emitBranch(BuilderTy &B, KernelState &S) {
+  Function *F = B.GetInsertBlock()->getParent();
+  auto *Then = BasicBlock::Create(C, "then", F);
+  auto *Else = BasicBlock::Create(C, "else", F);
+  auto *Merge = BasicBlock::Create(C, "merge", F);
+  B.CreateCondBr(B.CreateICmpSLT(pickInt(S), S.Size), Then, Else);
+  B.SetInsertPoint(Then);
+  Value *Inc = B.CreateAdd(pickInt(S), B.getInt32(1));
+  B.CreateBr(Merge);
+  B.SetInsertPoint(Else);
+  Value *Dec = B.CreateSub(pickInt(S), B.getInt32(1));
+  B.CreateBr(Merge);
+  B.SetInsertPoint(Merge);
+  PHINode *Phi = B.CreatePHI(Int32Ty, 2);
+  Phi->addIncoming(Inc, Then);
+  Phi->addIncoming(Dec, Else);
+  addValue(S.Ints, Phi);
+}
+
+void SyntheticModuleBuilder::emitStep(BuilderTy &B, KernelState &S) {
+  if (random(100) < BuiltinPercent) {
+    emitBuiltinCall(B, S);
+    return;
+  }
+  switch (random(ConstantTableSize ? 10 : 8)) {
+  case 0: {
+    static const Instruction::BinaryOps Ops[] = {
+        Instruction::Add, Instruction::Sub, Instruction::Mul,
+        Instruction::Xor, Instruction::And, Instruction::Shl};
+    addValue(S.Ints, B.CreateBinOp(Ops[random(6)], pickInt(S), pickInt(S)));
+    break;
+  }
+  case 1: {
+    static const Instruction::BinaryOps Ops[] = {
+        Instruction::FAdd, Instruction::FSub, Instruction::FMul,
+        Instruction::FDiv};
+    addValue(S.Floats,
+             B.CreateBinOp(Ops[random(4)], pickFloat(S), pickFloat(S)));
+    break;
+  }
+  case 2:
+    addValue(S.Floats, B.CreateSIToFP(pickInt(S), FloatTy));
+    break;
+  case 3: {
+    bool IsFloat = random(2);
+    Value *V = B.CreateExtractValue(
+        S.StructVal, getFieldPath(random(Structs.size()), IsFloat));
+    addValue(IsFloat ? S.Floats : S.Ints, V);
+    break;
+  }
+  case 4: {
+    bool IsFloat = random(2);
+    S.StructVal = B.CreateInsertValue(
+        S.StructVal, IsFloat ? pickFloat(S) : pickInt(S),
+        getFieldPath(random(Structs.size()), IsFloat));
+    break;
+  }
+  case 5: {
+    Value *Ptr = B.CreateInBoundsGEP(Int32Ty, S.Out, emitIndex(B, S, 1024));
+    addValue(S.Ints, B.CreateLoad(Int32Ty, Ptr));
+    break;
+  }
+  case 6: {
+    Value *Ptr = B.CreateInBoundsGEP(Int32Ty, S.Out, emitIndex(B, S, 1024));
+    B.CreateStore(pickInt(S), Ptr);
+    break;
+  }
+  case 7: {
+    Value *Ptr =
+        B.CreateInBoundsGEP(FloatTy, S.FloatOut, emitIndex(B, S, 1024));
+    B.CreateStore(pickFloat(S), Ptr);
+    break;
+  }
+  case 8:
+    addValue(S.Ints, emitTableLoad(B, S, IntTable));
+    break;
+  default:
+    addValue(S.Floats, emitTableLoad(B, S, FloatTable));
+    break;
+  }
+}
+
+void SyntheticModuleBuilder::buildKernel(unsigned Index) {
+  StructType *TopTy = Structs.back();
+  Type *ArgTys[] = {PointerType::get(Int32Ty, 1), PointerType::get(FloatTy, 1),
+                    PointerType::get(TopTy, 1), Int32Ty};
+  auto *FTy = FunctionType::get(Type::getVoidTy(C), ArgTys, false);
+  auto *F = Function::Create(FTy, GlobalValue::ExternalLinkage,
+                             "kernel" + std::to_string(Index), *M);
+  F->setCallingConv(CallingConv::SPIR_KERNEL);
+
+  KernelState S;
+  auto ArgIt = F->arg_begin();
+  S.Out = &*ArgIt++;
+  S.FloatOut = &*ArgIt++;
+  S.StructPtr = &*ArgIt++;
+  S.Size = &*ArgIt++;
+  S.Out->setName("out");
+  S.FloatOut->setName("fout");
+  S.StructPtr->setName("s");
+  S.Size->setName("n");
+
+  if (DIB) {
+    SP = DIB->createFunction(
+        File, F->getName(), "", File, Line,
+        DIB->createSubroutineType(DIB->getOrCreateTypeArray(None)), Line,
+        DINode::FlagZero, DISubprogram::SPFlagDefinition);
+    F->setSubprogram(SP);
+    S.IntVar = DIB->createAutoVariable(SP, "acc", File, Line, DIIntTy);
+    S.FloatVar = DIB->createAutoVariable(SP, "facc", File, Line, DIFloatTy);
+  }
+
+  // Instructions inserted by the builder, not counting debug intrinsics.
+  unsigned NumEmitted = 0;
+  BuilderTy B(C, ConstantFolder(),
+              IRBuilderCallbackInserter([&](Instruction *) { ++NumEmitted; }));
+  B.SetInsertPoint(BasicBlock::Create(C, "entry", F));
+  if (DIB)
+    B.SetCurrentDebugLocation(DILocation::get(C, Line, 1, SP));
+  S.Ints.push_back(S.Size);
+  S.Floats.push_back(B.CreateSIToFP(S.Size, FloatTy));
+  S.StructVal = B.CreateLoad(TopTy, S.StructPtr);
+
+  // Straight line code is split by a diamond every this many steps.
+  const unsigned BlockSize = 64;
+  for (unsigned I = 0; NumEmitted < NumInstructions; ++I) {
+    if (DIB) {
+      ++Line;
+      B.SetCurrentDebugLocation(DILocation::get(C, Line, 1 + I % 8, SP));
+    }
+    if (I % BlockSize == BlockSize - 1)
+      emitBranch(B, S);
+    else
+      emitStep(B, S);
+    if (DIB && I % 4 == 0) {
+      const DILocation *Loc = B.getCurrentDebugLocation().get();
+      DIB->insertDbgValueIntrinsic(S.Ints.back(), S.IntVar,
+                                   DIB->createExpression(), Loc,
+                                   B.GetInsertBlock());
+      DIB->insertDbgValueIntrinsic(S.Floats.back(), S.FloatVar,
+                                   DIB->createExpression(), Loc,
+                                   B.GetInsertBlock());
+    }
+  }
+  B.CreateStore(S.StructVal, S.StructPtr);
+  B.CreateStore(S.Ints.back(), S.Out);
+  B.CreateStore(S.Floats.back(), S.FloatOut);
+  B.CreateRetVoid();
+  ++Line;
+}
+
+namespace {
+
+// Measurements of one benchmark.
+struct BenchResult {
+  std::string Name;
+  std::vector<double> Seconds;
+  // Instructions processed by one run.
+  uint64_t Instructions = 0;
+  uint64_t PeakRSS = 0;
+  // Statistics of the fastest run, if the benchmark collects them.
+  bool HasStats = false;
+  SPIRV::TranslationStats Stats;
+};
+
+typedef std::chrono::steady_clock Clock;
+
+double getSeconds(Clock::time_point Start) {
+  return std::chrono::duration<double>(Clock::now() - Start).count();
+}
+
+} // namespace
+
+// Reset the peak resident set size of the process where the kernel allows it,
+// so that each benchmark reports its own peak instead of the process-wide one.
+static void resetPeakRSS() {
+#ifdef __linux__
+  std::ofstream ClearRefs("/proc/self/clear_refs");
+  ClearRefs << "5";
+#endif
+}
+
+// \returns the peak resident set size of the process in bytes, 0 if unknown.
+static uint64_t getPeakRSS() {
+#ifdef __linux__
+  std::ifstream Status("/proc/self/status");
+  std::string Line;
+  while (std::getline(Status, Line))
+    if (Line.compare(0, 6, "VmHWM:") == 0)
+      return std::strtoull(Line.c_str() + 6, nullptr, 10) * 1024;
+#endif
+#ifdef LLVM_ON_UNIX
+  struct rusage Usage;
+  if (getrusage(RUSAGE_SELF, &Usage) == 0) {
+#ifdef __APPLE__
+    return Usage.ru_maxrss;
+#else
+    return static_cast<uint64_t>(Usage.ru_maxrss) * 1024;
+#endif
+  }
+#endif
+  return 0;
+}
+
+// Run \p Body -iterations times. \p Body returns the time of one run, or a
+// negative value if it failed. Statistics are kept from the fastest run.
+template <typename BodyTy>
+static bool runBenchmark(BenchResult &Result, BodyTy Body) {
+  resetPeakRSS();
+  double Fastest = -1;
+  for (unsigned I = 0; I < Iterations; ++I) {
+    SPIRV::TranslationStats Stats;
+    double Seconds = Body(Stats);
+    if (Seconds < 0)
+      return false;
+    Result.Seconds.push_back(Seconds);
+    if (Fastest < 0 || Seconds < Fastest) {
+      Fastest = Seconds;
+      Result.Stats = Stats;
+    }
+  }
+  Result.PeakRSS = getPeakRSS();
+  return true;
+}
+
+static bool parseModule(LLVMContext &Context, StringRef Bitcode,
+                        std::unique_ptr<Module> &M) {
+  Expected<std::unique_ptr<Module>> MOrErr =
+      parseBitcodeFile(MemoryBufferRef(Bitcode, "synthetic"), Context);
+  if (!MOrErr) {
+    logAllUnhandledErrors(MOrErr.takeError(), errs(), "llvm-spirv-bench: ");
+    return false;
+  }
+  M = std::move(*MOrErr);
+  return true;
+}
+
+static bool benchForward(const SPIRV::TranslatorOpts &Opts, StringRef Bitcode,
+                         BenchResult &Result) {
+  Result.HasStats = true;
+  return runBenchmark(Result, [&](SPIRV::TranslationStats &Stats) {
+    // writeSpirv changes the module, so every run translates a fresh copy.
+    LLVMContext Context;
+    std::unique_ptr<Module> M;
+    if (!parseModule(Context, Bitcode, M))
+      return -1.0;
+    std::ostringstream OS;
+    std::string Err;
+    Clock::time_point Start = Clock::now();
+    bool Success = writeSpirv(M.get(), Opts, OS, Err, Stats);
+    double Seconds = getSeconds(Start);
+    if (!Success) {
+      errs() << "llvm-spirv-bench: forward translation failed: " << Err
+             << '\n';
+      return -1.0;
+    }
+    Result.Instructions = Stats.Instructions;
+    return Seconds;
+  });
+}
+
+static bool benchReverse(const SPIRV::TranslatorOpts &Opts,
+                         const std::string &Binary, BenchResult &Result) {
+  Result.HasStats = true;
+  return runBenchmark(Result, [&](SPIRV::TranslationStats &Stats) {
+    LLVMContext Context;
+    std::istringstream IS(Binary);
+    Module *M = nullptr;
+    std::string Err;
+    Clock::time_point Start = Clock::now();
+    bool Success = readSpirv(Context, Opts, IS, M, Err, Stats);
+    double Seconds = getSeconds(Start);
+    std::unique_ptr<Module> Owner(M);
+    if (!Success) {
+      errs() << "llvm-spirv-bench: reverse translation failed: " << Err
+             << '\n';
+      return -1.0;
+    }
+    Result.Instructions = Stats.Instructions;
+    return Seconds;
+  });
+}
+
+// Convert SPIR-V \p Binary to the internal text format and back.
+static bool benchText(const std::string &Binary, uint64_t NumInstructions,
+                      BenchResult &Result) {
+  Result.Instructions = NumInstructions;
+  return runBenchmark(Result, [&](SPIRV::TranslationStats &) {
+    std::istringstream IS(Binary);
+    std::ostringstream Text;
+    std::string Err;
+    Clock::time_point Start = Clock::now();
+    bool Success = SPIRV::convertSpirv(IS, Text, Err, /*FromText=*/false,
+                                       /*ToText=*/true);
+    if (Success) {
+      std::istringstream TextIS(Text.str());
+      std::ostringstream BinaryOS;
+      Success = SPIRV::convertSpirv(TextIS, BinaryOS, Err, /*FromText=*/true,
+                                    /*ToText=*/false);
+    }
+    double Seconds = getSeconds(Start);
+    if (!Success) {
+      errs() << "llvm-spirv-bench: text conversion failed: " << Err << '\n';
+      return -1.0;
+    }
+    return Seconds;
+  });
+}
+
+static void printResult(std::ostream &OS, const BenchResult &Result) {
+  std::vector<double> Sorted(Result.Seconds);
+  std::sort(Sorted.begin(), Sorted.end());
+  double Fastest = Sorted.front();
+  double Median = Sorted[Sorted.size() / 2];
+  if (Sorted.size() % 2 == 0)
+    Median = (Median + Sorted[Sorted.size() / 2 - 1]) / 2;
+  OS << "{\"name\":\"" << Result.Name << "\",\"seconds\":[";
+  for (size_t I = 0; I < Result.Seconds.size(); ++I)
+    OS << (I ? "," : "") << Result.Seconds[I];
+  OS << "],\"min_seconds\":" << Fastest << ",\"median_seconds\":" << Median
+     << ",\"instructions\":" << Result.Instructions
+     << ",\"instructions_per_second\":"
+     << (Fastest > 0 ? Result.Instructions / Fastest : 0.0)
+     << ",\"peak_rss_bytes\":" << Result.PeakRSS;
+  if (Result.HasStats) {
+    // Keep the whole report on one line.
+    std::ostringstream StatsOS;
+    Result.Stats.dumpJSON(StatsOS);
+    std::string Stats = StatsOS.str();
+    while (!Stats.empty() && Stats.back() == '\n')
+      Stats.pop_back();
+    OS << ",\"stats\":" << Stats;
+  }
+  OS << '}';
+}
+
+int main(int Ac, char **Av) {
+  EnablePrettyStackTrace();
+  sys::PrintStackTraceOnErrorSignal(Av[0]);
+  PrettyStackTraceProgram X(Ac, Av);
+
+  cl::ParseCommandLineOptions(Ac, Av, "LLVM/SPIR-V translator benchmark");
+
+  bool RunForward = Benchmarks.empty(), RunReverse = Benchmarks.empty(),
+       RunText = Benchmarks.empty();
+  for (const auto &Name : Benchmarks) {
+    if (Name == "forward")
+      RunForward = true;
+    else if (Name == "reverse")
+      RunReverse = true;
+    else if (Name == "text")
+      RunText = true;
+    else {
+      errs() << "Unknown benchmark: " << Name << '\n';
+      return -1;
+    }
+  }
+  if (!Iterations) {
+    errs() << "-iterations must be at least 1\n";
+    return -1;
+  }
+
+  SmallString<0> Bitcode;
+  uint64_t NumLLVMInstructions = 0;
+  {
+    LLVMContext Context;
+    std::unique_ptr<Module> M = SyntheticModuleBuilder(Context).build();
+    if (verifyModule(*M, &errs())) {
+      errs() << "llvm-spirv-bench: generated module is invalid\n";
+      return -1;
+    }
+    for (const Function &F : *M)
+      NumLLVMInstructions += F.getInstructionCount();
+    raw_svector_ostream BitcodeOS(Bitcode);
+    WriteBitcodeToFile(*M, BitcodeOS);
+  }
+  if (!EmitModuleFile.empty()) {
+    std::ofstream ModuleFile(EmitModuleFile, std::ios::binary);
+    ModuleFile.write(Bitcode.data(), Bitcode.size());
+    if (!ModuleFile) {
+      errs() << "Fails to write module to " << EmitModuleFile << '\n';
+      return -1;
+    }
+  }
+
+  SPIRV::TranslatorOpts Opts;
+  // The reverse and text benchmarks translate the module once up front.
+  std::string Binary;
+  SPIRV::TranslationStats ModuleStats;
+  {
+    LLVMContext Context;
+    std::unique_ptr<Module> M;
+    if (!parseModule(Context, Bitcode, M))
+      return -1;
+    std::ostringstream OS;
+    std::string Err;
+    if (!writeSpirv(M.get(), Opts, OS, Err, ModuleStats)) {
+      errs() << "llvm-spirv-bench: forward translation failed: " << Err
+             << '\n';
+      return -1;
+    }
+    Binary = OS.str();
+  }
+
+  std::vector<BenchResult> Results;
+  auto Run = [&](const char *Name, bool Enabled,
+                 std::function<bool(BenchResult &)> Bench) {
+    if (!Enabled)
+      return true;
+    Results.emplace_back();
+    Results.back().Name = Name;
+    return Bench(Results.back());
+  };
+  if (!Run("forward", RunForward,
+           [&](BenchResult &R) { return benchForward(Opts, Bitcode, R); }) ||
+      !Run("reverse", RunReverse,
+           [&](BenchResult &R) { return benchReverse(Opts, Binary, R); }) ||
+      !Run("text", RunText, [&](BenchResult &R) {
+        return benchText(Binary, ModuleStats.Instructions, R);
+      }))
+    return -1;
+
+  std::ofstream OutFile;
+  if (OutputFile != "-")
+    OutFile.open(OutputFile);
+  std::ostream &OS = OutputFile != "-" ? OutFile : std::cout;
+  OS << "{\"config\":{\"kernels\":" << NumKernels
+     << ",\"instructions\":" << NumInstructions
+     << ",\"struct_depth\":" << StructDepth
+     << ",\"constant_table\":" << ConstantTableSize
+     << ",\"builtin_percent\":" << BuiltinPercent
+     << ",\"debug_info\":" << (GenerateDebugInfo ? "true" : "false")
+     << ",\"seed\":" << Seed << ",\"iterations\":" << Iterations << '}'
+     << ",\"module\":{\"llvm_instructions\":" << NumLLVMInstructions
+     << ",\"bitcode_bytes\":" << Bitcode.size()
+     << ",\"spirv_bytes\":" << Binary.size()
+     << ",\"spirv_instructions\":" << ModuleStats.Instructions
+     << ",\"spirv_ids\":" << ModuleStats.Ids << '}' << ",\"benchmarks\":[";
+  for (size_t I = 0; I < Results.size(); ++I) {
+    if (I)
+      OS << ',';
+    printResult(OS, Results[I]);
+  }
+  OS << "]}\n";
+  if (!OS) {
+    errs() << "Fails to write report to " << OutputFile << '\n';
+    return -1;
+  }
+  return 0;
+}
@@ -47,9 +47,9 @@
 
 #include "llvm/Bitcode/BitcodeReader.h"
 #include "llvm/Bitcode/BitcodeWriter.h"
+#include "llvm/Config/llvm-config.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Module.h"
-#include "llvm/IR/Verifier.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/Error.h"
@@ -57,6 +57,8 @@
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/PrettyStackTrace.h"
 #include "llvm/Support/Signals.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/Threading.h"
 #include "llvm/Support/ToolOutputFile.h"
 
 #ifndef _SPIRV_SUPPORT_TEXT_FMT
@@ -65,13 +67,27 @@
 
 #include "LLVMSPIRVLib.h"
 
+#include <atomic>
+#include <chrono>
+#include <cstring>
 #include <fstream>
 #include <iostream>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <set>
+#include <sstream>
 #include <string>
 
+#ifdef LLVM_ON_UNIX
+#include <cerrno>
+#include <csignal>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
 #define DEBUG_TYPE "spirv"
 
 namespace kExt {
@@ -85,6 +101,22 @@ using namespace llvm;
 static cl::opt<std::string> InputFile(cl::Positional, cl::desc("<input file>"),
                                       cl::init("-"));
 
+static cl::list<std::string>
+    LinkInputFiles(cl::Positional,
+                   cl::desc("<more input files to link or translate>"));
+
+static cl::opt<std::string> InputListFile(
+    "input-list",
+    cl::desc("Also translate the files listed in the specified file, one per "
+             "line"),
+    cl::value_desc("filename"));
+
+static cl::opt<unsigned> Jobs(
+    "j",
+    cl::desc("Number of input files translated concurrently when more than "
+             "one is given (default: number of hardware threads)"),
+    cl::value_desc("N"), cl::init(0));
+
 static cl::opt<std::string> OutputFile("o",
                                        cl::desc("Override output filename"),
                                        cl::value_desc("filename"));
@@ -140,10 +172,9 @@ static cl::opt<SPIRV::BIsRepresentation> BIsRepresentation(
 using SPIRV::ExtensionID;
 
 #ifdef _SPIRV_SUPPORT_TEXT_FMT
-namespace SPIRV {
-// Use textual format for SPIRV.
-extern bool SPIRVUseTextFormat;
-} // namespace SPIRV
+static cl::opt<bool>
+    UseTextFormat("spirv-text",
+                  cl::desc("Use text format for SPIR-V for debugging purpose"));
 
 static cl::opt<bool>
     ToText("to-text",
@@ -168,11 +199,29 @@ static cl::opt<bool>
     SPIRVMemToReg("spirv-mem2reg", cl::init(false),
                   cl::desc("LLVM/SPIR-V translation enable mem2reg"));
 
+static cl::opt<bool> IsSpecialization(
+    "specialize",
+    cl::desc("Apply -spec-const values to the input SPIR-V binary and write "
+             "the specialized SPIR-V binary, without translating it to LLVM"));
+
+static cl::opt<bool>
+    IsLink("link",
+           cl::desc("Link the input SPIR-V binaries into one SPIR-V binary, "
+                    "resolving imported functions and variables to the "
+                    "definitions exported by other inputs, without "
+                    "translating them"));
+
 static cl::opt<bool> SpecConstInfo(
     "spec-const-info",
     cl::desc("Display id of constants available for specializaion and their "
              "size in bytes"));
 
+static cl::opt<bool> SPIRVModuleInfo(
+    "spirv-module-info",
+    cl::desc("Display kernels of the input SPIR-V module with their "
+             "parameters and execution modes, and the capabilities and "
+             "extensions it uses, without translating it"));
+
 static cl::opt<SPIRV::FPContractMode> FPCMode(
     "spirv-fp-contract", cl::desc("Set FP Contraction mode:"),
     cl::init(SPIRV::FPContractMode::On),
@@ -205,12 +254,108 @@ static cl::opt<SPIRV::DebugInfoEIS> DebugEIS(
                    "extended instruction set. This version of SPIR-V debug "
                    "info format is compatible with the SPIRV-Tools")));
 
+static cl::opt<SPIRV::VerificationLevel> Verification(
+    "spirv-verify", cl::desc("Set when the LLVM module is verified:"),
+    cl::init(SPIRV::VerificationLevel::Final),
+    cl::values(
+        clEnumValN(SPIRV::VerificationLevel::None, "none",
+                   "Don't verify the LLVM module"),
+        clEnumValN(SPIRV::VerificationLevel::Final, "final",
+                   "Verify the result of translation from SPIR-V to LLVM IR"),
+        clEnumValN(SPIRV::VerificationLevel::PerPass, "per-pass",
+                   "Also verify the LLVM module after each pass of the "
+                   "translation and stop at the first pass producing an "
+                   "invalid module")));
+
+static cl::opt<bool> StreamFunctionBodies(
+    "spirv-stream-functions",
+    cl::desc("Encode each function body as soon as it is translated to "
+             "SPIR-V and free its instructions, to reduce peak memory. The "
+             "output is the same as without this option"),
+    cl::init(false));
+
 static cl::opt<bool> SPIRVReplaceLLVMFmulAddWithOpenCLMad(
     "spirv-replace-fmuladd-with-ocl-mad",
     cl::desc("Allow replacement of llvm.fmuladd.* intrinsic with OpenCL mad "
              "instruction from OpenCL extended instruction set"),
     cl::init(true));
 
+static cl::opt<std::string> DebugSidecarFile(
+    "spirv-debug-sidecar",
+    cl::desc("Write the complete SPIR-V module to the specified file and "
+             "strip debug instructions from the output module"),
+    cl::value_desc("filename"));
+
+static cl::opt<SpirvSplitMode> SplitMode(
+    "split", cl::desc("Translate to one SPIR-V module per group of kernels:"),
+    cl::values(clEnumValN(SpirvSplitMode::PerKernel, "per-kernel",
+                          "One module per kernel"),
+               clEnumValN(SpirvSplitMode::ByAttribute, "by-attribute",
+                          "One module per value of the function attribute "
+                          "given by -split-attribute")));
+
+static cl::opt<std::string> SplitAttribute(
+    "split-attribute",
+    cl::desc("Function attribute grouping kernels for -split=by-attribute"),
+    cl::init("sycl-module-id"));
+
+static cl::opt<unsigned> NumShards(
+    "shards",
+    cl::desc("With -r, translate to at most N LLVM modules on as many "
+             "threads, defining each function in one of them"),
+    cl::value_desc("N"), cl::init(0));
+
+static cl::opt<bool> SPIRVSkipDebugInfo(
+    "spirv-skip-debug-info", cl::init(false),
+    cl::desc("Don't read debug information from the input SPIR-V module"));
+
+static cl::opt<std::string> TranslationCacheDir(
+    "translation-cache",
+    cl::desc("Reuse translation results stored in the specified directory "
+             "and store new ones there. Results to SPIR-V are not reused "
+             "with -spirv-verify=per-pass"),
+    cl::value_desc("dir"));
+
+static cl::opt<uint64_t> TranslationCacheMaxSize(
+    "translation-cache-max-size",
+    cl::desc("Size limit of the translation cache directory in bytes; least "
+             "recently used entries are removed once it is exceeded"),
+    cl::value_desc("bytes"));
+
+static cl::opt<std::string> ServeSocket(
+    "serve",
+    cl::desc("Run as a translation server listening on the specified unix "
+             "domain socket until a client sends -serve-shutdown"),
+    cl::value_desc("socket"));
+
+static cl::opt<std::string> ClientSocket(
+    "client",
+    cl::desc("Let the translation server listening on the specified unix "
+             "domain socket translate the input file"),
+    cl::value_desc("socket"));
+
+static cl::opt<bool>
+    ServerShutdown("serve-shutdown",
+                   cl::desc("Ask the server given by -client to exit"));
+
+static cl::opt<bool> TranslationCacheStats(
+    "translation-cache-stats", cl::init(false),
+    cl::desc("Print translation cache hits and misses to stderr, and those "
+             "of the builtin name cache shared by multiple input files"));
+
+static cl::opt<std::string> StatsJsonFile(
+    "translation-stats-json",
+    cl::desc("Write the time spent in each translation phase and counters of "
+             "the translated module to the specified file as JSON"),
+    cl::value_desc("file"));
+
+static cl::opt<std::string> TraceFile(
+    "spirv-trace",
+    cl::desc("Write the instructions decoded and encoded by each SPIR-V "
+             "module to the specified file as JSON, one line per module. "
+             "Requires a translator built with LLVM_SPIRV_ENABLE_TRACE"),
+    cl::value_desc("file"));
+
 static std::string removeExt(const std::string &FileName) {
   size_t Pos = FileName.find_last_of(".");
   if (Pos != std::string::npos)
@@ -220,80 +365,148 @@ static std::string removeExt(const std::string &FileName) {
 
 static ExitOnError ExitOnErr;
 
-static int convertLLVMToSPIRV(const SPIRV::TranslatorOpts &Opts) {
+static bool isFileEmpty(const std::string &FileName) {
+  std::ifstream File(FileName);
+  return File && File.peek() == EOF;
+}
+
+// Run \p F, adding the time it takes to phase \p Phase of \p Stats unless
+// \p Stats is null.
+template <typename FnTy>
+static auto timePhase(SPIRV::TranslationStats *Stats, const char *Phase,
+                      FnTy F) -> decltype(F()) {
+  if (!Stats)
+    return F();
+  auto Start = std::chrono::steady_clock::now();
+  auto Result = F();
+  Stats->addPhase(Phase, std::chrono::duration<double>(
+                             std::chrono::steady_clock::now() - Start)
+                             .count());
+  return Result;
+}
+
+// Translate LLVM bitcode file \p Input to SPIR-V, writing diagnostics to
+// \p ErrOS. An empty \p Output selects the default output file name. The
+// translation runs in \p Session if it is given.
+static int convertLLVMToSPIRV(const SPIRV::TranslatorOpts &Opts,
+                              const std::string &Input, std::string Output,
+                              raw_ostream &ErrOS,
+                              SPIRV::TranslatorSession *Session = nullptr,
+                              SPIRV::TranslationStats *Stats = nullptr) {
   LLVMContext Context;
 
-  std::unique_ptr<MemoryBuffer> MB =
-      ExitOnErr(errorOrToExpected(MemoryBuffer::getFileOrSTDIN(InputFile)));
-  std::unique_ptr<Module> M =
-      ExitOnErr(getOwningLazyBitcodeModule(std::move(MB), Context,
-                                           /*ShouldLazyLoadMetadata=*/true));
-  ExitOnErr(M->materializeAll());
+  ErrorOr<std::unique_ptr<MemoryBuffer>> MB =
+      MemoryBuffer::getFileOrSTDIN(Input);
+  if (!MB) {
+    logAllUnhandledErrors(errorCodeToError(MB.getError()), ErrOS);
+    return 1;
+  }
+  if (Stats)
+    Stats->BytesIn += (*MB)->getBufferSize();
+  Expected<std::unique_ptr<Module>> M =
+      getOwningLazyBitcodeModule(std::move(*MB), Context,
+                                 /*ShouldLazyLoadMetadata=*/true);
+  if (!M) {
+    logAllUnhandledErrors(M.takeError(), ErrOS);
+    return 1;
+  }
+  if (Error E = timePhase(Stats, "read-bitcode",
+                          [&] { return (*M)->materializeAll(); })) {
+    logAllUnhandledErrors(std::move(E), ErrOS);
+    return 1;
+  }
 
-  if (OutputFile.empty()) {
-    if (InputFile == "-")
-      OutputFile = "-";
+  if (Output.empty()) {
+    if (Input == "-")
+      Output = "-";
     else
-      OutputFile =
-          removeExt(InputFile) +
-          (SPIRV::SPIRVUseTextFormat ? kExt::SpirvText : kExt::SpirvBinary);
+      Output = removeExt(Input) +
+               (Opts.isSPIRVTextFormat() ? kExt::SpirvText : kExt::SpirvBinary);
   }
 
   std::string Err;
   bool Success = false;
-  if (OutputFile != "-") {
-    std::ofstream OutFile(OutputFile, std::ios::binary);
-    Success = writeSpirv(M.get(), Opts, OutFile, Err);
+  if (!DebugSidecarFile.empty()) {
+    std::ofstream DebugFile(DebugSidecarFile, std::ios::binary);
+    if (Output != "-") {
+      std::ofstream OutFile(Output, std::ios::binary);
+      Success = writeSpirv(M->get(), Opts, OutFile, DebugFile, Err);
+    } else {
+      Success = writeSpirv(M->get(), Opts, std::cout, DebugFile, Err);
+    }
+  } else if (Session) {
+    std::ofstream OutFile;
+    if (Output != "-")
+      OutFile.open(Output, std::ios::binary);
+    Success = Session->writeSpirv(M->get(), Output != "-" ? OutFile : std::cout,
+                                  Err);
+  } else if (Stats) {
+    std::ofstream OutFile;
+    if (Output != "-")
+      OutFile.open(Output, std::ios::binary);
+    Success = writeSpirv(M->get(), Opts, Output != "-" ? OutFile : std::cout,
+                         Err, *Stats);
+  } else if (Output != "-") {
+    std::ofstream OutFile(Output, std::ios::binary);
+    Success = writeSpirv(M->get(), Opts, OutFile, Err);
   } else {
-    Success = writeSpirv(M.get(), Opts, std::cout, Err);
+    Success = writeSpirv(M->get(), Opts, std::cout, Err);
   }
 
   if (!Success) {
-    errs() << "Fails to save LLVM as SPIR-V: " << Err << '\n';
+    ErrOS << "Fails to save LLVM as SPIR-V: " << Err << '\n';
     return -1;
   }
   return 0;
 }
 
-static bool isFileEmpty(const std::string &FileName) {
-  std::ifstream File(FileName);
-  return File && File.peek() == EOF;
-}
-
-static int convertSPIRVToLLVM(const SPIRV::TranslatorOpts &Opts) {
+// Translate SPIR-V file \p Input to LLVM bitcode, writing diagnostics to
+// \p ErrOS. An empty \p Output selects the default output file name. The
+// translation runs in \p Session if it is given.
+static int convertSPIRVToLLVM(const SPIRV::TranslatorOpts &Opts,
+                              const std::string &Input, std::string Output,
+                              raw_ostream &ErrOS,
+                              SPIRV::TranslatorSession *Session = nullptr,
+                              SPIRV::TranslationStats *Stats = nullptr) {
   LLVMContext Context;
-  std::ifstream IFS(InputFile, std::ios::binary);
+  std::ifstream IFS(Input, std::ios::binary);
   Module *M;
   std::string Err;
 
-  if (!readSpirv(Context, Opts, IFS, M, Err)) {
-    errs() << "Fails to load SPIR-V as LLVM Module: " << Err << '\n';
+  bool Success = false;
+  if (Session)
+    Success = Session->readSpirv(Context, IFS, M, Err);
+  else if (Stats)
+    Success = readSpirv(Context, Opts, IFS, M, Err, *Stats);
+  else
+    Success = readSpirv(Context, Opts, IFS, M, Err);
+  if (!Success) {
+    ErrOS << "Fails to load SPIR-V as LLVM Module: " << Err << '\n';
     return -1;
   }
 
   LLVM_DEBUG(dbgs() << "Converted LLVM module:\n" << *M);
 
-  raw_string_ostream ErrorOS(Err);
-  if (verifyModule(*M, &ErrorOS)) {
-    errs() << "Fails to verify module: " << ErrorOS.str();
-    return -1;
-  }
-
-  if (OutputFile.empty()) {
-    if (InputFile == "-")
-      OutputFile = "-";
+  if (Output.empty()) {
+    if (Input == "-")
+      Output = "-";
     else
-      OutputFile = removeExt(InputFile) + kExt::LLVMBinary;
+      Output = removeExt(Input) + kExt::LLVMBinary;
   }
 
   std::error_code EC;
-  ToolOutputFile Out(OutputFile.c_str(), EC, sys::fs::F_None);
+  ToolOutputFile Out(Output.c_str(), EC, sys::fs::F_None);
   if (EC) {
-    errs() << "Fails to open output file: " << EC.message();
+    ErrOS << "Fails to open output file: " << EC.message();
     return -1;
   }
 
-  WriteBitcodeToFile(*M, Out.os());
+  timePhase(Stats, "write-bitcode", [&] {
+    WriteBitcodeToFile(*M, Out.os());
+    return true;
+  });
+  if (Stats)
+    Stats->BytesOut += Out.os().tell();
   Out.keep();
   delete M;
   return 0;
@@ -375,6 +588,858 @@ static int regularizeLLVM(SPIRV::TranslatorOpts &Opts) {
   return 0;
 }
 
+// Translate InputFile to one SPIR-V module per split. The modules are
+// written next to the output file as <name>_<N>.spv, and the output file
+// lists each module followed by the kernels it defines, one module per line.
+static int splitLLVMToSPIRV(const SPIRV::TranslatorOpts &Opts) {
+  LLVMContext Context;
+
+  std::unique_ptr<MemoryBuffer> MB =
+      ExitOnErr(errorOrToExpected(MemoryBuffer::getFileOrSTDIN(InputFile)));
+  std::unique_ptr<Module> M =
+      ExitOnErr(getOwningLazyBitcodeModule(std::move(MB), Context,
+                                           /*ShouldLazyLoadMetadata=*/true));
+  ExitOnErr(M->materializeAll());
+
+  if (OutputFile.empty()) {
+    if (InputFile == "-") {
+      errs() << "-split requires -o when reading from standard input\n";
+      return -1;
+    }
+    OutputFile = removeExt(InputFile) + ".table";
+  }
+  if (OutputFile == "-") {
+    errs() << "-split cannot write to standard output\n";
+    return -1;
+  }
+
+  std::vector<SpirvSplit> Splits;
+  std::string Err;
+  if (!writeSpirvSplit(M.get(), Opts, SplitMode, SplitAttribute, Splits,
+                       Err)) {
+    errs() << "Fails to save LLVM as SPIR-V: " << Err << '\n';
+    return -1;
+  }
+
+  std::ofstream Table(OutputFile);
+  for (size_t I = 0; I < Splits.size(); ++I) {
+    std::string SplitFile =
+        removeExt(OutputFile) + "_" + std::to_string(I) +
+        (Opts.isSPIRVTextFormat() ? kExt::SpirvText : kExt::SpirvBinary);
+    std::ofstream OFS(SplitFile, std::ios::binary);
+    OFS.write(Splits[I].Binary.data(), Splits[I].Binary.size());
+    if (!OFS) {
+      errs() << "Fails to write " << SplitFile << '\n';
+      return -1;
+    }
+    Table << SplitFile;
+    for (const std::string &Kernel : Splits[I].Kernels)
+      Table << ' ' << Kernel;
+    Table << '\n';
+  }
+  if (!Table) {
+    errs() << "Fails to write " << OutputFile << '\n';
+    return -1;
+  }
+  return 0;
+}
+
+// Translate InputFile to LLVM bitcode shards. The shards are written next to
+// the output file as <name>_<N>.bc, and the output file lists each shard
+// followed by the functions it defines, one shard per line.
+static int shardSPIRVToLLVM(const SPIRV::TranslatorOpts &Opts) {
+  std::unique_ptr<MemoryBuffer> MB =
+      ExitOnErr(errorOrToExpected(MemoryBuffer::getFileOrSTDIN(InputFile)));
+
+  if (OutputFile.empty()) {
+    if (InputFile == "-") {
+      errs() << "-shards requires -o when reading from standard input\n";
+      return -1;
+    }
+    OutputFile = removeExt(InputFile) + ".table";
+  }
+  if (OutputFile == "-") {
+    errs() << "-shards cannot write to standard output\n";
+    return -1;
+  }
+
+  std::istringstream IS(MB->getBuffer().str());
+  std::vector<SpirvShard> Shards;
+  std::string Err;
+  if (!readSpirvShards(Opts, IS, NumShards, Shards, Err)) {
+    errs() << "Fails to load SPIR-V as LLVM Module: " << Err << '\n';
+    return -1;
+  }
+
+  std::ofstream Table(OutputFile);
+  for (size_t I = 0; I < Shards.size(); ++I) {
+    Module &M = *Shards[I].M;
+
+    std::string ShardFile =
+        removeExt(OutputFile) + "_" + std::to_string(I) + kExt::LLVMBinary;
+    std::error_code EC;
+    ToolOutputFile Out(ShardFile.c_str(), EC, sys::fs::F_None);
+    if (EC) {
+      errs() << "Fails to open output file: " << EC.message();
+      return -1;
+    }
+    WriteBitcodeToFile(M, Out.os());
+    Out.keep();
+
+    Table << ShardFile;
+    for (const Function &F : M)
+      if (!F.isDeclaration())
+        Table << ' ' << F.getName().str();
+    Table << '\n';
+  }
+  if (!Table) {
+    errs() << "Fails to write " << OutputFile << '\n';
+    return -1;
+  }
+  return 0;
+}
+
+static bool readSPIRVWords(const std::string &FileName,
+                           std::vector<uint32_t> &Words) {
+  std::unique_ptr<MemoryBuffer> MB =
+      ExitOnErr(errorOrToExpected(MemoryBuffer::getFileOrSTDIN(FileName)));
+  if (MB->getBufferSize() % sizeof(uint32_t)) {
+    errs() << "Invalid SPIR-V binary\n";
+    return false;
+  }
+  Words.resize(MB->getBufferSize() / sizeof(uint32_t));
+  std::memcpy(Words.data(), MB->getBufferStart(), MB->getBufferSize());
+  return true;
+}
+
+static int writeSPIRVWords(ArrayRef<uint32_t> Words) {
+  std::error_code EC;
+  ToolOutputFile OutFile(OutputFile.c_str(), EC, sys::fs::F_None);
+  if (EC) {
+    errs() << "Fails to open output file: " << EC.message();
+    return -1;
+  }
+  OutFile.os().write(reinterpret_cast<const char *>(Words.data()),
+                     Words.size() * sizeof(uint32_t));
+  OutFile.keep();
+  return 0;
+}
+
+static int specializeSPIRV(const SPIRV::TranslatorOpts &Opts) {
+  std::vector<uint32_t> In;
+  if (!readSPIRVWords(InputFile, In))
+    return -1;
+
+  const auto &Values = Opts.getExternalSpecialization();
+  std::map<uint32_t, uint64_t> SpecConsts(Values.begin(), Values.end());
+  SmallVector<uint32_t, 0> Out;
+  if (!specializeSpirv(In, SpecConsts, Out)) {
+    errs() << "Invalid SPIR-V binary\n";
+    return -1;
+  }
+
+  if (OutputFile.empty()) {
+    if (InputFile == "-")
+      OutputFile = "-";
+    else
+      OutputFile = removeExt(InputFile) + ".specialized" + kExt::SpirvBinary;
+  }
+  return writeSPIRVWords(Out);
+}
+
+static int linkSPIRV() {
+  std::vector<std::vector<uint32_t>> Binaries(1 + LinkInputFiles.size());
+  if (!readSPIRVWords(InputFile, Binaries[0]))
+    return -1;
+  for (unsigned I = 0; I < LinkInputFiles.size(); ++I)
+    if (!readSPIRVWords(LinkInputFiles[I], Binaries[I + 1]))
+      return -1;
+
+  SmallVector<ArrayRef<uint32_t>, 8> Inputs(Binaries.begin(), Binaries.end());
+  SmallVector<uint32_t, 0> Out;
+  std::string Err;
+  if (!linkSpirv(Inputs, Out, Err)) {
+    errs() << "Fails to link SPIR-V modules: " << Err << '\n';
+    return -1;
+  }
+
+  if (OutputFile.empty()) {
+    if (InputFile == "-")
+      OutputFile = "-";
+    else
+      OutputFile = removeExt(InputFile) + ".linked" + kExt::SpirvBinary;
+  }
+  return writeSPIRVWords(Out);
+}
+
+// Translate every file in \p Inputs on its own thread pool job, each with its
+// own LLVMContext. Diagnostics are buffered per file and reported in input
+// order, so the output and the exit code do not depend on scheduling.
+static int convertBatch(SPIRV::TranslatorOpts Opts,
+                        ArrayRef<std::string> Inputs) {
+  // A translation error must fail only its own file rather than exit.
+  Opts.setErrorHandling(SPIRV::SPIRVDbgErrorHandlingKinds::Ignore);
+  // All files share the caches of one session.
+  SPIRV::TranslatorSession Session(Opts);
+  std::vector<int> Results(Inputs.size());
+  std::vector<std::string> Diagnostics(Inputs.size());
+  {
+    ThreadPool Pool(hardware_concurrency(Jobs));
+    for (size_t I = 0; I < Inputs.size(); ++I)
+      Pool.async([&, I] {
+        raw_string_ostream ErrOS(Diagnostics[I]);
+        if (isFileEmpty(Inputs[I])) {
+          ErrOS << "Can't translate, file is empty\n";
+          Results[I] = -1;
+        } else if (IsReverse) {
+          Results[I] =
+              convertSPIRVToLLVM(Opts, Inputs[I], "", ErrOS, &Session);
+        } else {
+          Results[I] =
+              convertLLVMToSPIRV(Opts, Inputs[I], "", ErrOS, &Session);
+        }
+        ErrOS.flush();
+      });
+    Pool.wait();
+  }
+  if (TranslationCacheStats) {
+    SPIRV::TranslatorSessionStats Stats = Session.getStats();
+    errs() << "Builtin name cache: " << Stats.BuiltinNameHits << " hits, "
+           << Stats.BuiltinNameMisses << " misses\n";
+  }
+
+  unsigned Failed = 0;
+  for (size_t I = 0; I < Inputs.size(); ++I) {
+    errs() << Inputs[I] << ": " << (Results[I] ? "failed" : "ok") << '\n';
+    if (!Diagnostics[I].empty()) {
+      errs() << Diagnostics[I];
+      if (Diagnostics[I].back() != '\n')
+        errs() << '\n';
+    }
+    if (Results[I])
+      ++Failed;
+  }
+  if (Failed) {
+    errs() << Failed << " of " << Inputs.size()
+           << " input files failed to translate\n";
+    return -1;
+  }
+  return 0;
+}
+
+static bool readInputList(const std::string &FileName,
+                          std::vector<std::string> &Inputs) {
+  ErrorOr<std::unique_ptr<MemoryBuffer>> MB =
+      MemoryBuffer::getFileOrSTDIN(FileName);
+  if (!MB) {
+    errs() << "Fails to read input list " << FileName << ": "
+           << MB.getError().message() << '\n';
+    return false;
+  }
+  SmallVector<StringRef, 16> Lines;
+  (*MB)->getBuffer().split(Lines, '\n', -1, false);
+  for (StringRef Line : Lines) {
+    Line = Line.trim();
+    if (!Line.empty())
+      Inputs.push_back(Line.str());
+  }
+  return true;
+}
+
+// Translation server protocol. The client sends one request per connection:
+// the request kind, the translator options and the input bytes. The server
+// replies with the exit code, the diagnostics and the output bytes. Each
+// message is framed by its size; integers are sent in host byte order, as
+// client and server run on the same machine. The global translation flags
+// follow the options, as a server can only translate with its own.
+namespace {
+enum class ServerRequest : uint64_t { ToSPIRV, ToLLVM, Shutdown };
+const uint64_t ServerMagic = 0x3276727370736c6cULL; // "llspsrv2"
+// Larger frames are rejected rather than allocated.
+const uint64_t MaxMessageSize = 1ULL << 30;
+// How long a server waits for the next bytes of a request, so that a stalled
+// client cannot hold a server thread forever.
+const unsigned ServerReceiveTimeout = 30; // seconds
+
+class MessageWriter {
+public:
+  void writeInt(uint64_t V) {
+    Buf.append(reinterpret_cast<const char *>(&V), sizeof(V));
+  }
+  void writeString(StringRef S) {
+    writeInt(S.size());
+    Buf.append(S.begin(), S.end());
+  }
+  const std::string &str() const { return Buf; }
+
+private:
+  std::string Buf;
+};
+
+class MessageReader {
+public:
+  explicit MessageReader(StringRef Buf) : Buf(Buf) {}
+  bool readInt(uint64_t &V) {
+    if (Buf.size() < sizeof(V))
+      return false;
+    std::memcpy(&V, Buf.data(), sizeof(V));
+    Buf = Buf.drop_front(sizeof(V));
+    return true;
+  }
+  bool readString(StringRef &S) {
+    uint64_t Size;
+    if (!readInt(Size) || Buf.size() < Size)
+      return false;
+    S = Buf.take_front(Size);
+    Buf = Buf.drop_front(Size);
+    return true;
+  }
+
+private:
+  StringRef Buf;
+};
+} // namespace
+
+static void writeTranslatorOpts(MessageWriter &W,
+                                const SPIRV::TranslatorOpts &Opts) {
+  W.writeInt(static_cast<uint64_t>(Opts.getMaxVersion()));
+  std::vector<StringRef> Extensions;
+#define EXT(X)                                                                 \
+  if (Opts.isAllowedToUseExtension(ExtensionID::X))                            \
+    Extensions.push_back(#X);
+#include "LLVMSPIRVExtensions.inc"
+#undef EXT
+  W.writeInt(Extensions.size());
+  for (StringRef Ext : Extensions)
+    W.writeString(Ext);
+  W.writeInt(Opts.isSPIRVMemToRegEnabled());
+  W.writeInt(Opts.isGenArgNameMDEnabled());
+  W.writeInt(Opts.getExternalSpecialization().size());
+  for (const auto &SC : Opts.getExternalSpecialization()) {
+    W.writeInt(SC.first);
+    W.writeInt(SC.second);
+  }
+  W.writeInt(static_cast<uint64_t>(Opts.getDesiredBIsRepresentation()));
+  W.writeInt(static_cast<uint64_t>(Opts.getFPContractMode()));
+  W.writeInt(Opts.isSPIRVAllowUnknownIntrinsicsEnabled());
+  SPIRV::TranslatorOpts::ArgList Prefixes =
+      Opts.getSPIRVAllowUnknownIntrinsics();
+  W.writeInt(Prefixes.size());
+  for (StringRef Prefix : Prefixes)
+    W.writeString(Prefix);
+  W.writeInt(Opts.allowExtraDIExpressions());
+  W.writeInt(static_cast<uint64_t>(Opts.getDebugInfoEIS()));
+  W.writeInt(Opts.shouldReplaceLLVMFmulAddWithOpenCLMad());
+  W.writeInt(Opts.shouldSkipDebugInfo());
+  W.writeInt(Opts.isSPIRVTextFormat());
+  W.writeInt(Opts.isErrorMsgSourceInfoEnabled());
+  W.writeInt(static_cast<uint64_t>(Opts.getVerificationLevel()));
+  W.writeInt(Opts.shouldStreamFunctionBodies());
+  W.writeString(Opts.getTranslationCacheDir());
+  W.writeInt(Opts.getTranslationCacheMaxSize());
+}
+
+// Read options written by writeTranslatorOpts. \p Strings keeps the unknown
+// intrinsic prefixes referenced by \p Opts alive.
+static bool readTranslatorOpts(MessageReader &R, SPIRV::TranslatorOpts &Opts,
+                               std::vector<std::string> &Strings) {
+  std::map<StringRef, ExtensionID> ExtensionNamesMap;
+#define EXT(X) ExtensionNamesMap[#X] = ExtensionID::X;
+#include "LLVMSPIRVExtensions.inc"
+#undef EXT
+
+  uint64_t V, Count;
+  StringRef S;
+  if (!R.readInt(V))
+    return false;
+  SPIRV::TranslatorOpts::ExtensionsStatusMap ExtensionsStatus;
+  for (const auto &It : ExtensionNamesMap)
+    ExtensionsStatus[It.second] = false;
+  if (!R.readInt(Count))
+    return false;
+  for (uint64_t I = 0; I < Count; ++I) {
+    if (!R.readString(S))
+      return false;
+    auto It = ExtensionNamesMap.find(S);
+    if (It == ExtensionNamesMap.end())
+      return false;
+    ExtensionsStatus[It->second] = true;
+  }
+  Opts = SPIRV::TranslatorOpts(static_cast<VersionNumber>(V), ExtensionsStatus);
+  if (!R.readInt(V))
+    return false;
+  Opts.setMemToRegEnabled(V);
+  if (!R.readInt(V))
+    return false;
+  Opts.setGenKernelArgNameMDEnabled(V);
+  if (!R.readInt(Count))
+    return false;
+  for (uint64_t I = 0; I < Count; ++I) {
+    uint64_t Id;
+    if (!R.readInt(Id) || !R.readInt(V))
+      return false;
+    Opts.setSpecConst(Id, V);
+  }
+  if (!R.readInt(V))
+    return false;
+  Opts.setDesiredBIsRepresentation(static_cast<SPIRV::BIsRepresentation>(V));
+  if (!R.readInt(V))
+    return false;
+  Opts.setFPContractMode(static_cast<SPIRV::FPContractMode>(V));
+  uint64_t HasPrefixes;
+  if (!R.readInt(HasPrefixes) || !R.readInt(Count))
+    return false;
+  for (uint64_t I = 0; I < Count; ++I) {
+    if (!R.readString(S))
+      return false;
+    Strings.push_back(S.str());
+  }
+  if (HasPrefixes) {
+    SPIRV::TranslatorOpts::ArgList Prefixes;
+    for (const std::string &Prefix : Strings)
+      Prefixes.push_back(Prefix);
+    Opts.setSPIRVAllowUnknownIntrinsics(Prefixes);
+  }
+  if (!R.readInt(V))
+    return false;
+  Opts.setAllowExtraDIExpressionsEnabled(V);
+  if (!R.readInt(V))
+    return false;
+  Opts.setDebugInfoEIS(static_cast<SPIRV::DebugInfoEIS>(V));
+  if (!R.readInt(V))
+    return false;
+  Opts.setReplaceLLVMFmulAddWithOpenCLMad(V);
+  if (!R.readInt(V))
+    return false;
+  Opts.setSkipDebugInfo(V);
+  if (!R.readInt(V))
+    return false;
+  Opts.setSPIRVTextFormat(V);
+  if (!R.readInt(V))
+    return false;
+  Opts.setErrorMsgSourceInfoEnabled(V);
+  if (!R.readInt(V))
+    return false;
+  Opts.setVerificationLevel(static_cast<SPIRV::VerificationLevel>(V));
+  if (!R.readInt(V))
+    return false;
+  Opts.setStreamFunctionBodies(V);
+  if (!R.readString(S) || !R.readInt(V))
+    return false;
+  Opts.setTranslationCacheDir(S.str());
+  Opts.setTranslationCacheMaxSize(V);
+  return true;
+}
+
+// Translate \p Input held in memory, the way convertLLVMToSPIRV and
+// convertSPIRVToLLVM translate files.
+static int translateBuffer(SPIRV::TranslatorSession &Session, bool Reverse,
+                           StringRef Input, std::string &Output,
+                           raw_ostream &ErrOS) {
+  LLVMContext Context;
+  std::string Err;
+  if (!Reverse) {
+    Expected<std::unique_ptr<Module>> M = getOwningLazyBitcodeModule(
+        MemoryBuffer::getMemBuffer(Input, "", false), Context,
+        /*ShouldLazyLoadMetadata=*/true);
+    if (!M) {
+      logAllUnhandledErrors(M.takeError(), ErrOS);
+      return 1;
+    }
+    if (Error E = (*M)->materializeAll()) {
+      logAllUnhandledErrors(std::move(E), ErrOS);
+      return 1;
+    }
+    std::ostringstream OS;
+    if (!Session.writeSpirv(M->get(), OS, Err)) {
+      ErrOS << "Fails to save LLVM as SPIR-V: " << Err << '\n';
+      return -1;
+    }
+    Output = OS.str();
+    return 0;
+  }
+
+  std::istringstream IS(Input.str());
+  Module *RawM;
+  if (!Session.readSpirv(Context, IS, RawM, Err)) {
+    ErrOS << "Fails to load SPIR-V as LLVM Module: " << Err << '\n';
+    return -1;
+  }
+  std::unique_ptr<Module> M(RawM);
+  raw_string_ostream OS(Output);
+  WriteBitcodeToFile(*M, OS);
+  OS.flush();
+  return 0;
+}
+
+#ifdef LLVM_ON_UNIX
+static bool writeAll(int FD, const char *Data, size_t Size) {
+  while (Size) {
+#ifdef MSG_NOSIGNAL
+    ssize_t N = ::send(FD, Data, Size, MSG_NOSIGNAL);
+#else
+    ssize_t N = ::send(FD, Data, Size, 0);
+#endif
+    if (N < 0 && errno == EINTR)
+      continue;
+    if (N <= 0)
+      return false;
+    Data += N;
+    Size -= N;
+  }
+  return true;
+}
+
+static bool readAll(int FD, char *Data, size_t Size) {
+  while (Size) {
+    ssize_t N = ::read(FD, Data, Size);
+    if (N < 0 && errno == EINTR)
+      continue;
+    if (N <= 0)
+      return false;
+    Data += N;
+    Size -= N;
+  }
+  return true;
+}
+
+static bool sendMessage(int FD, StringRef Message) {
+  uint64_t Size = Message.size();
+  return writeAll(FD, reinterpret_cast<const char *>(&Size), sizeof(Size)) &&
+         writeAll(FD, Message.data(), Message.size());
+}
+
+// Receive a message into \p Message. \p TooLarge is set if the message is
+// rejected because its size exceeds MaxMessageSize.
+static bool receiveMessage(int FD, std::string &Message, bool &TooLarge) {
+  uint64_t Size;
+  TooLarge = false;
+  if (!readAll(FD, reinterpret_cast<char *>(&Size), sizeof(Size)))
+    return false;
+  if (Size > MaxMessageSize) {
+    TooLarge = true;
+    return false;
+  }
+  Message.resize(Size);
+  return readAll(FD, &Message[0], Size);
+}
+
+static bool sendResponse(int FD, int Ret, StringRef Diagnostics,
+                         StringRef Output) {
+  MessageWriter W;
+  W.writeInt(static_cast<int64_t>(Ret));
+  W.writeString(Diagnostics);
+  W.writeString(Output);
+  return sendMessage(FD, W.str());
+}
+
+static bool getSocketAddress(const std::string &Path, sockaddr_un &Addr) {
+  std::memset(&Addr, 0, sizeof(Addr));
+  Addr.sun_family = AF_UNIX;
+  if (Path.empty() || Path.size() >= sizeof(Addr.sun_path)) {
+    errs() << "Invalid socket path: " << Path << '\n';
+    return false;
+  }
+  std::memcpy(Addr.sun_path, Path.c_str(), Path.size());
+  return true;
+}
+
+// Connect to the server listening on \p Path. A server which is just being
+// started may not listen yet, so keep trying for a while.
+static int connectToServer(const std::string &Path) {
+  sockaddr_un Addr;
+  if (!getSocketAddress(Path, Addr))
+    return -1;
+  for (unsigned Attempt = 0;; ++Attempt) {
+    int FD = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (FD < 0)
+      break;
+    if (::connect(FD, reinterpret_cast<sockaddr *>(&Addr), sizeof(Addr)) == 0)
+      return FD;
+    int Err = errno;
+    ::close(FD);
+    if ((Err != ENOENT && Err != ECONNREFUSED) || Attempt == 200) {
+      errno = Err;
+      break;
+    }
+    ::usleep(10000);
+  }
+  errs() << "Fails to connect to translation server " << Path << ": "
+         << std::strerror(errno) << '\n';
+  return -1;
+}
+
+namespace {
+// A translator session of the server, together with the strings its options
+// refer to.
+struct ServerSession {
+  std::vector<std::string> Strings;
+  std::unique_ptr<SPIRV::TranslatorSession> Session;
+};
+} // namespace
+
+// Get the session translating requests with options \p Opts, so that the
+// caches of a session are reused by all requests with the same options.
+static std::shared_ptr<ServerSession>
+getServerSession(const SPIRV::TranslatorOpts &Opts,
+                 std::vector<std::string> &Strings) {
+  // Bound the memory used by clients which keep changing their options.
+  const size_t MaxSessions = 64;
+  static std::mutex Lock;
+  static std::map<std::string, std::shared_ptr<ServerSession>> Sessions;
+
+  std::string Key;
+  raw_string_ostream(Key) << Opts.getFingerprint() << ';'
+                          << Opts.isErrorMsgSourceInfoEnabled() << ';'
+                          << static_cast<uint32_t>(Opts.getVerificationLevel())
+                          << ';' << Opts.shouldStreamFunctionBodies() << ';'
+                          << Opts.getTranslationCacheMaxSize() << ';'
+                          << Opts.getTranslationCacheDir();
+  std::lock_guard<std::mutex> Guard(Lock);
+  auto It = Sessions.find(Key);
+  if (It != Sessions.end())
+    return It->second;
+  if (Sessions.size() >= MaxSessions)
+    Sessions.clear();
+  auto S = std::make_shared<ServerSession>();
+  // Moving the vector keeps the strings referred to by Opts in place.
+  S->Strings = std::move(Strings);
+  S->Session.reset(new SPIRV::TranslatorSession(Opts));
+  Sessions[Key] = S;
+  return S;
+}
+
+static void writeTranslationFlags(MessageWriter &W) {
+  std::vector<std::string> Flags = SPIRV::getNonDefaultTranslationFlags();
+  W.writeInt(Flags.size());
+  for (const std::string &Flag : Flags)
+    W.writeString(Flag);
+}
+
+static bool readTranslationFlags(MessageReader &R,
+                                 std::vector<std::string> &Flags) {
+  uint64_t Count;
+  if (!R.readInt(Count))
+    return false;
+  for (uint64_t I = 0; I < Count; ++I) {
+    StringRef Flag;
+    if (!R.readString(Flag))
+      return false;
+    Flags.push_back(Flag.str());
+  }
+  return true;
+}
+
+static std::string joinTranslationFlags(const std::vector<std::string> &Flags) {
+  return Flags.empty() ? std::string("none") : join(Flags, " ");
+}
+
+static void serveRequest(int FD, StringRef Request) {
+  MessageReader R(Request);
+  uint64_t Magic, Kind;
+  SPIRV::TranslatorOpts Opts;
+  std::vector<std::string> Strings;
+  StringRef Input;
+  std::string Output, Diagnostics;
+  raw_string_ostream ErrOS(Diagnostics);
+  std::vector<std::string> ClientFlags;
+  std::vector<std::string> ServerFlags = SPIRV::getNonDefaultTranslationFlags();
+  int Ret = -1;
+  if (!R.readInt(Magic) || Magic != ServerMagic || !R.readInt(Kind) ||
+      !readTranslatorOpts(R, Opts, Strings) ||
+      !readTranslationFlags(R, ClientFlags) || !R.readString(Input)) {
+    ErrOS << "Invalid translation server request\n";
+  } else if (ClientFlags != ServerFlags) {
+    // The flags are global to the server process, so they cannot be changed
+    // for a single request.
+    ErrOS << "Translation flags of the client ("
+          << joinTranslationFlags(ClientFlags)
+          << ") differ from those of the translation server ("
+          << joinTranslationFlags(ServerFlags) << ")\n";
+  } else {
+    // A translation error must fail only its own request rather than exit.
+    Opts.setErrorHandling(SPIRV::SPIRVDbgErrorHandlingKinds::Ignore);
+    std::shared_ptr<ServerSession> S = getServerSession(Opts, Strings);
+    Ret = translateBuffer(*S->Session, Kind == uint64_t(ServerRequest::ToLLVM),
+                          Input, Output, ErrOS);
+  }
+  ErrOS.flush();
+  sendResponse(FD, Ret, Diagnostics, Ret ? "" : Output);
+}
+
+static bool isShutdownRequest(StringRef Request) {
+  MessageReader R(Request);
+  uint64_t Magic, Kind;
+  return R.readInt(Magic) && Magic == ServerMagic && R.readInt(Kind) &&
+         Kind == uint64_t(ServerRequest::Shutdown);
+}
+
+static int runServer(const std::string &Path) {
+  ::signal(SIGPIPE, SIG_IGN);
+  sockaddr_un Addr;
+  if (!getSocketAddress(Path, Addr))
+    return -1;
+  int ListenFD = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (ListenFD < 0) {
+    errs() << "Fails to create socket: " << std::strerror(errno) << '\n';
+    return -1;
+  }
+  bool Bound =
+      ::bind(ListenFD, reinterpret_cast<sockaddr *>(&Addr), sizeof(Addr)) == 0;
+  if (!Bound && errno == EADDRINUSE) {
+    // Reuse the socket left behind by a server which is no longer running.
+    int FD = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    bool IsLive =
+        ::connect(FD, reinterpret_cast<sockaddr *>(&Addr), sizeof(Addr)) == 0;
+    ::close(FD);
+    if (IsLive) {
+      errs() << "A translation server is already listening on " << Path
+             << '\n';
+      ::close(ListenFD);
+      return -1;
+    }
+    ::unlink(Path.c_str());
+    Bound = ::bind(ListenFD, reinterpret_cast<sockaddr *>(&Addr),
+                   sizeof(Addr)) == 0;
+  }
+  if (!Bound || ::listen(ListenFD, SOMAXCONN)) {
+    errs() << "Fails to listen on " << Path << ": " << std::strerror(errno)
+           << '\n';
+    ::close(ListenFD);
+    return -1;
+  }
+
+  // Requests are received and served concurrently, so that a slow or broken
+  // client does not stop the server from accepting connections. The static
+  // tables of the translator stay initialized for the whole lifetime of the
+  // server.
+  ThreadPool Pool(hardware_concurrency(Jobs));
+  std::atomic<bool> Stop(false);
+  while (!Stop) {
+    // Wake up regularly to notice a shutdown request served by the pool.
+    pollfd Listen = {ListenFD, POLLIN, 0};
+    int Ready = ::poll(&Listen, 1, 100);
+    if (Ready < 0 && errno != EINTR) {
+      errs() << "Fails to wait for connections: " << std::strerror(errno)
+             << '\n';
+      break;
+    }
+    if (Ready <= 0)
+      continue;
+    int FD = ::accept(ListenFD, nullptr, nullptr);
+    if (FD < 0) {
+      if (errno == EINTR || errno == ECONNABORTED || errno == EAGAIN)
+        continue;
+      errs() << "Fails to accept connection: " << std::strerror(errno)
+             << '\n';
+      break;
+    }
+    timeval Timeout = {ServerReceiveTimeout, 0};
+    ::setsockopt(FD, SOL_SOCKET, SO_RCVTIMEO, &Timeout, sizeof(Timeout));
+    Pool.async([FD, &Stop] {
+      std::string Request;
+      bool TooLarge;
+      if (!receiveMessage(FD, Request, TooLarge)) {
+        if (TooLarge)
+          sendResponse(FD, -1,
+                       "Translation server request exceeds " +
+                           std::to_string(MaxMessageSize) + " bytes\n",
+                       "");
+      } else if (isShutdownRequest(Request)) {
+        sendResponse(FD, 0, "", "");
+        Stop = true;
+      } else {
+        serveRequest(FD, Request);
+      }
+      ::close(FD);
+    });
+  }
+  Pool.wait();
+  ::close(ListenFD);
+  ::unlink(Path.c_str());
+  return 0;
+}
+
+// Send the translation of InputFile to the server listening on \p Path and
+// write the result as a local translation would.
+static int translateOnServer(const SPIRV::TranslatorOpts &Opts,
+                             const std::string &Path) {
+  MessageWriter W;
+  W.writeInt(ServerMagic);
+  if (ServerShutdown) {
+    W.writeInt(uint64_t(ServerRequest::Shutdown));
+  } else {
+    ErrorOr<std::unique_ptr<MemoryBuffer>> MB =
+        MemoryBuffer::getFileOrSTDIN(InputFile);
+    if (!MB) {
+      errs() << "Fails to read " << InputFile << ": "
+             << MB.getError().message() << '\n';
+      return -1;
+    }
+    W.writeInt(uint64_t(IsReverse ? ServerRequest::ToLLVM
+                                  : ServerRequest::ToSPIRV));
+    writeTranslatorOpts(W, Opts);
+    writeTranslationFlags(W);
+    W.writeString((*MB)->getBuffer());
+    if (W.str().size() > MaxMessageSize) {
+      errs() << "Input file is too large for the translation server\n";
+      return -1;
+    }
+  }
+
+  int FD = connectToServer(Path);
+  if (FD < 0)
+    return -1;
+  std::string Response;
+  bool TooLarge;
+  bool Received =
+      sendMessage(FD, W.str()) && receiveMessage(FD, Response, TooLarge);
+  ::close(FD);
+  MessageReader R(Response);
+  uint64_t Ret;
+  StringRef Diagnostics, Output;
+  if (!Received || !R.readInt(Ret) || !R.readString(Diagnostics) ||
+      !R.readString(Output)) {
+    errs() << "Invalid response from translation server " << Path << '\n';
+    return -1;
+  }
+  errs() << Diagnostics;
+  if (Ret || ServerShutdown)
+    return static_cast<int>(Ret);
+
+  if (OutputFile.empty()) {
+    if (InputFile == "-")
+      OutputFile = "-";
+    else if (IsReverse)
+      OutputFile = removeExt(InputFile) + kExt::LLVMBinary;
+    else
+      OutputFile =
+          removeExt(InputFile) +
+          (Opts.isSPIRVTextFormat() ? kExt::SpirvText : kExt::SpirvBinary);
+  }
+  std::error_code EC;
+  ToolOutputFile Out(OutputFile.c_str(), EC, sys::fs::F_None);
+  if (EC) {
+    errs() << "Fails to open output file: " << EC.message();
+    return -1;
+  }
+  Out.os() << Output;
+  Out.keep();
+  return 0;
+}
+#else
+static int runServer(const std::string &) {
+  errs() << "-serve is not supported on this host\n";
+  return -1;
+}
+
+static int translateOnServer(const SPIRV::TranslatorOpts &,
+                             const std::string &) {
+  errs() << "-client is not supported on this host\n";
+  return -1;
+}
+#endif
+
 static int parseSPVExtOption(
     SPIRV::TranslatorOpts::ExtensionsStatusMap &ExtensionsStatus) {
   // Map name -> id for known extensions
@@ -554,6 +1619,34 @@ static void parseAllowUnknownIntrinsicsOpt(SPIRV::TranslatorOpts &Opts) {
   Opts.setSPIRVAllowUnknownIntrinsics(PrefixList);
 }
 
+// Translate the input file in the direction given by -r and write the
+// collected statistics to -translation-stats-json.
+static int convertWithStats(const SPIRV::TranslatorOpts &Opts) {
+  SPIRV::TranslationStats Stats;
+  int Ret = IsReverse ? convertSPIRVToLLVM(Opts, InputFile, OutputFile, errs(),
+                                           nullptr, &Stats)
+                      : convertLLVMToSPIRV(Opts, InputFile, OutputFile, errs(),
+                                           nullptr, &Stats);
+  if (Ret != 0)
+    return Ret;
+  std::ofstream OFS(StatsJsonFile);
+  Stats.dumpJSON(OFS);
+  if (!OFS) {
+    errs() << "Fails to write statistics to " << StatsJsonFile << '\n';
+    return -1;
+  }
+  return 0;
+}
+
+static int reportTranslationCacheStats(int Ret) {
+  if (TranslationCacheStats) {
+    SPIRV::TranslationCacheStats Stats = SPIRV::getTranslationCacheStats();
+    errs() << "Translation cache: " << Stats.Hits << " hits, " << Stats.Misses
+           << " misses\n";
+  }
+  return Ret;
+}
+
 int main(int Ac, char **Av) {
   EnablePrettyStackTrace();
   sys::PrintStackTraceOnErrorSignal(Av[0]);
@@ -561,7 +1654,46 @@ int main(int Ac, char **Av) {
 
   cl::ParseCommandLineOptions(Ac, Av, "LLVM/SPIR-V translator");
 
-  if (InputFile != "-" && isFileEmpty(InputFile)) {
+  if (!ServeSocket.empty()) {
+    if (!ClientSocket.empty()) {
+      errs() << "Cannot use -serve with -client\n";
+      return -1;
+    }
+    return runServer(ServeSocket);
+  }
+
+  // More than one input file (or an input list) selects batch translation,
+  // unless the inputs are to be linked.
+  std::vector<std::string> BatchInputs;
+  bool IsBatch = !IsLink && (!LinkInputFiles.empty() || !InputListFile.empty());
+  if (IsBatch) {
+    if (InputFile.getNumOccurrences() != 0)
+      BatchInputs.push_back(InputFile);
+    BatchInputs.insert(BatchInputs.end(), LinkInputFiles.begin(),
+                       LinkInputFiles.end());
+    if (!InputListFile.empty() && !readInputList(InputListFile, BatchInputs))
+      return -1;
+    bool IsTextConversion = false;
+#ifdef _SPIRV_SUPPORT_TEXT_FMT
+    IsTextConversion = ToText || ToBinary;
+#endif
+    if (IsRegularization || IsSpecialization || SpecConstInfo ||
+        SPIRVModuleInfo || IsTextConversion) {
+      errs() << "Only translation and -link accept more than one input file\n";
+      return -1;
+    }
+    if (!OutputFile.empty() || !DebugSidecarFile.empty()) {
+      errs() << "Cannot use -o, -spirv-debug-sidecar with more than one input "
+                "file\n";
+      return -1;
+    }
+    if (!SpecConst.empty()) {
+      errs() << "Cannot use -spec-const with more than one input file\n";
+      return -1;
+    }
+  }
+
+  if (!IsBatch && InputFile != "-" && isFileEmpty(InputFile)) {
     errs() << "Can't translate, file is empty\n";
     return -1;
   }
@@ -585,11 +1717,15 @@ int main(int Ac, char **Av) {
 
   Opts.setFPContractMode(FPCMode);
 
+#ifdef _SPIRV_SUPPORT_TEXT_FMT
+  Opts.setSPIRVTextFormat(UseTextFormat);
+#endif
+
   if (SPIRVMemToReg)
     Opts.setMemToRegEnabled(SPIRVMemToReg);
   if (SPIRVGenKernelArgNameMD)
     Opts.setGenKernelArgNameMDEnabled(SPIRVGenKernelArgNameMD);
-  if (IsReverse && !SpecConst.empty()) {
+  if ((IsReverse || IsSpecialization) && !SpecConst.empty()) {
     if (parseSpecConstOpt(SpecConst, Opts))
       return -1;
   }
@@ -627,6 +1763,131 @@ int main(int Ac, char **Av) {
     }
   }
 
+  if (SPIRVSkipDebugInfo.getNumOccurrences() != 0) {
+    if (!IsReverse) {
+      errs() << "Note: --spirv-skip-debug-info option ignored as it only "
+                "affects translation from SPIR-V to LLVM IR\n";
+    } else {
+      Opts.setSkipDebugInfo(SPIRVSkipDebugInfo);
+    }
+  }
+
+  Opts.setVerificationLevel(Verification);
+  Opts.setStreamFunctionBodies(StreamFunctionBodies);
+
+  if (!TranslationCacheDir.empty())
+    Opts.setTranslationCacheDir(TranslationCacheDir);
+  if (TranslationCacheMaxSize.getNumOccurrences() != 0)
+    Opts.setTranslationCacheMaxSize(TranslationCacheMaxSize);
+
+  // Modules are traced by the thread which destroys them, so the stream is
+  // only set for translations done on the main thread.
+  std::ofstream TraceOFS;
+  if (!TraceFile.empty()) {
+    if (!SPIRV::isSpirvTraceEnabled()) {
+      errs() << "-spirv-trace requires llvm-spirv built with "
+                "LLVM_SPIRV_ENABLE_TRACE\n";
+      return -1;
+    }
+    if (IsBatch || NumShards.getNumOccurrences() != 0 ||
+        !ClientSocket.empty()) {
+      errs() << "Cannot use -spirv-trace with multiple input files, -shards, "
+                "-client\n";
+      return -1;
+    }
+    TraceOFS.open(TraceFile);
+    if (!TraceOFS) {
+      errs() << "Fails to open " << TraceFile << '\n';
+      return -1;
+    }
+    SPIRV::setSpirvTraceStream(&TraceOFS);
+  }
+
+  if (!DebugSidecarFile.empty() && (IsReverse || IsRegularization)) {
+    errs() << "Cannot use -spirv-debug-sidecar with -r, -s\n";
+    return -1;
+  }
+
+  if (SplitMode.getNumOccurrences() != 0) {
+    bool IsTextConversion = false;
+#ifdef _SPIRV_SUPPORT_TEXT_FMT
+    IsTextConversion = ToText || ToBinary;
+#endif
+    if (IsBatch || IsLink || IsReverse || IsRegularization ||
+        IsSpecialization || SpecConstInfo || SPIRVModuleInfo ||
+        IsTextConversion) {
+      errs() << "-split is only supported for translation of a single LLVM "
+                "bitcode file\n";
+      return -1;
+    }
+    if (!ClientSocket.empty() || !DebugSidecarFile.empty() ||
+        !StatsJsonFile.empty()) {
+      errs() << "Cannot use -split with -client, -spirv-debug-sidecar, "
+                "-translation-stats-json\n";
+      return -1;
+    }
+    return splitLLVMToSPIRV(Opts);
+  }
+
+  if (NumShards.getNumOccurrences() != 0) {
+    bool IsTextConversion = false;
+#ifdef _SPIRV_SUPPORT_TEXT_FMT
+    IsTextConversion = ToText || ToBinary;
+#endif
+    if (!IsReverse || IsBatch || IsLink || IsRegularization ||
+        IsSpecialization || SpecConstInfo || SPIRVModuleInfo ||
+        IsTextConversion) {
+      errs() << "-shards is only supported for translation of a single "
+                "SPIR-V file with -r\n";
+      return -1;
+    }
+    if (!ClientSocket.empty() || !StatsJsonFile.empty()) {
+      errs() << "Cannot use -shards with -client, -translation-stats-json\n";
+      return -1;
+    }
+    return shardSPIRVToLLVM(Opts);
+  }
+
+  if (!StatsJsonFile.empty()) {
+    bool IsTextConversion = false;
+#ifdef _SPIRV_SUPPORT_TEXT_FMT
+    IsTextConversion = ToText || ToBinary;
+#endif
+    if (IsBatch || IsLink || IsRegularization || IsSpecialization ||
+        SpecConstInfo || SPIRVModuleInfo || IsTextConversion) {
+      errs() << "-translation-stats-json is only supported for translation of "
+                "a single input file\n";
+      return -1;
+    }
+    if (!ClientSocket.empty() || !DebugSidecarFile.empty()) {
+      errs() << "Cannot use -translation-stats-json with -client, "
+                "-spirv-debug-sidecar\n";
+      return -1;
+    }
+  }
+
+  if (!ClientSocket.empty()) {
+    bool IsTextConversion = false;
+#ifdef _SPIRV_SUPPORT_TEXT_FMT
+    IsTextConversion = ToText || ToBinary;
+#endif
+    if (IsBatch || IsLink || IsRegularization || IsSpecialization ||
+        SpecConstInfo || SPIRVModuleInfo || IsTextConversion ||
+        !DebugSidecarFile.empty()) {
+      errs() << "Only translation of a single input file can be done by a "
+                "translation server\n";
+      return -1;
+    }
+    return translateOnServer(Opts, ClientSocket);
+  }
+  if (ServerShutdown) {
+    errs() << "-serve-shutdown requires -client\n";
+    return -1;
+  }
+
+  if (IsBatch)
+    return reportTranslationCacheStats(convertBatch(Opts, BatchInputs));
+
 #ifdef _SPIRV_SUPPORT_TEXT_FMT
   if (ToText && (ToBinary || IsReverse || IsRegularization)) {
     errs() << "Cannot use -to-text with -to-binary, -r, -s\n";
@@ -642,19 +1903,85 @@ int main(int Ac, char **Av) {
     return convertSPIRV();
 #endif
 
-  if (!IsReverse && !IsRegularization && !SpecConstInfo)
-    return convertLLVMToSPIRV(Opts);
+  if (IsLink && (IsReverse || IsRegularization || IsSpecialization ||
+                 SpecConstInfo)) {
+    errs() << "Cannot use -link with -r, -s, -specialize, -spec-const-info\n";
+    return -1;
+  }
+  if (IsLink)
+    return linkSPIRV();
+
+  if (IsSpecialization && (IsReverse || IsRegularization || SpecConstInfo)) {
+    errs() << "Cannot use -specialize with -r, -s, -spec-const-info\n";
+    return -1;
+  }
+  if (IsSpecialization)
+    return specializeSPIRV(Opts);
+
+  if (!StatsJsonFile.empty())
+    return reportTranslationCacheStats(convertWithStats(Opts));
+
+  if (!IsReverse && !IsRegularization && !SpecConstInfo && !SPIRVModuleInfo)
+    return reportTranslationCacheStats(
+        convertLLVMToSPIRV(Opts, InputFile, OutputFile, errs()));
 
   if (IsReverse && IsRegularization) {
     errs() << "Cannot have both -r and -s options\n";
     return -1;
   }
   if (IsReverse)
-    return convertSPIRVToLLVM(Opts);
+    return reportTranslationCacheStats(
+        convertSPIRVToLLVM(Opts, InputFile, OutputFile, errs()));
 
   if (IsRegularization)
     return regularizeLLVM(Opts);
 
+  if (SPIRVModuleInfo) {
+    std::ifstream IFS(InputFile, std::ios::binary);
+    SpirvModuleInfo Info;
+    if (!getSpirvModuleInfo(IFS, Info)) {
+      errs() << "Invalid SPIR-V binary\n";
+      return -1;
+    }
+    std::cout << "Capabilities:";
+    for (auto Cap : Info.Capabilities)
+      std::cout << " " << Cap;
+    std::cout << "\nExtensions:";
+    for (auto &Ext : Info.Extensions)
+      std::cout << " " << Ext;
+    std::cout << "\nNumber of kernels in the module = " << Info.Kernels.size()
+              << "\n";
+    for (auto &K : Info.Kernels) {
+      std::cout << "Kernel " << K.Name << "\n";
+      if (K.ReqdWorkGroupSize[0])
+        std::cout << "  reqd_work_group_size = " << K.ReqdWorkGroupSize[0]
+                  << " " << K.ReqdWorkGroupSize[1] << " "
+                  << K.ReqdWorkGroupSize[2] << "\n";
+      if (K.SubgroupSize)
+        std::cout << "  subgroup size = " << K.SubgroupSize << "\n";
+      for (auto &Mode : K.ExecutionModes) {
+        std::cout << "  execution mode " << Mode.first << ":";
+        for (auto L : Mode.second)
+          std::cout << " " << L;
+        std::cout << "\n";
+      }
+      for (size_t I = 0; I != K.Args.size(); ++I) {
+        auto &A = K.Args[I];
+        std::cout << "  arg " << I << ": name = \"" << A.Name
+                  << "\", type = \"" << A.TypeName
+                  << "\", type opcode = " << A.TypeOpCode;
+        if (A.StorageClass != ~0U)
+          std::cout << ", storage class = " << A.StorageClass;
+        if (A.AccessQualifier != ~0U)
+          std::cout << ", access qualifier = " << A.AccessQualifier;
+        for (auto Attr : A.Attributes)
+          std::cout << ", attribute = " << Attr;
+        std::cout << "\n";
+      }
+    }
+    return 0;
+  }
+
   if (SpecConstInfo) {
     std::ifstream IFS(InputFile, std::ios::binary);
     std::vector<SpecConstInfoTy> SpecConstInfo;